@@ -18,11 +18,12 @@
 #ifndef COMMON_H
 #define COMMON_H
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cmath>
 #include <cstdlib>
 #include <hip/hip_runtime.h>
-#include <nvml.h>
 #include <float.h>
 #include <iomanip>
 #include <iostream>
@@ -42,12 +43,81 @@ const unsigned long long defaultBufferSize = 64; // 64MB
 const unsigned int defaultAverageLoopCount = 3;
 const unsigned int _MiB = 1024 * 1024;
 const unsigned int numThreadPerBlock = 512;
+const unsigned int defaultMaxStreams = 8;
+const unsigned int defaultMaxSamples = 100;
+const double defaultMaxSampleTime = 10.0; // seconds
+// Samples always taken in adaptive mode before the confidence interval is trusted
+const unsigned int adaptiveMinSamples = 3;
 
 extern int deviceCount;
 extern unsigned int averageLoopCount;
+// Adaptive sampling: relative 95% confidence interval half-width to reach, 0 takes averageLoopCount samples instead,
+// with the largest number of samples and seconds spent sampling one measurement
+extern double targetPrecision;
+extern unsigned int maxSamples;
+extern double maxSampleTime;
 extern bool disableAffinity;
 extern bool skipVerification;
 extern bool useMean;
+// Pick the fastest SM copy kernel instantiation per device, link type and copy size
+extern bool smAutotune;
+// Replay the copies of each sample as a captured hipGraph instead of enqueuing them one by one
+extern bool useGraphs;
+// Time every copy of a sample with its own event, to report the distribution of single copy times
+extern bool perIterationTiming;
+// Enqueue the simultaneous copies of each context from its own worker thread
+extern bool parallelEnqueue;
+// Largest number of concurrent streams per device measured by the stream scaling testcases
+extern unsigned int maxStreams;
+// Chunk sizes in bytes of the pipelined testcases, in ascending order
+extern std::vector<unsigned long long> pipelineChunkSizes;
+// Threads sharing each word in the atomic throughput testcases, one matrix per level
+extern std::vector<unsigned int> atomicContention;
+#ifdef ROCM_SMI
+// Sample the ROCm SMI counters of the measured devices around the timed section of every sample
+extern bool sampleCounters;
+#endif
+
+// Kind of host memory allocated by HostNodes
+enum HostMemType {
+    HOST_MEM_PINNED,        // hipHostAlloc, portable pinned memory
+    HOST_MEM_REGISTERED,    // page aligned malloc'd memory pinned with hipHostRegister
+    HOST_MEM_PAGEABLE,      // plain malloc'd memory, copies are staged by the runtime and kernels can't access it
+    HOST_MEM_COHERENT,      // hipHostMalloc fine grained memory
+    HOST_MEM_NONCOHERENT,   // hipHostMalloc coarse grained memory
+    HOST_MEM_MANAGED,       // hipMallocManaged memory
+    HOST_MEM_HSA            // fine grained system memory pool of the HSA CPU agent, the default of --backend hsa
+};
+extern HostMemType hostMemType;
+const std::vector<std::string> hostMemTypeNames = {"pinned", "registered", "pageable", "coherent", "noncoherent", "managed", "hsa"};
+// Copy path of the CE testcases. ROCm picks SDMA engines or blit kernels per copy by default
+enum CeCopyPath {
+    CE_PATH_DEFAULT,    // whatever the runtime picks
+    CE_PATH_SDMA,       // hipMemcpyDeviceToDeviceNoCU copies, always on SDMA engines
+    CE_PATH_BLIT        // SDMA disabled for the process with HSA_ENABLE_SDMA=0, every copy is a blit kernel
+};
+extern CeCopyPath ceCopyPath;
+const std::vector<std::string> ceCopyPathNames = {"default", "sdma", "blit"};
+// Runtime issuing the copies of the CE testcases
+enum CopyBackend {
+    BACKEND_HIP,        // hipMemcpyAsync on HIP streams
+    BACKEND_HSA         // hsa_amd_memory_async_copy chained with HSA signals, without the HIP stream layer
+};
+extern CopyBackend copyBackend;
+const std::vector<std::string> copyBackendNames = {"hip", "hsa"};
+// SDMA engine of the HSA backend copies, -1 lets the runtime pick one
+extern int sdmaEngine;
+// Kernel keeping the device busy while the interference testcases measure copies
+enum BackgroundLoadType {
+    LOAD_HBM,           // reads and writes streamed over a device buffer larger than the caches
+    LOAD_ALU,           // dependent FMA chains in registers, without memory traffic
+    LOAD_OCCUPANCY      // one block per CU holding most of its LDS, like a large tile GEMM
+};
+// Background loads of the interference testcases, one matrix row each
+extern std::vector<BackgroundLoadType> backgroundLoads;
+const std::vector<std::string> backgroundLoadNames = {"hbm", "alu", "occupancy"};
+// Copy sizes in bytes measured by every testcase when --sweep is used, in ascending order
+extern std::vector<unsigned long long> sweepSizes;
 // Verbosity
 extern bool verbose;
 class Verbosity {
@@ -108,57 +178,83 @@ inline size_t getFirstEnabledCPU() {
 }
 
 // Calculation and display of performance statistics
-// Basic online running statistics calculator, modeled after a less templated
-// version of boost::accumulators.
+// Running mean and variance are updated online (Welford), samples are kept unsorted and only sorted
+// when an order statistic is asked for, so recording is O(1) even for millions of samples.
 class PerformanceStatistic {
-    std::vector<double> values;
+    mutable std::vector<double> values;
+    mutable bool sorted = true;
+    double runningMean = 0.0;
+    double runningM2 = 0.0;
+    double minValue = 0.0;
+    double maxValue = 0.0;
+
+    void sort() const {
+        if (!sorted) {
+            std::sort(values.begin(), values.end());
+            sorted = true;
+        }
+    }
 
 public:
     void operator()(const double &sample) { recordSample(sample); }
     
     void recordSample(const double &sample) {
-        auto it = std::lower_bound(values.begin(), values.end(), sample);
-        values.insert(it, sample);
+        if (values.empty()) {
+            minValue = maxValue = sample;
+        }
+        minValue = std::min(minValue, sample);
+        maxValue = std::max(maxValue, sample);
+        values.push_back(sample);
+        sorted = values.size() == 1;
+
+        double delta = sample - runningMean;
+        runningMean += delta / values.size();
+        runningM2 += delta * (sample - runningMean);
     }
 
-    void reset(void) { values.clear(); }
-    
-    double sum(void) const { 
-        double total = 0.0;
-        for (double val : values) {
-            total += val;
-        }
-        return total;
+    void reset(void) {
+        values.clear();
+        sorted = true;
+        runningMean = runningM2 = minValue = maxValue = 0.0;
     }
     
+    double sum(void) const { return runningMean * values.size(); }
+    
     size_t count(void) const { return values.size(); }
     
-    double mean(void) const { 
-        return sum() / count();
-    }
+    double mean(void) const { return runningMean; }
     
     double variance(void) const {
-        double calculated_mean = mean();
-        double sum_diff_squared = 0.0;
-        for (double val : values) {
-            double diff = val - calculated_mean;
-            sum_diff_squared += diff * diff;
-        }
-        return (values.size() > 1 ? sum_diff_squared / (values.size() - 1) : 0.0);
+        return (values.size() > 1 ? runningM2 / (values.size() - 1) : 0.0);
     }
     
     double stddev(void) const {
         return (variance() > 0.0 ? std::sqrt(variance()) : 0.0);
     }
     
-    double largest(void) const { return values.size() > 0 ? values[values.size() - 1] : 0.0; }
+    double largest(void) const { return maxValue; }
     
-    double smallest(void) const { return values.size() > 0 ? values[0] : 0.0; }
+    double smallest(void) const { return minValue; }
+
+    // Recorded samples, in no particular order
+    const std::vector<double> &samples(void) const { return values; }
+
+    // Nearest rank percentile, p in [0, 100]
+    double percentile(double p) const {
+        if (values.size() == 0) {
+            return 0.0;
+        }
+        sort();
+        size_t rank = (size_t)std::ceil(p / 100.0 * values.size());
+        return values[std::min(std::max(rank, (size_t)1), values.size()) - 1];
+    }
 
     double median(void) const {
         if (values.size() == 0) {
             return 0.0;
-        } else if (values.size() % 2 == 0) {
+        }
+        sort();
+        if (values.size() % 2 == 0) {
             int idx = values.size() / 2;
             return (values[idx] + values[idx - 1]) / 2.0;
         } else {
@@ -173,12 +269,122 @@ public:
             return median();
         }
     }
+
+    // Half-width of the 95% confidence interval of the mean relative to the mean, from the Student t distribution.
+    // Infinite until there are two samples, the median's interval is close to it for the near normal samples of a link.
+    double relativeCiHalfWidth(void) const {
+        // two sided 95% critical values for 1 to 30 degrees of freedom
+        static const double tCritical[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                           2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                                           2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+        size_t n = values.size();
+        if (n < 2 || runningMean == 0.0) {
+            return INFINITY;
+        }
+        double t = n - 1 <= 30 ? tCritical[n - 2] : 1.96;
+        return t * stddev() / std::sqrt((double)n) / std::fabs(runningMean);
+    }
+};
+
+// Decides when a measurement has enough samples: after averageLoopCount of them, or in adaptive mode once the
+// relative confidence interval of the statistic is below targetPrecision, within maxSamples and maxSampleTime
+class SampleBudget {
+    std::chrono::steady_clock::time_point start;
+public:
+    SampleBudget() : start(std::chrono::steady_clock::now()) {}
+
+    bool needsMore(const PerformanceStatistic &stat) const {
+        if (targetPrecision <= 0.0) {
+            return stat.count() < averageLoopCount;
+        }
+        if (stat.count() < adaptiveMinSamples) {
+            return true;
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        if (stat.count() >= maxSamples || elapsed.count() >= maxSampleTime) {
+            return false;
+        }
+        return stat.relativeCiHalfWidth() > targetPrecision;
+    }
+};
+
+// HDR style histogram of durations in nanoseconds: exact below 128ns, then 64 linear sub-buckets per power of two,
+// so percentiles are within 1/64 of the recorded values with a few KiB of counters, whatever the number of samples
+class TimingHistogram {
+    static const int subBucketBits = 6;
+    std::vector<unsigned long long> counts;
+    unsigned long long total = 0;
+    double sumNs = 0.0;
+    unsigned long long minNs = ULLONG_MAX;
+    unsigned long long maxNs = 0;
+
+    static size_t bucketIndex(unsigned long long ns) {
+        if (ns < (2ull << subBucketBits)) {
+            return ns;
+        }
+        int shift = 63 - __builtin_clzll(ns) - subBucketBits;
+        return ((size_t)shift << subBucketBits) + (ns >> shift);
+    }
+
+    // middle of the range of values counted in the bucket
+    static double bucketValue(size_t index) {
+        if (index < (2ull << subBucketBits)) {
+            return (double)index;
+        }
+        int shift = (int)(index >> subBucketBits) - 1;
+        unsigned long long low = (index - ((size_t)shift << subBucketBits)) << shift;
+        return (double)low + (double)((1ull << shift) - 1) / 2.0;
+    }
+
+public:
+    void recordNs(unsigned long long ns) {
+        size_t index = bucketIndex(ns);
+        if (index >= counts.size()) {
+            counts.resize(index + 1);
+        }
+        counts[index]++;
+        total++;
+        sumNs += (double)ns;
+        minNs = std::min(minNs, ns);
+        maxNs = std::max(maxNs, ns);
+    }
+
+    void reset(void) {
+        counts.clear();
+        total = 0;
+        sumNs = 0.0;
+        minNs = ULLONG_MAX;
+        maxNs = 0;
+    }
+
+    unsigned long long count(void) const { return total; }
+    double meanNs(void) const { return total ? sumNs / total : 0.0; }
+    double smallestNs(void) const { return total ? (double)minNs : 0.0; }
+    double largestNs(void) const { return (double)maxNs; }
+
+    // Nearest rank percentile, p in [0, 100]
+    double percentileNs(double p) const {
+        if (total == 0) {
+            return 0.0;
+        }
+        unsigned long long rank = std::max((unsigned long long)std::ceil(p / 100.0 * total), 1ull);
+        unsigned long long seen = 0;
+        for (size_t index = 0; index < counts.size(); index++) {
+            seen += counts[index];
+            if (seen >= rank) {
+                return std::clamp(bucketValue(index), (double)minNs, (double)maxNs);
+            }
+        }
+        return (double)maxNs;
+    }
 };
 
 template <class T> struct PeerValueMatrix {
     std::optional <T> *m_matrix;
     int m_rows, m_columns;
     std::string key;
+    // Printed instead of the row and column indices when set, for matrices not indexed by device
+    std::vector<std::string> rowLabels, columnLabels;
 
     PeerValueMatrix(int rows, int columns, std::string key = ""): m_matrix(new std::optional <T>[rows * columns]()), m_rows(rows), m_columns(columns), key(key) {}
 
@@ -203,13 +409,23 @@ std::ostream &operator<<(std::ostream &o, const PeerValueMatrix<T> &matrix) {
     T sum = 0;
     int count = 0;
 
-    o << ' ';
+    size_t rowLabelWidth = 1;
+    for (const std::string &label : matrix.rowLabels) {
+        rowLabelWidth = std::max(rowLabelWidth, label.size());
+    }
+
+    o << std::string(rowLabelWidth, ' ');
     for (int currentDevice = 0; currentDevice < matrix.m_columns; currentDevice++) {
-        o << std::setw(10) << currentDevice;
+        if (matrix.columnLabels.empty()) {
+            o << std::setw(10) << currentDevice;
+        } else {
+            o << std::setw(10) << matrix.columnLabels[currentDevice];
+        }
     }
     o << std::endl;
     for (int currentDevice = 0; currentDevice < matrix.m_rows; currentDevice++) {
-        o << currentDevice;
+        std::string rowLabel = matrix.rowLabels.empty() ? std::to_string(currentDevice) : matrix.rowLabels[currentDevice];
+        o << rowLabel << std::string(rowLabelWidth - std::min(rowLabelWidth, rowLabel.size()), ' ');
         for (int peer = 0; peer < matrix.m_columns; peer++) {
             std::optional <T> val = matrix.value(currentDevice, peer);
             if (val) {
@@ -247,46 +463,15 @@ inline void CU_ASSERT(hipError_t cuResult, const char *msg = nullptr) {
   }
 }
 
-// NVML Error handling
-inline void NVML_ASSERT(nvmlReturn_t nvmlResult, const char *msg = nullptr) {
-    if (nvmlResult != NVML_SUCCESS) {
-        std::cout << "NVML_ERROR: [" << nvmlErrorString(nvmlResult) << "]";
-        if (msg != nullptr) std::cout << ":\n\t" << msg;
-        std::cout << std::endl;
-        std::exit(1);
-    }
-}
-
-// NUMA optimal affinity
-inline void setOptimalCpuAffinity(int cudaDeviceID) {
-#ifdef _WIN32
-    // NVML doesn't support setting affinity on Windows
-    return;
-#endif
-    if (disableAffinity) {
-        return;
-    }
-
-    nvmlDevice_t device;
-    hipUUID dev_uuid;
-
-    std::stringstream s;
-    std::unordered_set <unsigned char> dashPos {0, 4, 6, 8, 10};
-
-    CU_ASSERT(hipDeviceGetUuid(&dev_uuid, cudaDeviceID));
-
-    s << "GPU";
-    for (int i = 0; i < 16; i++) {
-        if (dashPos.count(i)) {
-            s << '-';
-        }
-        s << std::hex << std::setfill('0') << std::setw(2) << (0xFF & (int)dev_uuid.bytes[i]);
-    }
-
-    NVML_ASSERT(nvmlDeviceGetHandleByUUID(s.str().c_str(), &device));
-    nvmlReturn_t result = nvmlDeviceSetCpuAffinity(device);
-    if (result != NVML_ERROR_NOT_SUPPORTED) {
-        NVML_ASSERT(result);
+// Name of a link type reported by hipExtGetLinkTypeAndHopCount (hsa_amd_link_info_type_t)
+inline std::string linkTypeName(uint32_t linkType) {
+    switch (linkType) {
+        case 0: return "HyperTransport";
+        case 1: return "QPI";
+        case 2: return "PCIe";
+        case 3: return "InfiniBand";
+        case 4: return "XGMI";
+        default: return "unknown";
     }
 }
 
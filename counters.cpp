@@ -0,0 +1,230 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifdef ROCM_SMI
+
+#include <hip/hip_runtime.h>
+#include <cstdio>
+#include <iomanip>
+#include <sstream>
+#include <rocm_smi/rocm_smi.h>
+
+#include "common.h"
+#include "counters.h"
+
+// ROCm SMI index of each HIP device, matched by PCI location since the two orders can differ
+static std::map<int, uint32_t> smiDevices;
+static bool countersInitialized = false;
+
+bool initCounters() {
+    if (countersInitialized) {
+        return true;
+    }
+    rsmi_status_t status = rsmi_init(0);
+    if (status != RSMI_STATUS_SUCCESS) {
+        const char *statusStr = "unknown error";
+        rsmi_status_string(status, &statusStr);
+        std::cout << "NOTE: ROCm SMI is unavailable, counters won't be sampled: " << statusStr << std::endl;
+        return false;
+    }
+    countersInitialized = true;
+
+    uint32_t smiCount = 0;
+    std::map<uint64_t, uint32_t> bdfIds;
+    if (rsmi_num_monitor_devices(&smiCount) == RSMI_STATUS_SUCCESS) {
+        for (uint32_t smiDevice = 0; smiDevice < smiCount; smiDevice++) {
+            uint64_t bdfId;
+            if (rsmi_dev_pci_id_get(smiDevice, &bdfId) == RSMI_STATUS_SUCCESS) {
+                bdfIds[bdfId] = smiDevice;
+            }
+        }
+    }
+    for (int deviceId = 0; deviceId < deviceCount; deviceId++) {
+        char busId[32];
+        unsigned int domain, bus, device, function;
+        CU_ASSERT(hipDeviceGetPCIBusId(busId, sizeof(busId), deviceId));
+        if (sscanf(busId, "%x:%x:%x.%x", &domain, &bus, &device, &function) != 4) {
+            continue;
+        }
+        auto it = bdfIds.find(((uint64_t)domain << 32) | (bus << 8) | (device << 3) | function);
+        if (it != bdfIds.end()) {
+            smiDevices[deviceId] = it->second;
+        }
+    }
+    return true;
+}
+
+void shutdownCounters() {
+    if (countersInitialized) {
+        rsmi_shut_down();
+        smiDevices.clear();
+        countersInitialized = false;
+    }
+}
+
+// Metrics tables report the fields a device doesn't support as all ones
+static double metricValue(uint16_t value) {
+    return value == UINT16_MAX ? -1.0 : (double)value;
+}
+
+bool CounterSampler::snapshot(int deviceId, Snapshot &snapshot, DeviceCounters *current) {
+    auto smiDevice = smiDevices.find(deviceId);
+    rsmi_gpu_metrics_t metrics;
+    if (smiDevice == smiDevices.end() || rsmi_dev_gpu_metrics_info_get(smiDevice->second, &metrics) != RSMI_STATUS_SUCCESS) {
+        return false;
+    }
+
+    snapshot.time = std::chrono::steady_clock::now();
+    snapshot.xgmiReadKB.assign(metrics.xgmi_read_data_acc, metrics.xgmi_read_data_acc + RSMI_MAX_NUM_XGMI_LINKS);
+    snapshot.xgmiWriteKB.assign(metrics.xgmi_write_data_acc, metrics.xgmi_write_data_acc + RSMI_MAX_NUM_XGMI_LINKS);
+
+    uint64_t energy, timestamp;
+    float resolution;
+    if (rsmi_dev_energy_count_get(smiDevice->second, &energy, &resolution, &timestamp) == RSMI_STATUS_SUCCESS) {
+        snapshot.energyUj = (double)energy * resolution;
+    }
+
+    if (current) {
+        current->hbmActivity = metricValue(metrics.average_umc_activity);
+        current->gfxClock = metricValue(metrics.current_gfxclk);
+        current->memClock = metricValue(metrics.current_uclk);
+        // PCIe speed is in 0.1 GT/s with 128b/130b encoding, XGMI speed in Gbps per lane
+        if (metricValue(metrics.pcie_link_speed) > 0 && metricValue(metrics.pcie_link_width) > 0) {
+            current->pciePeak = metrics.pcie_link_speed * 1e8 * metrics.pcie_link_width * 128.0 / 130.0 / 8.0;
+        }
+        if (metricValue(metrics.xgmi_link_speed) > 0 && metricValue(metrics.xgmi_link_width) > 0) {
+            current->xgmiLinkPeak = metrics.xgmi_link_speed * 1e9 * metrics.xgmi_link_width / 8.0;
+        }
+    }
+    return true;
+}
+
+double DeviceCounters::pcieUtilization() const {
+    return pciePeak > 0.0 && hostBandwidth > 0.0 ? hostBandwidth / pciePeak : -1.0;
+}
+
+double DeviceCounters::xgmiUtilization() const {
+    return xgmiLinkPeak > 0.0 && busiestXgmiLinkBytes >= 0.0 && seconds > 0.0 ? busiestXgmiLinkBytes / seconds / xgmiLinkPeak : -1.0;
+}
+
+void printCounters(const DeviceCounters &counters) {
+    std::stringstream line;
+    line << std::fixed << std::setprecision(2);
+    if (counters.xgmiReadBytes >= 0.0) {
+        line << ", XGMI read " << counters.xgmiReadBytes * 1e-9 << " GB, write " << counters.xgmiWriteBytes * 1e-9 << " GB";
+    }
+    if (counters.xgmiUtilization() >= 0.0) {
+        line << ", busiest XGMI link " << counters.xgmiUtilization() * 100.0 << "% of peak";
+    }
+    if (counters.pcieUtilization() >= 0.0) {
+        line << ", PCIe " << counters.pcieUtilization() * 100.0 << "% of peak";
+    }
+    if (counters.hbmActivity >= 0.0) {
+        line << ", HBM activity " << counters.hbmActivity << "%";
+    }
+    if (counters.averagePower >= 0.0) {
+        line << ", " << counters.averagePower << " W";
+    }
+    if (counters.gfxClock >= 0.0) {
+        line << ", GFX clock " << (int)counters.gfxClock << " MHz";
+    }
+    if (counters.memClock >= 0.0) {
+        line << ", memory clock " << (int)counters.memClock << " MHz";
+    }
+    std::string values = line.str();
+    if (!values.empty()) {
+        std::cout << "\tDevice " << counters.deviceId << " counters" << values.replace(0, 1, ":") << std::endl;
+    }
+}
+
+CounterSampler::CounterSampler(const std::set<int> &deviceIds) {
+    for (int deviceId : deviceIds) {
+        counters[deviceId].deviceId = deviceId;
+    }
+}
+
+void CounterSampler::begin() {
+    started.clear();
+    for (auto &entry : counters) {
+        Snapshot start;
+        if (snapshot(entry.first, start, nullptr)) {
+            started[entry.first] = start;
+        }
+    }
+}
+
+void CounterSampler::end() {
+    for (auto &entry : counters) {
+        auto start = started.find(entry.first);
+        Snapshot finish;
+        DeviceCounters current;
+        if (start == started.end() || !snapshot(entry.first, finish, &current)) {
+            continue;
+        }
+
+        DeviceCounters &total = entry.second;
+        double elapsed = std::chrono::duration<double>(finish.time - start->second.time).count();
+        double readBytes = 0.0, writeBytes = 0.0, busiestLink = 0.0;
+        bool hasXgmi = false;
+        for (int link = 0; link < RSMI_MAX_NUM_XGMI_LINKS; link++) {
+            // unused links report all ones
+            if (finish.xgmiReadKB[link] == UINT64_MAX || finish.xgmiWriteKB[link] == UINT64_MAX) {
+                continue;
+            }
+            double linkRead = (double)(finish.xgmiReadKB[link] - start->second.xgmiReadKB[link]) * 1024.0;
+            double linkWrite = (double)(finish.xgmiWriteKB[link] - start->second.xgmiWriteKB[link]) * 1024.0;
+            readBytes += linkRead;
+            writeBytes += linkWrite;
+            busiestLink = std::max(busiestLink, std::max(linkRead, linkWrite));
+            hasXgmi = true;
+        }
+        if (hasXgmi) {
+            total.xgmiReadBytes = std::max(total.xgmiReadBytes, 0.0) + readBytes;
+            total.xgmiWriteBytes = std::max(total.xgmiWriteBytes, 0.0) + writeBytes;
+            total.busiestXgmiLinkBytes = std::max(total.busiestXgmiLinkBytes, 0.0) + busiestLink;
+        }
+        if (start->second.energyUj >= 0.0 && finish.energyUj >= 0.0) {
+            // average power over all samples, weighted by their duration
+            double energy = (finish.energyUj - start->second.energyUj) * 1e-6;
+            double previousEnergy = total.averagePower >= 0.0 ? total.averagePower * total.seconds : 0.0;
+            total.averagePower = (previousEnergy + energy) / (total.seconds + elapsed);
+        }
+        if (current.hbmActivity >= 0.0) {
+            unsigned int &samples = activitySamples[entry.first];
+            total.hbmActivity = (std::max(total.hbmActivity, 0.0) * samples + current.hbmActivity) / (samples + 1);
+            samples++;
+        }
+        total.seconds += elapsed;
+        total.gfxClock = current.gfxClock;
+        total.memClock = current.memClock;
+        total.pciePeak = current.pciePeak;
+        total.xgmiLinkPeak = current.xgmiLinkPeak;
+    }
+}
+
+std::vector<DeviceCounters> CounterSampler::getCounters() const {
+    std::vector<DeviceCounters> result;
+    for (const auto &entry : counters) {
+        if (entry.second.seconds > 0.0) {
+            result.push_back(entry.second);
+        }
+    }
+    return result;
+}
+
+#endif // ROCM_SMI
@@ -0,0 +1,86 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef COUNTERS_H
+#define COUNTERS_H
+
+#ifdef ROCM_SMI
+
+#include <chrono>
+#include <map>
+#include <set>
+#include <vector>
+
+// Device counters read through ROCm SMI from the metrics table of the SMU, around the timed section of each sample.
+// Values a device doesn't report are left at -1.
+struct DeviceCounters {
+    int deviceId;
+    // time covered by the deltas, summed over the timed sections of all samples
+    double seconds = 0.0;
+    // summed over the XGMI links, and of the link that moved the most data
+    double xgmiReadBytes = -1.0, xgmiWriteBytes = -1.0, busiestXgmiLinkBytes = -1.0;
+    double averagePower = -1.0;         // W, from the energy accumulator
+    double hbmActivity = -1.0;          // percent of the memory controller busy, averaged over the samples
+    double gfxClock = -1.0, memClock = -1.0;      // MHz at the end of the last sample
+    // per direction bandwidth of the negotiated links in bytes/s
+    double pciePeak = -1.0, xgmiLinkPeak = -1.0;
+    // measured bandwidth of the copies between the device and host memory in bytes/s, set when the samples are reported
+    double hostBandwidth = 0.0;
+
+    // Fraction of the link peak used, -1 if unknown. PCIe has no byte counters cheap enough to read per sample,
+    // so its utilization comes from the measured host copy bandwidth, XGMI from the busiest link counters.
+    double pcieUtilization() const;
+    double xgmiUtilization() const;
+};
+
+// Samples the counters of a set of devices over the timed sections of one measurement
+class CounterSampler {
+private:
+    struct Snapshot {
+        std::chrono::steady_clock::time_point time;
+        std::vector<unsigned long long> xgmiReadKB, xgmiWriteKB;
+        double energyUj = -1.0;
+    };
+
+    std::map<int, Snapshot> started;
+    std::map<int, DeviceCounters> counters;
+    std::map<int, unsigned int> activitySamples;
+
+    // False if the device has no ROCm SMI index or its metrics can't be read
+    static bool snapshot(int deviceId, Snapshot &snapshot, DeviceCounters *current);
+public:
+    CounterSampler(const std::set<int> &deviceIds);
+
+    // Called right before the copies of a sample are released, and once they all completed
+    void begin();
+    void end();
+
+    // Accumulated counters of every device that reports them
+    std::vector<DeviceCounters> getCounters() const;
+};
+
+// Prints the counters a device reported on one log line
+void printCounters(const DeviceCounters &counters);
+
+// Initializes ROCm SMI, false if it isn't usable and counters can't be sampled
+bool initCounters();
+void shutdownCounters();
+
+#endif // ROCM_SMI
+
+#endif
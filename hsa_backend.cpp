@@ -0,0 +1,368 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <cstdio>
+#include <iomanip>
+#include <map>
+
+#include "hsa_backend.h"
+#include "numa.h"
+#include "output.h"
+
+namespace {
+
+struct HsaAgents {
+    // CPU agents by KFD topology node id
+    std::map<uint32_t, hsa_agent_t> cpus;
+    // CPU agents by NUMA node
+    std::map<int, hsa_agent_t> numaAgents;
+    // GPU agents by PCI (domain, bus/device/function id)
+    std::map<std::pair<uint32_t, uint32_t>, hsa_agent_t> gpus;
+    std::vector<hsa_agent_t> gpuList;
+    std::map<int, hsa_agent_t> deviceAgents;
+    uint64_t timestampFrequency;
+};
+
+HsaAgents *hsaAgents = nullptr;
+
+hsa_status_t collectAgent(hsa_agent_t agent, void *data) {
+    HsaAgents *agents = (HsaAgents *)data;
+    hsa_device_type_t type;
+    HSA_ASSERT(hsa_agent_get_info(agent, HSA_AGENT_INFO_DEVICE, &type));
+    if (type == HSA_DEVICE_TYPE_CPU) {
+        uint32_t node;
+        HSA_ASSERT(hsa_agent_get_info(agent, HSA_AGENT_INFO_NODE, &node));
+        agents->cpus[node] = agent;
+    } else if (type == HSA_DEVICE_TYPE_GPU) {
+        uint32_t domain, bdfId;
+        HSA_ASSERT(hsa_agent_get_info(agent, (hsa_agent_info_t)HSA_AMD_AGENT_INFO_DOMAIN, &domain));
+        HSA_ASSERT(hsa_agent_get_info(agent, (hsa_agent_info_t)HSA_AMD_AGENT_INFO_BDFID, &bdfId));
+        agents->gpus[{domain, bdfId}] = agent;
+        agents->gpuList.push_back(agent);
+    }
+    return HSA_STATUS_SUCCESS;
+}
+
+// HIP initialized the runtime already, hsa_init only takes a reference for the backend
+HsaAgents &getAgents() {
+    if (!hsaAgents) {
+        HSA_ASSERT(hsa_init());
+        hsaAgents = new HsaAgents();
+        HSA_ASSERT(hsa_iterate_agents(collectAgent, hsaAgents));
+        // KFD creates one CPU topology node per NUMA node with CPUs, in ascending NUMA order and ahead of the GPU nodes
+        auto cpu = hsaAgents->cpus.begin();
+        for (int numaNode : getNumaNodes()) {
+            if (cpu == hsaAgents->cpus.end()) {
+                break;
+            }
+            if (!getNumaNodeCpus(numaNode).empty()) {
+                hsaAgents->numaAgents[numaNode] = (cpu++)->second;
+            }
+        }
+        HSA_ASSERT(hsa_system_get_info(HSA_SYSTEM_INFO_TIMESTAMP_FREQUENCY, &hsaAgents->timestampFrequency));
+        HSA_ASSERT(hsa_amd_profiling_async_copy_enable(true));
+    }
+    return *hsaAgents;
+}
+
+hsa_status_t findFineGrainedPool(hsa_amd_memory_pool_t pool, void *data) {
+    hsa_amd_segment_t segment;
+    HSA_ASSERT(hsa_amd_memory_pool_get_info(pool, HSA_AMD_MEMORY_POOL_INFO_SEGMENT, &segment));
+    if (segment != HSA_AMD_SEGMENT_GLOBAL) {
+        return HSA_STATUS_SUCCESS;
+    }
+    uint32_t flags;
+    bool allocAllowed;
+    HSA_ASSERT(hsa_amd_memory_pool_get_info(pool, HSA_AMD_MEMORY_POOL_INFO_GLOBAL_FLAGS, &flags));
+    HSA_ASSERT(hsa_amd_memory_pool_get_info(pool, HSA_AMD_MEMORY_POOL_INFO_RUNTIME_ALLOC_ALLOWED, &allocAllowed));
+    if (allocAllowed && (flags & HSA_AMD_MEMORY_POOL_GLOBAL_FLAG_FINE_GRAINED)) {
+        *(hsa_amd_memory_pool_t *)data = pool;
+        return HSA_STATUS_INFO_BREAK;
+    }
+    return HSA_STATUS_SUCCESS;
+}
+
+double ticksToSeconds(uint64_t ticks) {
+    return (double)ticks / (double)getAgents().timestampFrequency;
+}
+
+} // namespace
+
+hsa_agent_t getHsaGpuAgent(int deviceId) {
+    HsaAgents &agents = getAgents();
+    auto it = agents.deviceAgents.find(deviceId);
+    if (it != agents.deviceAgents.end()) {
+        return it->second;
+    }
+
+    char busId[32];
+    unsigned int domain, bus, device, function;
+    CU_ASSERT(hipDeviceGetPCIBusId(busId, sizeof(busId), deviceId));
+    if (sscanf(busId, "%x:%x:%x.%x", &domain, &bus, &device, &function) != 4) {
+        throw std::string("Can't parse PCI bus id ") + busId + " of device " + std::to_string(deviceId);
+    }
+    auto gpu = agents.gpus.find({domain, (bus << 8) | (device << 3) | function});
+    if (gpu == agents.gpus.end()) {
+        throw std::string("No HSA agent found for device ") + std::to_string(deviceId) + " at " + busId;
+    }
+    agents.deviceAgents[deviceId] = gpu->second;
+    return gpu->second;
+}
+
+hsa_agent_t getHsaCpuAgent(int numaNode) {
+    HsaAgents &agents = getAgents();
+    auto it = agents.numaAgents.find(numaNode);
+    if (it != agents.numaAgents.end()) {
+        return it->second;
+    }
+    return agents.cpus.begin()->second;
+}
+
+hipError_t hsaHostAlloc(void** buffer, size_t size, int numaNode) {
+    HsaAgents &agents = getAgents();
+    hsa_amd_memory_pool_t pool{};
+    HSA_ASSERT(hsa_amd_agent_iterate_memory_pools(getHsaCpuAgent(numaNode), findFineGrainedPool, &pool));
+    if (!pool.handle) {
+        return hipErrorNotSupported;
+    }
+
+    hsa_status_t status = hsa_amd_memory_pool_allocate(pool, size, 0, buffer);
+    if (status == HSA_STATUS_ERROR_OUT_OF_RESOURCES) {
+        return hipErrorOutOfMemory;
+    }
+    HSA_ASSERT(status);
+    HSA_ASSERT(hsa_amd_agents_allow_access(agents.gpuList.size(), agents.gpuList.data(), nullptr, *buffer));
+    return hipSuccess;
+}
+
+void hsaHostFree(void* buffer) {
+    HSA_ASSERT(hsa_amd_memory_pool_free(buffer));
+}
+
+void hsaShutdown() {
+    if (hsaAgents) {
+        delete hsaAgents;
+        hsaAgents = nullptr;
+        HSA_ASSERT(hsa_shut_down());
+    }
+}
+
+MemcpyOperationHsa::MemcpyOperationHsa(unsigned long long loopCount, ContextPreference ctxPreference, BandwidthValue bandwidthValue) :
+        MemcpyOperation(loopCount, ctxPreference, bandwidthValue) {
+    getAgents();
+    HSA_ASSERT(hsa_signal_create(1, 0, nullptr, &startSignal));
+}
+
+MemcpyOperationHsa::~MemcpyOperationHsa() {
+    for (std::vector<hsa_signal_t> &signals : completionSignals) {
+        for (hsa_signal_t signal : signals) {
+            HSA_ASSERT(hsa_signal_destroy(signal));
+        }
+    }
+    HSA_ASSERT(hsa_signal_destroy(startSignal));
+}
+
+size_t MemcpyOperationHsa::memcpyFunc(hipDeviceptr_t dst, hipDeviceptr_t src, hipStream_t stream, size_t copySize, unsigned long long loopCount) {
+    return copySize;
+}
+
+size_t MemcpyOperationHsa::getAdjustedCopySize(hipDeviceptr_t dst, hipDeviceptr_t src, size_t size, hipStream_t stream) {
+    return size;
+}
+
+hsa_agent_t MemcpyOperationHsa::getNodeAgent(const MemcpyNode &node) const {
+    if (const HostNode *host = dynamic_cast<const HostNode *>(&node)) {
+        if (host->getMemType() == HOST_MEM_PAGEABLE || host->getMemType() == HOST_MEM_MANAGED) {
+            throw std::string("The HSA backend doesn't support ") + hostMemTypeNames[host->getMemType()] + " host memory";
+        }
+        // explicitly placed buffers are copied by the agent of their own node
+        return getHsaCpuAgent(host->getNumaNode() >= 0 ? host->getNumaNode() : getDeviceNumaNode(host->getOwnerDeviceIdx()));
+    }
+    if (dynamic_cast<const DeviceNode *>(&node)) {
+        return getHsaGpuAgent(node.getNodeIdx());
+    }
+    throw std::string("The HSA backend doesn't support managed memory");
+}
+
+std::vector<hsa_signal_t> &MemcpyOperationHsa::getCompletionSignals(int copy, size_t count) {
+    if (completionSignals.size() <= copy) {
+        completionSignals.resize(copy + 1);
+    }
+    std::vector<hsa_signal_t> &signals = completionSignals[copy];
+    while (signals.size() < count) {
+        signals.emplace_back();
+        HSA_ASSERT(hsa_signal_create(1, 0, nullptr, &signals.back()));
+    }
+    return signals;
+}
+
+double MemcpyOperationHsa::doMemcpy(const std::vector<const MemcpyNode*> &srcNodes, const std::vector<const MemcpyNode*> &dstNodes) {
+    return measureSizes(srcNodes, dstNodes, [&](const std::vector<size_t> &copySizes) {
+        return measureBandwidth(srcNodes, dstNodes, copySizes);
+    });
+}
+
+double MemcpyOperationHsa::measureBandwidth(const std::vector<const MemcpyNode*> &srcNodes, const std::vector<const MemcpyNode*> &dstNodes,
+                                            const std::vector<size_t> &copySizes) {
+    SampleStatistics stats(srcNodes.size());
+    unsigned long long warmupCount = getWarmupCount();
+    unsigned long long timedLoopCount = getTimedLoopCount();
+    size_t copyCount = warmupCount + timedLoopCount;
+    std::vector<hsa_agent_t> srcAgents(srcNodes.size()), dstAgents(srcNodes.size());
+    std::vector<uint64_t> starts(srcNodes.size()), ends(srcNodes.size());
+
+    for (int i = 0; i < srcNodes.size(); i++) {
+        assert(copySizes[i] <= srcNodes[i]->getBufferSize() && copySizes[i] <= dstNodes[i]->getBufferSize());
+        srcAgents[i] = getNodeAgent(*srcNodes[i]);
+        dstAgents[i] = getNodeAgent(*dstNodes[i]);
+        getCompletionSignals(i, copyCount);
+    }
+
+    const PerformanceStatistic &reportedStat = bandwidthValue == BandwidthValue::SUM_BW ? stats.sumBandwidth :
+                                               bandwidthValue == BandwidthValue::TOTAL_BW ? stats.totalBandwidth : stats.bandwidths[0];
+#ifdef ROCM_SMI
+    std::unique_ptr<CounterSampler> counters = createCounterSampler(srcNodes, dstNodes);
+#endif
+    SampleBudget budget;
+    unsigned int untimedSamples = 0;
+    for (unsigned long long n = 0; budget.needsMore(reportedStat); n++) {
+        for (int i = 0; i < srcNodes.size(); i++) {
+            dstNodes[i]->memsetPattern(copySizes[i], 0xCAFEBABE);
+            srcNodes[i]->memsetPattern(copySizes[i], 0xBAADF00D);
+        }
+
+        // hold every chain until all of them are enqueued
+        hsa_signal_store_screlease(startSignal, 1);
+        for (int i = 0; i < srcNodes.size(); i++) {
+            std::vector<hsa_signal_t> &signals = getCompletionSignals(i, copyCount);
+            for (size_t c = 0; c < copyCount; c++) {
+                hsa_signal_t dependency = c == 0 ? startSignal : signals[c - 1];
+                hsa_signal_store_screlease(signals[c], 1);
+                if (sdmaEngine >= 0) {
+                    HSA_ASSERT(hsa_amd_memory_async_copy_on_engine(dstNodes[i]->getBuffer(), dstAgents[i], srcNodes[i]->getBuffer(), srcAgents[i],
+                                                                   copySizes[i], 1, &dependency, signals[c],
+                                                                   (hsa_amd_sdma_engine_id_t)(1u << sdmaEngine), true));
+                } else {
+                    HSA_ASSERT(hsa_amd_memory_async_copy(dstNodes[i]->getBuffer(), dstAgents[i], srcNodes[i]->getBuffer(), srcAgents[i],
+                                                         copySizes[i], 1, &dependency, signals[c]));
+                }
+            }
+        }
+        if (backgroundLoad) {
+            backgroundLoad->start();
+        }
+#ifdef ROCM_SMI
+        if (counters) {
+            counters->begin();
+        }
+#endif
+        hsa_signal_store_screlease(startSignal, 0);
+
+        for (int i = 0; i < srcNodes.size(); i++) {
+            hsa_signal_t last = completionSignals[i][copyCount - 1];
+            while (hsa_signal_wait_scacquire(last, HSA_SIGNAL_CONDITION_LT, 1, UINT64_MAX, HSA_WAIT_STATE_BLOCKED) >= 1);
+        }
+#ifdef ROCM_SMI
+        if (counters) {
+            counters->end();
+        }
+#endif
+        if (backgroundLoad) {
+            backgroundLoad->stop();
+        }
+
+        if (!skipVerification) {
+            for (int i = 0; i < srcNodes.size(); i++) {
+                getVerifiedNode(*srcNodes[i], *dstNodes[i]).memcmpPattern(copySizes[i], 0xBAADF00D);
+            }
+        }
+
+        // a sample timed as zero carries no bandwidth, it is re-run instead of recording an infinite one
+        bool timed = true;
+        for (int i = 0; i < srcNodes.size(); i++) {
+            hsa_amd_profiling_async_copy_time_t time;
+            HSA_ASSERT(hsa_amd_profiling_get_async_copy_time(completionSignals[i][warmupCount], &time));
+            starts[i] = time.start;
+            HSA_ASSERT(hsa_amd_profiling_get_async_copy_time(completionSignals[i][copyCount - 1], &time));
+            ends[i] = time.end;
+            timed = timed && ends[i] > starts[i];
+        }
+        if (!timed) {
+            if (++untimedSamples > MAX_UNTIMED_SAMPLES) {
+                throw std::string("Copies of ") + std::to_string(copySizes[0]) + " bytes are too short for the copy timer, raise --bufferSize";
+            }
+            VERBOSE << "\tSample " << n << ": timed as 0 us, running it again\n";
+            continue;
+        }
+
+        double sampleSum = 0.0;
+        size_t totalSize = 0;
+        for (int i = 0; i < srcNodes.size(); i++) {
+            if (perIterationTiming) {
+                uint64_t previousEnd = starts[i];
+                for (size_t c = warmupCount; c < copyCount; c++) {
+                    hsa_amd_profiling_async_copy_time_t time;
+                    HSA_ASSERT(hsa_amd_profiling_get_async_copy_time(completionSignals[i][c], &time));
+                    stats.iterationTimes[i].recordNs((unsigned long long)(ticksToSeconds(time.end - previousEnd) * 1e9));
+                    previousEnd = time.end;
+                }
+            }
+
+            double bandwidth = (double)(copySizes[i] * timedLoopCount) / ticksToSeconds(ends[i] - starts[i]);
+            stats.bandwidths[i](bandwidth);
+            sampleSum += bandwidth;
+            totalSize += copySizes[i];
+
+            if (bandwidthValue == BandwidthValue::SUM_BW || bandwidthValue == BandwidthValue::TOTAL_BW || i == 0) {
+                VERBOSE << "\tSample " << n << ": " << srcNodes[i]->getNodeString() << " -> " << dstNodes[i]->getNodeString() << ": " <<
+                    std::fixed << std::setprecision(2) << bandwidth * 1e-9 << " GB/s\n";
+            }
+        }
+
+        stats.sumBandwidth(sampleSum);
+
+        if (srcNodes.size() > 1) {
+            // every copy is timed on the system clock, so the skew is known between any devices
+            double maxSkew = 0.0;
+            for (int i = 1; i < srcNodes.size(); i++) {
+                if (starts[i] > starts[0]) {
+                    maxSkew = std::max(maxSkew, ticksToSeconds(starts[i] - starts[0]) * 1e6);
+                }
+            }
+            stats.startSkew(maxSkew);
+            VERBOSE << "\tSample " << n << ": Start skew : " << std::fixed << std::setprecision(2) << maxSkew << " us\n";
+        }
+
+        if (bandwidthValue == BandwidthValue::TOTAL_BW) {
+            uint64_t firstStart = *std::min_element(starts.begin(), starts.end());
+            uint64_t lastEnd = *std::max_element(ends.begin(), ends.end());
+            double bandwidth = (double)(totalSize * timedLoopCount) / ticksToSeconds(lastEnd - firstStart);
+            stats.totalBandwidth(bandwidth);
+
+            VERBOSE << "\tSample " << n << ": Total Bandwidth : " <<
+                std::fixed << std::setprecision(2) << bandwidth * 1e-9 << " GB/s\n";
+        }
+    }
+
+#ifdef ROCM_SMI
+    if (counters) {
+        stats.counters = counters->getCounters();
+    }
+#endif
+    return reportBandwidth(srcNodes, dstNodes, copySizes, stats);
+}
@@ -0,0 +1,79 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef HSA_BACKEND_H
+#define HSA_BACKEND_H
+
+#include <hsa/hsa.h>
+#include <hsa/hsa_ext_amd.h>
+
+#include "memcpy.h"
+
+inline void HSA_ASSERT(hsa_status_t status, const char *msg = nullptr) {
+    if (status != HSA_STATUS_SUCCESS && status != HSA_STATUS_INFO_BREAK) {
+        const char *statusStr = nullptr;
+        if (hsa_status_string(status, &statusStr) != HSA_STATUS_SUCCESS) {
+            statusStr = "unknown HSA error";
+        }
+        std::cout << "[HSA " << status << "] " << statusStr;
+        if (msg != nullptr) std::cout << ":\n\t" << msg;
+        std::cout << std::endl;
+        std::exit(1);
+    }
+}
+
+// HSA agent of the HIP device, HIP and HSA device orders can differ so agents are matched by PCI location
+hsa_agent_t getHsaGpuAgent(int deviceId);
+// HSA CPU agent of the NUMA node, the first one if the node has none
+hsa_agent_t getHsaCpuAgent(int numaNode);
+
+// Allocates fine grained system memory on the NUMA node's CPU agent and lets every GPU agent access it
+hipError_t hsaHostAlloc(void** buffer, size_t size, int numaNode);
+void hsaHostFree(void* buffer);
+// Releases the HSA runtime reference taken by the first backend call, if any
+void hsaShutdown();
+
+// CE copies issued straight to the HSA runtime with hsa_amd_memory_async_copy, skipping HIP streams and events.
+// The copies of each node pair are chained through their completion signals and all depend on one start signal,
+// which plays the role of the spin kernel latch. Copies are timed with the runtime's async copy profiling, so
+// every copy of a sample is timed on the same system clock whatever its device. The runtime picks the engine
+// from the agents, the context preference only names the copy in the output.
+class MemcpyOperationHsa : public MemcpyOperation {
+private:
+    hsa_signal_t startSignal;
+    // completion signal of every warmup and timed copy of each node pair, reused by all samples
+    std::vector<std::vector<hsa_signal_t>> completionSignals;
+
+    // Agent owning the node's buffer, pageable and managed memory is not supported by the HSA copies
+    hsa_agent_t getNodeAgent(const MemcpyNode &node) const;
+    std::vector<hsa_signal_t> &getCompletionSignals(int copy, size_t count);
+    double measureBandwidth(const std::vector<const MemcpyNode*> &srcNodes, const std::vector<const MemcpyNode*> &dstNodes,
+                            const std::vector<size_t> &copySizes);
+
+    // Copies are not issued on HIP streams
+    size_t memcpyFunc(hipDeviceptr_t dst, hipDeviceptr_t src, hipStream_t stream, size_t copySize, unsigned long long loopCount);
+    size_t getAdjustedCopySize(hipDeviceptr_t dst, hipDeviceptr_t src, size_t size, hipStream_t stream);
+public:
+    MemcpyOperationHsa(unsigned long long loopCount, ContextPreference ctxPreference = ContextPreference::PREFER_SRC_CONTEXT, BandwidthValue bandwidthValue = BandwidthValue::USE_FIRST_BW);
+    ~MemcpyOperationHsa();
+
+    double doMemcpy(const std::vector<const MemcpyNode*> &srcNodes, const std::vector<const MemcpyNode*> &dstNodes) override;
+    using MemcpyOperation::doMemcpy;
+};
+
+#endif
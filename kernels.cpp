@@ -19,62 +19,131 @@
 #include <hip/hip_runtime.h>
 #include "kernels.h"
 
-__global__ void simpleCopyKernel(unsigned long long loopCount, uint4 *dst, uint4 *src) {
-    for (unsigned int i = 0; i < loopCount; i++) {
-        const int idx = blockIdx.x * blockDim.x + threadIdx.x;
-        size_t offset = idx * sizeof(uint4);
-        uint4* dst_uint4 = reinterpret_cast<uint4*>((char*)dst + offset);
-        uint4* src_uint4 = reinterpret_cast<uint4*>((char*)src + offset);
-	__stcg(dst_uint4, __ldcg(src_uint4));
-    }
-}
-__global__ void stridingMemcpyKernel(unsigned int totalThreadCount, unsigned long long loopCount, uint4* dst, uint4* src, size_t chunkSizeInElement) {
-    unsigned long long from = blockDim.x * blockIdx.x + threadIdx.x;
-    unsigned long long bigChunkSizeInElement = chunkSizeInElement / 12;
-    dst += from;
-    src += from;
-    uint4* dstBigEnd = dst + (bigChunkSizeInElement * 12) * totalThreadCount;
-    uint4* dstEnd = dst + chunkSizeInElement * totalThreadCount;
-
-    for (unsigned int i = 0; i < loopCount; i++) {
-        uint4* cdst = dst;
-        uint4* csrc = src;
-
-        while (cdst < dstBigEnd) {
-            uint4 pipe_0 = *csrc; csrc += totalThreadCount;
-            uint4 pipe_1 = *csrc; csrc += totalThreadCount;
-            uint4 pipe_2 = *csrc; csrc += totalThreadCount;
-            uint4 pipe_3 = *csrc; csrc += totalThreadCount;
-            uint4 pipe_4 = *csrc; csrc += totalThreadCount;
-            uint4 pipe_5 = *csrc; csrc += totalThreadCount;
-            uint4 pipe_6 = *csrc; csrc += totalThreadCount;
-            uint4 pipe_7 = *csrc; csrc += totalThreadCount;
-            uint4 pipe_8 = *csrc; csrc += totalThreadCount;
-            uint4 pipe_9 = *csrc; csrc += totalThreadCount;
-            uint4 pipe_10 = *csrc; csrc += totalThreadCount;
-            uint4 pipe_11 = *csrc; csrc += totalThreadCount;
-
-            *cdst = pipe_0; cdst += totalThreadCount;
-            *cdst = pipe_1; cdst += totalThreadCount;
-            *cdst = pipe_2; cdst += totalThreadCount;
-            *cdst = pipe_3; cdst += totalThreadCount;
-            *cdst = pipe_4; cdst += totalThreadCount;
-            *cdst = pipe_5; cdst += totalThreadCount;
-            *cdst = pipe_6; cdst += totalThreadCount;
-            *cdst = pipe_7; cdst += totalThreadCount;
-            *cdst = pipe_8; cdst += totalThreadCount;
-            *cdst = pipe_9; cdst += totalThreadCount;
-            *cdst = pipe_10; cdst += totalThreadCount;
-            *cdst = pipe_11; cdst += totalThreadCount;
-        }
-
-        while (cdst < dstEnd) {
-            *cdst = *csrc; cdst += totalThreadCount; csrc += totalThreadCount;
-        }
-    }
-}
-
-size_t copyKernel(hipDeviceptr_t dstBuffer, hipDeviceptr_t srcBuffer, size_t size, hipStream_t stream, unsigned long long loopCount) {
+template <SmCacheHint HINT, typename T>
+__device__ __forceinline__ T loadWithHint(const T *src) {
+    if constexpr (HINT == SM_CACHE_GLOBAL) {
+        return __ldcg(src);
+    } else if constexpr (HINT == SM_CACHE_NONTEMPORAL) {
+        // on the native vector of the HIP vector type, so the access is as wide as the default one
+        T value;
+        value.data = __builtin_nontemporal_load(&src->data);
+        return value;
+    } else {
+        return *src;
+    }
+}
+
+template <SmCacheHint HINT, typename T>
+__device__ __forceinline__ void storeWithHint(T *dst, const T &value) {
+    if constexpr (HINT == SM_CACHE_GLOBAL) {
+        __stcg(dst, value);
+    } else if constexpr (HINT == SM_CACHE_NONTEMPORAL) {
+        __builtin_nontemporal_store(value.data, &dst->data);
+    } else {
+        *dst = value;
+    }
+}
+
+// Grid strided copy, each thread issues UNROLL loads one grid apart before storing them, the remainder
+// that doesn't fill a whole unrolled pass of the grid is copied one element per thread
+template <typename T, unsigned int UNROLL, unsigned int BLOCK_SIZE, SmCacheHint HINT>
+__global__ void __launch_bounds__(BLOCK_SIZE) tunedCopyKernel(unsigned long long loopCount, T *dst, const T *src, size_t sizeInElement) {
+    const size_t totalThreadCount = (size_t)gridDim.x * BLOCK_SIZE;
+    const size_t from = (size_t)blockIdx.x * BLOCK_SIZE + threadIdx.x;
+    const size_t bigEnd = sizeInElement - sizeInElement % (UNROLL * totalThreadCount);
+
+    for (unsigned long long i = 0; i < loopCount; i++) {
+        size_t idx = from;
+        for (; idx < bigEnd; idx += UNROLL * totalThreadCount) {
+            T pipe[UNROLL];
+#pragma unroll
+            for (unsigned int u = 0; u < UNROLL; u++) {
+                pipe[u] = loadWithHint<HINT>(src + idx + u * totalThreadCount);
+            }
+#pragma unroll
+            for (unsigned int u = 0; u < UNROLL; u++) {
+                storeWithHint<HINT>(dst + idx + u * totalThreadCount, pipe[u]);
+            }
+        }
+        for (; idx < sizeInElement; idx += totalThreadCount) {
+            storeWithHint<HINT>(dst + idx, loadWithHint<HINT>(src + idx));
+        }
+    }
+}
+
+// The launchers below walk the config down to one instantiation
+template <typename T, unsigned int UNROLL, unsigned int BLOCK_SIZE>
+static void launchTunedCopyKernel(const SmCopyConfig &config, dim3 grid, hipStream_t stream, unsigned long long loopCount, T *dst, const T *src, size_t sizeInElement) {
+    switch (config.cacheHint) {
+        case SM_CACHE_DEFAULT:
+            tunedCopyKernel<T, UNROLL, BLOCK_SIZE, SM_CACHE_DEFAULT><<<grid, BLOCK_SIZE, 0, stream>>>(loopCount, dst, src, sizeInElement);
+            break;
+        case SM_CACHE_GLOBAL:
+            tunedCopyKernel<T, UNROLL, BLOCK_SIZE, SM_CACHE_GLOBAL><<<grid, BLOCK_SIZE, 0, stream>>>(loopCount, dst, src, sizeInElement);
+            break;
+        case SM_CACHE_NONTEMPORAL:
+            tunedCopyKernel<T, UNROLL, BLOCK_SIZE, SM_CACHE_NONTEMPORAL><<<grid, BLOCK_SIZE, 0, stream>>>(loopCount, dst, src, sizeInElement);
+            break;
+    }
+}
+
+template <typename T, unsigned int UNROLL>
+static void launchTunedCopyKernel(const SmCopyConfig &config, dim3 grid, hipStream_t stream, unsigned long long loopCount, T *dst, const T *src, size_t sizeInElement) {
+    switch (config.blockSize) {
+        case 256: launchTunedCopyKernel<T, UNROLL, 256>(config, grid, stream, loopCount, dst, src, sizeInElement); break;
+        case 512: launchTunedCopyKernel<T, UNROLL, 512>(config, grid, stream, loopCount, dst, src, sizeInElement); break;
+        case 1024: launchTunedCopyKernel<T, UNROLL, 1024>(config, grid, stream, loopCount, dst, src, sizeInElement); break;
+        default: assert(!"unsupported SM copy block size");
+    }
+}
+
+template <typename T>
+static void launchTunedCopyKernel(const SmCopyConfig &config, dim3 grid, hipStream_t stream, unsigned long long loopCount, T *dst, const T *src, size_t sizeInElement) {
+    switch (config.unroll) {
+        case 4: launchTunedCopyKernel<T, 4>(config, grid, stream, loopCount, dst, src, sizeInElement); break;
+        case 8: launchTunedCopyKernel<T, 8>(config, grid, stream, loopCount, dst, src, sizeInElement); break;
+        case 12: launchTunedCopyKernel<T, 12>(config, grid, stream, loopCount, dst, src, sizeInElement); break;
+        case 16: launchTunedCopyKernel<T, 16>(config, grid, stream, loopCount, dst, src, sizeInElement); break;
+        default: assert(!"unsupported SM copy unroll depth");
+    }
+}
+
+// Loads every instantiation the launchers above can pick, so autotuning and cache hints don't load kernels in the middle of a test
+template <typename T, unsigned int UNROLL, unsigned int BLOCK_SIZE>
+static void preloadTunedCopyKernels() {
+    hipFuncAttributes unused;
+    hipFuncGetAttributes(&unused, &tunedCopyKernel<T, UNROLL, BLOCK_SIZE, SM_CACHE_DEFAULT>);
+    hipFuncGetAttributes(&unused, &tunedCopyKernel<T, UNROLL, BLOCK_SIZE, SM_CACHE_GLOBAL>);
+    hipFuncGetAttributes(&unused, &tunedCopyKernel<T, UNROLL, BLOCK_SIZE, SM_CACHE_NONTEMPORAL>);
+}
+
+template <typename T, unsigned int UNROLL>
+static void preloadTunedCopyKernels() {
+    preloadTunedCopyKernels<T, UNROLL, 256>();
+    preloadTunedCopyKernels<T, UNROLL, 512>();
+    preloadTunedCopyKernels<T, UNROLL, 1024>();
+}
+
+template <typename T>
+static void preloadTunedCopyKernels() {
+    preloadTunedCopyKernels<T, 4>();
+    preloadTunedCopyKernels<T, 8>();
+    preloadTunedCopyKernels<T, 12>();
+    preloadTunedCopyKernels<T, 16>();
+}
+
+std::string SmCopyConfig::toString() const {
+    static const char *cacheHintNames[] = {"default", "ldcg/stcg", "nontemporal"};
+    std::stringstream s;
+    s << vectorWidth << "B x" << unroll << " unroll, " << blockSize << " threads, " << blocksPerSm << " blocks/CU, " << cacheHintNames[cacheHint] << " loads/stores";
+    return s.str();
+}
+
+size_t copyKernelSize(size_t size, const SmCopyConfig &config) {
+    return size - size % config.vectorWidth;
+}
+
+size_t copyKernel(hipDeviceptr_t dstBuffer, hipDeviceptr_t srcBuffer, size_t size, hipStream_t stream, unsigned long long loopCount, const SmCopyConfig &config) {
     hipDevice_t dev;
     hipCtx_t ctx;
 
@@ -83,36 +152,164 @@ size_t copyKernel(hipDeviceptr_t dstBuffer, hipDeviceptr_t srcBuffer, size_t siz
 
     int numSm;
     CU_ASSERT(hipDeviceGetAttribute(&numSm, hipDeviceAttributeMultiprocessorCount, dev));
-    unsigned int totalThreadCount = numSm * numThreadPerBlock;
-
-    // If the user provided buffer size is samller than default buffer size,
-    // we use the simple copy kernel for our bandwidth test.
-    // This is done so that no trucation of the buffer size occurs.
-    // Please note that to achieve peak bandwidth, it is suggested to use the
-    // default buffer size, which in turn triggers the use of the optimized
-    // kernel.
-    if (size < (defaultBufferSize * _MiB) ) {
-        // copy size is rounded down to 16 bytes
-        int numUint4 = size / sizeof(uint4);
-        // we allow max 1024 threads per block, and then scale out the copy across multiple blocks
-        dim3 block(std::min(numUint4, 1024));
-        dim3 grid(numUint4/block.x);
-        simpleCopyKernel <<<grid, block, 0 , stream>>> (loopCount, (uint4 *)dstBuffer, (uint4 *)srcBuffer);
-        return numUint4 * sizeof(uint4);
-    }
-
-    // adjust size to elements (size is multiple of MB, so no truncation here)
+
+    size_t sizeInElement = size / config.vectorWidth;
+    // small copies don't need the whole device, launch only the blocks that get an element
+    size_t neededBlocks = (sizeInElement + config.blockSize - 1) / config.blockSize;
+    dim3 grid((unsigned int)std::max((size_t)1, std::min(neededBlocks, (size_t)numSm * config.blocksPerSm)));
+
+    if (config.vectorWidth == sizeof(uint4)) {
+        launchTunedCopyKernel<uint4>(config, grid, stream, loopCount, (uint4 *)dstBuffer, (const uint4 *)srcBuffer, sizeInElement);
+    } else {
+        assert(config.vectorWidth == sizeof(uint2));
+        launchTunedCopyKernel<uint2>(config, grid, stream, loopCount, (uint2 *)dstBuffer, (const uint2 *)srcBuffer, sizeInElement);
+    }
+
+    return copyKernelSize(size, config);
+}
+
+// Blocks per CU of the read and write kernels, enough loads and stores in flight to saturate local HBM
+static const unsigned int READ_WRITE_BLOCKS_PER_SM = 4;
+static const unsigned int READ_UNROLL = 12;
+
+// Grid strided like tunedCopyKernel, each thread keeps UNROLL loads in flight and folds them into its accumulator
+__global__ void __launch_bounds__(numThreadPerBlock) readKernelDevice(unsigned long long loopCount, const uint4 *src, size_t sizeInElement, uint4 *sink) {
+    const size_t totalThreadCount = (size_t)gridDim.x * numThreadPerBlock;
+    const size_t from = (size_t)blockIdx.x * numThreadPerBlock + threadIdx.x;
+    const size_t bigEnd = sizeInElement - sizeInElement % (READ_UNROLL * totalThreadCount);
+    uint4 accumulator = {0, 0, 0, 0};
+
+    for (unsigned long long i = 0; i < loopCount; i++) {
+        size_t idx = from;
+        for (; idx < bigEnd; idx += READ_UNROLL * totalThreadCount) {
+            uint4 pipe[READ_UNROLL];
+#pragma unroll
+            for (unsigned int u = 0; u < READ_UNROLL; u++) {
+                pipe[u] = src[idx + u * totalThreadCount];
+            }
+#pragma unroll
+            for (unsigned int u = 0; u < READ_UNROLL; u++) {
+                accumulator.x ^= pipe[u].x;
+                accumulator.y ^= pipe[u].y;
+                accumulator.z ^= pipe[u].z;
+                accumulator.w ^= pipe[u].w;
+            }
+        }
+        for (; idx < sizeInElement; idx += totalThreadCount) {
+            uint4 value = src[idx];
+            accumulator.x ^= value.x;
+            accumulator.y ^= value.y;
+            accumulator.z ^= value.z;
+            accumulator.w ^= value.w;
+        }
+    }
+    // practically never true, but the compiler can't tell
+    if (accumulator.x == 0x9E3779B9 && accumulator.y == accumulator.z && accumulator.w == accumulator.x) {
+        *sink = accumulator;
+    }
+}
+
+__global__ void __launch_bounds__(numThreadPerBlock) writeKernelDevice(unsigned long long loopCount, uint4 *dst, size_t sizeInElement) {
+    const size_t totalThreadCount = (size_t)gridDim.x * numThreadPerBlock;
+    const size_t from = (size_t)blockIdx.x * numThreadPerBlock + threadIdx.x;
+
+    for (unsigned long long i = 0; i < loopCount; i++) {
+        uint4 value = {(unsigned int)i, (unsigned int)from, 0xCAFEBABE, 0xBAADF00D};
+        for (size_t idx = from; idx < sizeInElement; idx += totalThreadCount) {
+            dst[idx] = value;
+        }
+    }
+}
+
+// Grid of READ_WRITE_BLOCKS_PER_SM blocks per CU, or fewer for buffers that don't give every thread an element
+static dim3 readWriteGrid(size_t sizeInElement) {
+    hipDevice_t dev;
+    int numSm;
+
+    CU_ASSERT(hipCtxGetDevice(&dev));
+    CU_ASSERT(hipDeviceGetAttribute(&numSm, hipDeviceAttributeMultiprocessorCount, dev));
+    size_t neededBlocks = (sizeInElement + numThreadPerBlock - 1) / numThreadPerBlock;
+    return dim3((unsigned int)std::max((size_t)1, std::min(neededBlocks, (size_t)numSm * READ_WRITE_BLOCKS_PER_SM)));
+}
+
+size_t readWriteKernelSize(size_t size) {
+    return size - size % sizeof(uint4);
+}
+
+size_t readKernel(hipDeviceptr_t srcBuffer, size_t size, hipDeviceptr_t sink, hipStream_t stream, unsigned long long loopCount) {
     size_t sizeInElement = size / sizeof(uint4);
-    // this truncates the copy
-    sizeInElement = totalThreadCount * (sizeInElement / totalThreadCount);
+    readKernelDevice<<<readWriteGrid(sizeInElement), numThreadPerBlock, 0, stream>>>(loopCount, (const uint4 *)srcBuffer, sizeInElement, (uint4 *)sink);
+    return readWriteKernelSize(size);
+}
 
-    size_t chunkSizeInElement = sizeInElement / totalThreadCount;
+size_t writeKernel(hipDeviceptr_t dstBuffer, size_t size, hipStream_t stream, unsigned long long loopCount) {
+    size_t sizeInElement = size / sizeof(uint4);
+    writeKernelDevice<<<readWriteGrid(sizeInElement), numThreadPerBlock, 0, stream>>>(loopCount, (uint4 *)dstBuffer, sizeInElement);
+    return readWriteKernelSize(size);
+}
+
+// multiplier of the random access permutation, a prime so it's coprime with any chunk count below it
+static const unsigned long long ACCESS_RANDOM_MULTIPLIER = 2654435761ULL;
+
+std::string AccessPattern::toString() const {
+    if (random) {
+        return "random";
+    }
+    return strideChunks == 1 ? "sequential" : "stride " + std::to_string(strideChunks) + "x";
+}
 
-    dim3 gridDim(numSm, 1, 1);
-    dim3 blockDim(numThreadPerBlock, 1, 1);
-    stridingMemcpyKernel<<<gridDim, blockDim, 0, stream>>> (totalThreadCount, loopCount, (uint4 *)dstBuffer, (uint4 *)srcBuffer, chunkSizeInElement);
+static unsigned long long accessChunkCount(size_t size, const AccessPattern &pattern) {
+    unsigned long long chunkCount = size / pattern.accessSize;
+    return chunkCount - chunkCount % pattern.strideChunks;
+}
 
-    return sizeInElement * sizeof(uint4);
+size_t accessPatternKernelSize(size_t size, const AccessPattern &pattern) {
+    return accessChunkCount(size, pattern) * pattern.accessSize;
+}
+
+// Every group of accessSize / 16 threads reads one chunk per access, groups stride over the accesses of the grid
+__global__ void __launch_bounds__(numThreadPerBlock) accessPatternKernelDevice(unsigned long long loopCount, const uint4 *src, unsigned long long chunkCount,
+                                                                               unsigned int elementsPerChunk, unsigned int strideChunks, bool random, uint4 *sink) {
+    const unsigned long long threadId = (unsigned long long)blockIdx.x * numThreadPerBlock + threadIdx.x;
+    const unsigned long long groupCount = (unsigned long long)gridDim.x * numThreadPerBlock / elementsPerChunk;
+    const unsigned long long group = threadId / elementsPerChunk;
+    const unsigned int lane = threadId % elementsPerChunk;
+    // strided accesses walk the chunks as a matrix of strideChunks columns, column by column
+    const unsigned long long rows = chunkCount / strideChunks;
+    uint4 accumulator = {0, 0, 0, 0};
+
+    if (group >= groupCount) {
+        return;
+    }
+    for (unsigned long long i = 0; i < loopCount; i++) {
+#pragma unroll 4
+        for (unsigned long long access = group; access < chunkCount; access += groupCount) {
+            unsigned long long chunk = random ? (access * ACCESS_RANDOM_MULTIPLIER) % chunkCount :
+                                                (access % rows) * strideChunks + access / rows;
+            uint4 value = src[chunk * elementsPerChunk + lane];
+            accumulator.x ^= value.x;
+            accumulator.y ^= value.y;
+            accumulator.z ^= value.z;
+            accumulator.w ^= value.w;
+        }
+    }
+    if (accumulator.x == 0x9E3779B9 && accumulator.y == accumulator.z && accumulator.w == accumulator.x) {
+        *sink = accumulator;
+    }
+}
+
+size_t accessPatternKernel(hipDeviceptr_t srcBuffer, size_t size, const AccessPattern &pattern, hipDeviceptr_t sink, hipStream_t stream,
+                           unsigned long long loopCount) {
+    assert(pattern.accessSize % sizeof(uint4) == 0 && pattern.accessSize / sizeof(uint4) <= numThreadPerBlock);
+    unsigned long long chunkCount = accessChunkCount(size, pattern);
+    unsigned int elementsPerChunk = pattern.accessSize / sizeof(uint4);
+    if (chunkCount == 0) {
+        return 0;
+    }
+    accessPatternKernelDevice<<<readWriteGrid(chunkCount * elementsPerChunk), numThreadPerBlock, 0, stream>>>(loopCount, (const uint4 *)srcBuffer, chunkCount,
+                                                                                                              elementsPerChunk, pattern.strideChunks,
+                                                                                                              pattern.random, (uint4 *)sink);
+    return chunkCount * pattern.accessSize;
 }
 
 __global__ void spinKernelDevice(volatile int *latch, const unsigned long long timeoutClocks)
@@ -143,13 +340,284 @@ hipError_t spinKernel(volatile int *latch, hipStream_t stream, unsigned long lon
     return hipSuccess;
 }
 
+__global__ void patternFillKernelDevice(uint4 *buffer, unsigned long long size, const uint4 *pattern) {
+    const unsigned long long patternSizeInElement = PATTERN_SIZE / sizeof(uint4);
+    const unsigned long long sizeInElement = size / sizeof(uint4);
+    const unsigned long long tid = blockIdx.x * blockDim.x + threadIdx.x;
+
+    for (unsigned long long idx = tid; idx < sizeInElement; idx += gridDim.x * blockDim.x) {
+        buffer[idx] = pattern[idx % patternSizeInElement];
+    }
+    // the pattern repeats every 2MB, so a partial tail continues it at the same offset
+    if (tid == 0) {
+        for (unsigned long long offset = sizeInElement * sizeof(uint4); offset < size; offset++) {
+            ((char *)buffer)[offset] = ((const char *)pattern)[offset % PATTERN_SIZE];
+        }
+    }
+}
+
+__global__ void patternCheckKernelDevice(const uint4 *buffer, unsigned long long size, const uint4 *pattern, PatternCheckResult *result) {
+    const unsigned long long patternSizeInElement = PATTERN_SIZE / sizeof(uint4);
+    const unsigned long long sizeInElement = size / sizeof(uint4);
+    const unsigned long long tid = blockIdx.x * blockDim.x + threadIdx.x;
+    unsigned long long mismatchedBytes = 0;
+    unsigned long long firstMismatchOffset = ~0ULL;
+
+    for (unsigned long long idx = tid; idx < sizeInElement; idx += gridDim.x * blockDim.x) {
+        uint4 actual = buffer[idx];
+        uint4 expected = pattern[idx % patternSizeInElement];
+        if (actual.x != expected.x || actual.y != expected.y || actual.z != expected.z || actual.w != expected.w) {
+            // mismatches are rare, the bytes of the vector are compared one by one to count them like the tail
+            const unsigned char *actualBytes = (const unsigned char *)&actual;
+            const unsigned char *expectedBytes = (const unsigned char *)&expected;
+            for (unsigned int b = 0; b < sizeof(uint4); b++) {
+                if (actualBytes[b] != expectedBytes[b]) {
+                    mismatchedBytes++;
+                    firstMismatchOffset = min(firstMismatchOffset, idx * sizeof(uint4) + b);
+                }
+            }
+        }
+    }
+    if (tid == 0) {
+        for (unsigned long long offset = sizeInElement * sizeof(uint4); offset < size; offset++) {
+            if (((const char *)buffer)[offset] != ((const char *)pattern)[offset % PATTERN_SIZE]) {
+                mismatchedBytes++;
+                firstMismatchOffset = min(firstMismatchOffset, offset);
+            }
+        }
+    }
+
+    // mismatches are rare, so only the threads that saw one touch the result
+    if (mismatchedBytes) {
+        atomicAdd(&result->mismatchedBytes, mismatchedBytes);
+        atomicMin(&result->firstMismatchOffset, firstMismatchOffset);
+    }
+}
+
+// Pattern kernels have no dependencies across the buffer, a few blocks per SM is enough to saturate the link
+static dim3 patternGridDim(unsigned long long size) {
+    hipDevice_t dev;
+    int numSm;
+
+    CU_ASSERT(hipCtxGetDevice(&dev));
+    CU_ASSERT(hipDeviceGetAttribute(&numSm, hipDeviceAttributeMultiprocessorCount, dev));
+
+    unsigned long long maxBlocks = (size / sizeof(uint4) + numThreadPerBlock - 1) / numThreadPerBlock;
+    return dim3((unsigned int)std::max(1ULL, std::min(maxBlocks, (unsigned long long)numSm * 4)));
+}
+
+void patternFillKernel(hipDeviceptr_t buffer, unsigned long long size, hipDeviceptr_t pattern, hipStream_t stream) {
+    patternFillKernelDevice<<<patternGridDim(size), numThreadPerBlock, 0, stream>>>((uint4 *)buffer, size, (const uint4 *)pattern);
+}
+
+void patternCheckKernel(hipDeviceptr_t buffer, unsigned long long size, hipDeviceptr_t pattern, PatternCheckResult *result, hipStream_t stream) {
+    patternCheckKernelDevice<<<patternGridDim(size), numThreadPerBlock, 0, stream>>>((const uint4 *)buffer, size, (const uint4 *)pattern, result);
+}
+
+__global__ void ptrChaseKernelDevice(const unsigned long long *chain, unsigned long long accessCount, unsigned long long *sink) {
+    const volatile unsigned long long *next = chain;
+    for (unsigned long long i = 0; i < accessCount; i++) {
+        next = (const volatile unsigned long long *)*next;
+    }
+    // keep the chain from being optimized away
+    *sink = (unsigned long long)next;
+}
+
+void ptrChaseKernel(hipDeviceptr_t chain, unsigned long long accessCount, hipDeviceptr_t sink, hipStream_t stream) {
+    ptrChaseKernelDevice<<<1, 1, 0, stream>>>((const unsigned long long *)chain, accessCount, (unsigned long long *)sink);
+}
+
+__global__ void pageTouchKernelDevice(const volatile unsigned int *buffer, unsigned long long pageCount, unsigned long long pageSizeInElement, unsigned int *sink) {
+    unsigned int value = 0;
+    for (unsigned long long page = blockIdx.x * blockDim.x + threadIdx.x; page < pageCount; page += gridDim.x * blockDim.x) {
+        value ^= buffer[page * pageSizeInElement];
+    }
+    // the loads are volatile, the store only keeps the value observable
+    if (value == 0xFFFFFFFF) {
+        *sink = value;
+    }
+}
+
+void pageTouchKernel(hipDeviceptr_t buffer, unsigned long long size, unsigned long long pageSize, hipDeviceptr_t sink, hipStream_t stream) {
+    unsigned long long pageCount = (size + pageSize - 1) / pageSize;
+    // faults are latency bound, so every page gets its own thread
+    unsigned long long blockCount = (pageCount + numThreadPerBlock - 1) / numThreadPerBlock;
+    pageTouchKernelDevice<<<(unsigned int)std::min(blockCount, 65535ULL), numThreadPerBlock, 0, stream>>>((const volatile unsigned int *)buffer, pageCount, pageSize / sizeof(unsigned int), (unsigned int *)sink);
+}
+
+// line size of the words targeted by the atomic kernels, so distinct words never share a cache line
+static const unsigned long long ATOMIC_STRIDE = 128;
+
+__global__ void atomicThroughputKernelDevice(unsigned int *buffer, AtomicOp op, unsigned long long wordCount, unsigned long long opsPerThread, unsigned int *sink) {
+    const unsigned long long tid = blockIdx.x * blockDim.x + threadIdx.x;
+    unsigned int *word = buffer + (tid % wordCount) * (ATOMIC_STRIDE / sizeof(unsigned int));
+    unsigned int value = 0;
+
+    if (op == ATOMIC_ADD) {
+        for (unsigned long long i = 0; i < opsPerThread; i++) {
+            value += atomicAdd_system(word, 1u);
+        }
+    } else {
+        for (unsigned long long i = 0; i < opsPerThread; i++) {
+            unsigned int old = atomicCAS_system(word, value, value + 1);
+            value = old == value ? value + 1 : old;
+        }
+    }
+    // the returned values keep the atomics from being issued without return
+    if (value == 0xFFFFFFFF) {
+        *sink = value;
+    }
+}
+
+unsigned long long atomicThroughputKernel(hipDeviceptr_t buffer, unsigned long long size, AtomicOp op, unsigned int contention,
+                                          unsigned long long opsPerThread, hipDeviceptr_t sink, hipStream_t stream) {
+    hipDevice_t dev;
+    int numSm;
+
+    CU_ASSERT(hipCtxGetDevice(&dev));
+    CU_ASSERT(hipDeviceGetAttribute(&numSm, hipDeviceAttributeMultiprocessorCount, dev));
+
+    // enough waves in flight per CU to hide the latency of remote atomics
+    unsigned long long threadCount = (unsigned long long)numSm * 4 * numThreadPerBlock;
+    unsigned long long wordCount = std::max(1ULL, std::min(threadCount / std::max(1u, contention), size / ATOMIC_STRIDE));
+    atomicThroughputKernelDevice<<<numSm * 4, numThreadPerBlock, 0, stream>>>((unsigned int *)buffer, op, wordCount, opsPerThread, (unsigned int *)sink);
+
+    return threadCount * opsPerThread;
+}
+
+__global__ void atomicLatencyKernelDevice(unsigned int *buffer, AtomicOp op, unsigned long long opCount, unsigned int *sink) {
+    unsigned int value = 0;
+
+    if (op == ATOMIC_ADD) {
+        for (unsigned long long i = 0; i < opCount; i++) {
+            value = atomicAdd_system(buffer, (value & 1) + 1);
+        }
+    } else {
+        // a failed attempt only happens when a previous sample left a different value
+        for (unsigned long long i = 0; i < opCount; i++) {
+            unsigned int old = atomicCAS_system(buffer, value, value + 1);
+            value = old == value ? value + 1 : old;
+        }
+    }
+    *sink = value;
+}
+
+void atomicLatencyKernel(hipDeviceptr_t buffer, AtomicOp op, unsigned long long opCount, hipDeviceptr_t sink, hipStream_t stream) {
+    atomicLatencyKernelDevice<<<1, 1, 0, stream>>>((unsigned int *)buffer, op, opCount, (unsigned int *)sink);
+}
+
+// LDS held by each block of the occupancy load, most of the 64 KiB of a CU so no second block fits next to it
+static const unsigned int OCCUPANCY_LOAD_LDS = 48 * 1024;
+static const unsigned int OCCUPANCY_LOAD_BLOCK_SIZE = 256;
+// FMAs of one ALU work unit per thread
+static const unsigned int ALU_LOAD_FMAS = 4096;
+
+__global__ void backgroundLoadKernelDevice(BackgroundLoadType load, volatile int *stop, volatile int *running, float4 *buffer, unsigned long long count,
+                                           unsigned long long *progress, const unsigned long long timeoutClocks) {
+    extern __shared__ float4 lds[];
+    __shared__ int stopped;
+    const unsigned long long endTime = clock64() + timeoutClocks;
+    const unsigned int ldsCount = OCCUPANCY_LOAD_LDS / sizeof(float4);
+    float4 value = make_float4((float)threadIdx.x, 1.0001f, 0.9999f, 1.0f);
+    unsigned long long units = 0;
+
+    if (load == LOAD_OCCUPANCY) {
+        for (unsigned int i = threadIdx.x; i < ldsCount; i += blockDim.x) {
+            lds[i] = value;
+        }
+    }
+    if (blockIdx.x == 0 && threadIdx.x == 0) {
+        *running = 1;
+    }
+
+    while (true) {
+        // a single thread polls the host flag, the others wait for its answer
+        if (threadIdx.x == 0) {
+            stopped = *stop || clock64() > endTime;
+        }
+        __syncthreads();
+        if (stopped) {
+            break;
+        }
+
+        if (load == LOAD_HBM) {
+            // one pass of the grid over the buffer per work unit
+            for (unsigned long long i = blockIdx.x * blockDim.x + threadIdx.x; i < count; i += (unsigned long long)gridDim.x * blockDim.x) {
+                float4 element = buffer[i];
+                element.x += 1.0f;
+                buffer[i] = element;
+            }
+        } else if (load == LOAD_ALU) {
+            for (unsigned int i = 0; i < ALU_LOAD_FMAS; i++) {
+                value.x = fmaf(value.x, value.y, value.z);
+                value.w = fmaf(value.w, value.z, value.y);
+            }
+        } else {
+            // every thread updates its neighbour's LDS entries, so the block is bound by LDS bandwidth
+            for (unsigned int i = threadIdx.x; i < ldsCount; i += blockDim.x) {
+                float4 neighbour = lds[(i + 1) % ldsCount];
+                lds[i].x = fmaf(neighbour.x, value.y, value.z);
+            }
+        }
+        units++;
+        // keeps thread 0 from overwriting stopped before every thread read it
+        __syncthreads();
+    }
+
+    if (threadIdx.x == 0) {
+        atomicAdd(progress, units);
+    }
+    // the results are used, so the work isn't optimized away
+    if (value.x == -1.0f || (load == LOAD_OCCUPANCY && lds[threadIdx.x].x == -1.0f)) {
+        buffer[0] = value;
+    }
+}
+
+void backgroundLoadKernel(BackgroundLoadType load, volatile int *stop, volatile int *running, hipDeviceptr_t buffer, unsigned long long size,
+                          unsigned long long *progress, hipStream_t stream, unsigned long long timeoutMs) {
+    hipDevice_t dev;
+    int numSm, clocksPerMs;
+
+    CU_ASSERT(hipCtxGetDevice(&dev));
+    CU_ASSERT(hipDeviceGetAttribute(&numSm, hipDeviceAttributeMultiprocessorCount, dev));
+    CU_ASSERT(hipDeviceGetAttribute(&clocksPerMs, hipDeviceAttributeClockRate, dev));
+    unsigned long long timeoutClocks = (unsigned long long)clocksPerMs * timeoutMs;
+
+    if (load == LOAD_OCCUPANCY) {
+        backgroundLoadKernelDevice<<<numSm, OCCUPANCY_LOAD_BLOCK_SIZE, OCCUPANCY_LOAD_LDS, stream>>>(load, stop, running, (float4 *)buffer,
+                                                                                                  size / sizeof(float4), progress, timeoutClocks);
+    } else {
+        // two blocks per CU leave wave slots for the spin kernel and the SM copy kernels
+        backgroundLoadKernelDevice<<<numSm * 2, numThreadPerBlock, 0, stream>>>(load, stop, running, (float4 *)buffer,
+                                                                                size / sizeof(float4), progress, timeoutClocks);
+    }
+}
+
+// Loading initializes the device, which takes a while on large GPUs, so every device loads from its own thread.
+// deviceCount only counts the devices left visible by --devices.
 void preloadKernels(int deviceCount)
 {
-    hipFuncAttributes unused;
+    std::vector<std::thread> loaders;
     for (int iDev = 0; iDev < deviceCount; iDev++) {
-        hipSetDevice(iDev);
-        hipFuncGetAttributes(&unused, &stridingMemcpyKernel);
-        hipFuncGetAttributes(&unused, &spinKernelDevice);
-        hipFuncGetAttributes(&unused, &simpleCopyKernel);
+        loaders.emplace_back([iDev]() {
+            hipFuncAttributes unused;
+            hipSetDevice(iDev);
+            preloadTunedCopyKernels<uint4>();
+            preloadTunedCopyKernels<uint2>();
+            hipFuncGetAttributes(&unused, &readKernelDevice);
+            hipFuncGetAttributes(&unused, &writeKernelDevice);
+            hipFuncGetAttributes(&unused, &accessPatternKernelDevice);
+            hipFuncGetAttributes(&unused, &spinKernelDevice);
+            hipFuncGetAttributes(&unused, &patternFillKernelDevice);
+            hipFuncGetAttributes(&unused, &patternCheckKernelDevice);
+            hipFuncGetAttributes(&unused, &ptrChaseKernelDevice);
+            hipFuncGetAttributes(&unused, &pageTouchKernelDevice);
+            hipFuncGetAttributes(&unused, &atomicThroughputKernelDevice);
+            hipFuncGetAttributes(&unused, &atomicLatencyKernelDevice);
+            hipFuncGetAttributes(&unused, &backgroundLoadKernelDevice);
+        });
+    }
+    for (std::thread &loader : loaders) {
+        loader.join();
     }
 }
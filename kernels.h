@@ -23,8 +23,109 @@
 
 const unsigned long long DEFAULT_SPIN_KERNEL_TIMEOUT_MS = 10000ULL;   // 10 seconds
 
-size_t copyKernel(hipDeviceptr_t dstBuffer, hipDeviceptr_t srcBuffer, size_t size, hipStream_t stream, unsigned long long loopCount);
+// Load/store cache policy of the SM copy kernel
+enum SmCacheHint {
+    SM_CACHE_DEFAULT,       // plain loads and stores
+    SM_CACHE_GLOBAL,        // __ldcg/__stcg, bypassing the non coherent caches
+    SM_CACHE_NONTEMPORAL    // nontemporal loads and stores, streaming past the caches
+};
+
+// Instantiation of the SM copy kernel template. Every field except blocksPerSm selects a compiled
+// instantiation, so values must come from the candidate lists below
+struct SmCopyConfig {
+    unsigned int vectorWidth;   // bytes moved by each load and store
+    unsigned int unroll;        // loads each thread keeps in flight before storing
+    unsigned int blockSize;     // threads per block
+    unsigned int blocksPerSm;   // blocks launched per CU
+    SmCacheHint cacheHint;
+
+    std::string toString() const;
+};
+
+const std::vector<unsigned int> smCopyVectorWidths = {8, 16};
+const std::vector<unsigned int> smCopyUnrolls = {4, 8, 12, 16};
+const std::vector<unsigned int> smCopyBlockSizes = {256, 512, 1024};
+const std::vector<unsigned int> smCopyBlocksPerSm = {1, 2, 4};
+const std::vector<SmCacheHint> smCopyCacheHints = {SM_CACHE_DEFAULT, SM_CACHE_GLOBAL, SM_CACHE_NONTEMPORAL};
+
+// 12 uint4 in flight per thread and one block of numThreadPerBlock threads per CU
+const SmCopyConfig defaultSmCopyConfig = {sizeof(uint4), 12, numThreadPerBlock, 1, SM_CACHE_DEFAULT};
+
+// Copies size bytes loopCount times with the config instantiation, returns the bytes actually copied
+size_t copyKernel(hipDeviceptr_t dstBuffer, hipDeviceptr_t srcBuffer, size_t size, hipStream_t stream, unsigned long long loopCount,
+                  const SmCopyConfig &config = defaultSmCopyConfig);
+// Bytes copyKernel copies out of size, the copy is truncated to a multiple of the vector width
+size_t copyKernelSize(size_t size, const SmCopyConfig &config = defaultSmCopyConfig);
+// Reads size bytes of src loopCount times and reduces them into registers, sink is only written to keep the loads.
+// Returns the bytes read per loop, the size truncated to a multiple of 16 bytes.
+size_t readKernel(hipDeviceptr_t srcBuffer, size_t size, hipDeviceptr_t sink, hipStream_t stream, unsigned long long loopCount);
+// Fills size bytes of dst loopCount times without reading memory, returns the bytes written per loop like readKernel
+size_t writeKernel(hipDeviceptr_t dstBuffer, size_t size, hipStream_t stream, unsigned long long loopCount);
+// Bytes readKernel and writeKernel access out of size
+size_t readWriteKernelSize(size_t size);
+// Scattered reads of accessSize byte chunks, like embedding lookups reading host or peer memory from a kernel.
+// strideChunks 1 reads the chunks in order, a larger stride visits every strideChunks-th chunk first and wraps around
+// until all of them are read, random visits them in a fixed pseudo random permutation.
+struct AccessPattern {
+    unsigned int accessSize;    // bytes of one access, a multiple of 16 read by accessSize / 16 cooperating threads
+    unsigned int strideChunks;  // distance between consecutive accesses in chunks
+    bool random;
+
+    std::string toString() const;
+};
+
+const std::vector<unsigned int> accessSweepSizes = {64, 128, 256, 512, 1024, 2048, 4096};
+// sequential, then larger strides, then random, one row each. The access size is filled in from accessSweepSizes
+const std::vector<AccessPattern> accessSweepPatterns = {{0, 1, false}, {0, 4, false}, {0, 64, false}, {0, 1, true}};
+
+// Reads the chunks of src in pattern loopCount times, returns the bytes read per loop. Chunks that don't
+// fill a whole stride at the end of the buffer are skipped.
+size_t accessPatternKernel(hipDeviceptr_t srcBuffer, size_t size, const AccessPattern &pattern, hipDeviceptr_t sink, hipStream_t stream,
+                           unsigned long long loopCount);
+// Bytes accessPatternKernel reads out of size
+size_t accessPatternKernelSize(size_t size, const AccessPattern &pattern);
 hipError_t spinKernel(volatile int *latch, hipStream_t stream, unsigned long long timeoutMs = DEFAULT_SPIN_KERNEL_TIMEOUT_MS);
 void preloadKernels(int deviceCount);
 
+// Follows accessCount links of the pointer chain starting at chain with a single thread, each load depends on the previous one
+void ptrChaseKernel(hipDeviceptr_t chain, unsigned long long accessCount, hipDeviceptr_t sink, hipStream_t stream);
+
+// Reads the first word of every pageSize bytes of buffer, one page per thread, to migrate managed pages on demand.
+// sink receives a value that depends on all loads.
+void pageTouchKernel(hipDeviceptr_t buffer, unsigned long long size, unsigned long long pageSize, hipDeviceptr_t sink, hipStream_t stream);
+
+// System scope atomic measured by the atomic kernels
+enum AtomicOp {
+    ATOMIC_ADD,     // atomicAdd_system of 1
+    ATOMIC_CAS      // atomicCAS_system from the last value seen to its successor, failed attempts count as operations
+};
+const std::vector<std::string> atomicOpNames = {"add", "CAS"};
+
+// Issues opsPerThread atomics from every thread of a grid filling the device onto the first size bytes of buffer.
+// Each word sits on its own 128 byte line and is shared by contention threads, or by more when there aren't enough
+// lines in size. Returns the number of atomics issued.
+unsigned long long atomicThroughputKernel(hipDeviceptr_t buffer, unsigned long long size, AtomicOp op, unsigned int contention,
+                                          unsigned long long opsPerThread, hipDeviceptr_t sink, hipStream_t stream);
+// Issues opCount atomics on the first word of buffer with a single thread, each operand depends on the previous result
+void atomicLatencyKernel(hipDeviceptr_t buffer, AtomicOp op, unsigned long long opCount, hipDeviceptr_t sink, hipStream_t stream);
+
+// Runs load with a grid sized for the device until *stop is set or timeoutMs passed, and sets *running once the
+// first block started. Every block adds the work units it completed to progress, a device counter.
+void backgroundLoadKernel(BackgroundLoadType load, volatile int *stop, volatile int *running, hipDeviceptr_t buffer, unsigned long long size,
+                          unsigned long long *progress, hipStream_t stream, unsigned long long timeoutMs = DEFAULT_SPIN_KERNEL_TIMEOUT_MS);
+
+// Size of the repeating xorshift pattern used to verify copies
+const unsigned long long PATTERN_SIZE = 2ull * 1024 * 1024;
+
+// Mismatch summary reduced by the pattern check kernel
+struct PatternCheckResult {
+    unsigned long long mismatchedBytes;     // bytes differing from the pattern
+    unsigned long long firstMismatchOffset; // byte offset of the first of them
+};
+
+// Fills size bytes of buffer by repeating the PATTERN_SIZE pattern, which must be resident on the launching device
+void patternFillKernel(hipDeviceptr_t buffer, unsigned long long size, hipDeviceptr_t pattern, hipStream_t stream);
+// Compares size bytes of buffer against the repeated pattern and accumulates the mismatches into result (device memory)
+void patternCheckKernel(hipDeviceptr_t buffer, unsigned long long size, hipDeviceptr_t pattern, PatternCheckResult *result, hipStream_t stream);
+
 #endif //NVBANDWIDTH__KERNELS_CUH
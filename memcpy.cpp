@@ -18,10 +18,31 @@
 
 #include <hip/hip_runtime.h>
 #include "memcpy.h"
+#include "hsa_backend.h"
 #include "kernels.h"
+#include "numa.h"
+#include "output.h"
 #include "hip/hip_vector_types.h"
 
+#include <barrier>
+#include <functional>
+#include <mutex>
+#include <typeinfo>
+#include <numeric>
+#include <random>
+#include <unistd.h>
+
 #define WARMUP_COUNT 4
+// Pointer chase hops are spread over the buffer in a random order, one per cache line, so neither
+// prefetching nor caching hides the access latency
+#define PTR_CHASE_STRIDE 128
+#define PTR_CHASE_ACCESSES_PER_LOOP 4096
+#define ROUND_TRIPS_PER_LOOP 256
+// Commands a latched section queues behind the spin kernel, well below the depth of the hardware queue of a stream.
+// A full queue blocks the host enqueueing until the spin kernel times out.
+#define MAX_LATCHED_COMMANDS 1024
+#define ATOMIC_OPS_PER_THREAD_PER_LOOP 8
+#define ATOMIC_LATENCY_OPS_PER_LOOP 256
 
 MemcpyNode::MemcpyNode(size_t bufferSize): bufferSize(bufferSize), buffer(nullptr) {}
 
@@ -32,81 +53,108 @@ hipDeviceptr_t MemcpyNode::getBuffer() const {
 size_t MemcpyNode::getBufferSize() const {
     return bufferSize;
 }
-void MemcpyNode::memsetPattern(hipDeviceptr_t buffer, unsigned long long size, unsigned int seed) {
-    unsigned int* pattern;
-    unsigned int n = 0;
-    void * _buffer = (void*) buffer;
-    unsigned long long _2MBchunkCount = size / (1024 * 1024 * 2);
-    unsigned long long remaining = size - (_2MBchunkCount * 1024 * 1024 * 2);
+std::map<std::pair<int, unsigned int>, hipDeviceptr_t> MemcpyNode::patternTables;
+std::map<int, PatternCheckResult*> MemcpyNode::patternCheckResults;
+
+hipDeviceptr_t MemcpyNode::getPatternTable(unsigned int seed) const {
+    auto key = std::make_pair(getOwnerDeviceIdx(), seed);
+    auto it = patternTables.find(key);
+    if (it != patternTables.end()) {
+        return it->second;
+    }
 
-    // Allocate 2MB of pattern
-    CU_ASSERT(hipHostAlloc((void**)&pattern, sizeof(char) * 1024 * 1024 * 2, hipHostMallocPortable));
+    hipDeviceptr_t table;
+    unsigned int* pattern = (unsigned int*)malloc(PATTERN_SIZE);
     xorshift2MBPattern(pattern, seed);
+    CU_ASSERT(hipMalloc(&table, PATTERN_SIZE));
+    CU_ASSERT(hipMemcpy(table, pattern, PATTERN_SIZE, hipMemcpyDefault));
+    free(pattern);
+
+    patternTables[key] = table;
+    return table;
+}
 
-    for (n = 0; n < _2MBchunkCount; n++) {
-        CU_ASSERT(cuMemcpy((hipDeviceptr_t)_buffer, (hipDeviceptr_t)pattern, 1024 * 1024 * 2));
-        _buffer = (char*)_buffer + (1024 * 1024 * 2);
+std::map<unsigned int, std::vector<unsigned int>> MemcpyNode::hostPatternTables;
+
+const std::vector<unsigned int> &MemcpyNode::getHostPatternTable(unsigned int seed) {
+    std::vector<unsigned int> &table = hostPatternTables[seed];
+    if (table.empty()) {
+        table.resize(PATTERN_SIZE / sizeof(unsigned int));
+        xorshift2MBPattern(table.data(), seed);
     }
-    if (remaining) {
-        CU_ASSERT(cuMemcpy((hipDeviceptr_t)_buffer, (hipDeviceptr_t)pattern, (size_t)remaining));
+    return table;
+}
+
+void MemcpyNode::memsetPattern(unsigned long long size, unsigned int seed) const {
+    if (!isKernelAccessible()) {
+        const char *pattern = (const char *)getHostPatternTable(seed).data();
+        for (unsigned long long offset = 0; offset < size; offset += PATTERN_SIZE) {
+            memcpy((char *)getBuffer() + offset, pattern, std::min(PATTERN_SIZE, size - offset));
+        }
+        return;
     }
 
+    CU_ASSERT(hipCtxSetCurrent(BufferPool::getPrimaryCtx(getOwnerDeviceIdx())));
+    patternFillKernel(getBuffer(), size, getPatternTable(seed), 0);
     CU_ASSERT(hipCtxSynchronize());
-    CU_ASSERT(hipHostFree((void*)pattern));
 }
 
-void MemcpyNode::memcmpPattern(hipDeviceptr_t buffer, unsigned long long size, unsigned int seed) {
-     unsigned int* devicePattern;
-    unsigned int* pattern;
-    unsigned long long _2MBchunkCount = size / (1024 * 1024 * 2);
-    unsigned long long remaining = size - (_2MBchunkCount * 1024 * 1024 * 2);
-    unsigned int n = 0;
-    unsigned int x = 0;
-    void * _buffer = (void*) buffer;
-
-    // Allocate 2MB of pattern
-    CU_ASSERT(hipHostAlloc((void**)&devicePattern, sizeof(char) * 1024 * 1024 * 2, hipHostMallocPortable));
-    pattern = (unsigned int*)malloc(sizeof(char) * 1024 * 1024 * 2);
-    xorshift2MBPattern(pattern, seed);
+void MemcpyNode::memcmpPattern(unsigned long long size, unsigned int seed) const {
+    PatternCheckResult result = {0, ~0ULL};
+    PatternCheckResult* deviceResult;
 
-    for (n = 0; n < _2MBchunkCount; n++) {
-        CU_ASSERT(cuMemcpy((hipDeviceptr_t)devicePattern, (hipDeviceptr_t)_buffer, 1024 * 1024 * 2));
-        CU_ASSERT(hipCtxSynchronize());
-        if (memcmp(pattern, devicePattern, 1024 * 1024 * 2) != 0) {
-            for (x = 0; x < (1024 * 1024 * 2) / sizeof(unsigned int); x++) {
-                if (devicePattern[x] != pattern[x]) {
-                    std::cout << " Invalid value when checking the pattern at <" << (void*)((char*)_buffer + n * (1024 * 1024 * 2) + x * sizeof(unsigned int)) << ">" << std::endl
-                                                        << " Current offset [ " << (unsigned long long)((char*)_buffer - (char*)buffer) + (unsigned long long)(x * sizeof(unsigned int)) << "/" << (size) << "]" << std::endl;
-                    std::abort();
-                }
-            
+    if (!isKernelAccessible()) {
+        const char *pattern = (const char *)getHostPatternTable(seed).data();
+        const char *data = (const char *)getBuffer();
+        for (unsigned long long offset = 0; offset < size; offset++) {
+            if (data[offset] != pattern[offset % PATTERN_SIZE]) {
+                result.mismatchedBytes++;
+                result.firstMismatchOffset = std::min(result.firstMismatchOffset, offset);
             }
         }
+    } else {
+        CU_ASSERT(hipCtxSetCurrent(BufferPool::getPrimaryCtx(getOwnerDeviceIdx())));
+        auto it = patternCheckResults.find(getOwnerDeviceIdx());
+        if (it != patternCheckResults.end()) {
+            deviceResult = it->second;
+        } else {
+            CU_ASSERT(hipMalloc((hipDeviceptr_t*)&deviceResult, sizeof(*deviceResult)));
+            patternCheckResults[getOwnerDeviceIdx()] = deviceResult;
+        }
 
-        _buffer = (char*)_buffer + (1024 * 1024 * 2);
+        CU_ASSERT(hipMemcpy(deviceResult, &result, sizeof(result), hipMemcpyDefault));
+        patternCheckKernel(getBuffer(), size, getPatternTable(seed), deviceResult, 0);
+        CU_ASSERT(hipMemcpy(&result, deviceResult, sizeof(result), hipMemcpyDefault));
     }
-    if (remaining) {
-        CU_ASSERT(cuMemcpy((hipDeviceptr_t)devicePattern, (hipDeviceptr_t)_buffer, (size_t)remaining));
-        if (memcmp(pattern, devicePattern, (size_t)remaining) != 0) {
-            for (x = 0; x < remaining / sizeof(unsigned int); x++) {
-                if (devicePattern[x] != pattern[x]) {
-                    std::cout << " Invalid value when checking the pattern at <" << (void*)((char*)buffer + n * (1024 * 1024 * 2) + x * sizeof(unsigned int)) << ">" << std::endl
-                                                        << " Current offset [ " << (unsigned long long)((char*)_buffer - (char*)buffer) + (unsigned long long)(x * sizeof(unsigned int)) << "/" << (size) << "]" << std::endl;
-                    std::abort();
-                }
-            }
-        }
+
+    if (result.mismatchedBytes) {
+        std::cout << " Invalid value when checking the pattern at <" << (void*)((char*)getBuffer() + result.firstMismatchOffset) << ">" << std::endl
+                  << " Current offset [ " << result.firstMismatchOffset << "/" << size << "]" << std::endl
+                  << " " << result.mismatchedBytes << " mismatching bytes in " << getNodeString() << std::endl;
+        std::abort();
     }
+}
 
-    CU_ASSERT(hipCtxSynchronize());
-    CU_ASSERT(hipHostFree((void*)devicePattern));
-    free(pattern);
+void MemcpyNode::freePatternResources() {
+    for (auto &entry : patternTables) {
+        CU_ASSERT(hipCtxSetCurrent(BufferPool::getPrimaryCtx(entry.first.first)));
+        CU_ASSERT(hipFree(entry.second));
+    }
+    patternTables.clear();
+
+    for (auto &entry : patternCheckResults) {
+        CU_ASSERT(hipCtxSetCurrent(BufferPool::getPrimaryCtx(entry.first)));
+        CU_ASSERT(hipFree((hipDeviceptr_t)entry.second));
+    }
+    patternCheckResults.clear();
+    hostPatternTables.clear();
 }
+
 void MemcpyNode::xorshift2MBPattern(unsigned int* buffer, unsigned int seed)
 {
     unsigned int oldValue = seed;
     unsigned int n = 0;
-    for (n = 0; n < (1024 * 1024 * 2) / sizeof(unsigned int); n++) {
+    for (n = 0; n < PATTERN_SIZE / sizeof(unsigned int); n++) {
         unsigned int value = oldValue;
         value = value ^ (value << 13);
         value = value ^ (value >> 17);
@@ -115,23 +163,207 @@ void MemcpyNode::xorshift2MBPattern(unsigned int* buffer, unsigned int seed)
         buffer[n] = oldValue;
     }
 }
-HostNode::HostNode(size_t bufferSize, int targetDeviceId): MemcpyNode(bufferSize) {
-    hipCtx_t targetCtx;
+std::map<BufferPool::Key, std::vector<void*>> BufferPool::freeBuffers;
+std::map<void*, BufferPool::Key> BufferPool::leasedBuffers;
+std::map<int, hipCtx_t> BufferPool::primaryCtxs;
+
+void* BufferPool::lease(const Key &key) {
+    void* buffer = nullptr;
+    std::vector<void*> &buffers = freeBuffers[key];
 
-    // Before allocating host memory, set correct NUMA affinity
-    setOptimalCpuAffinity(targetDeviceId);
-    CU_ASSERT(hipDevicePrimaryCtxRetain(&targetCtx, targetDeviceId));
-    CU_ASSERT(hipCtxSetCurrent(targetCtx));
+    if (!buffers.empty()) {
+        buffer = buffers.back();
+        buffers.pop_back();
+    } else {
+        bool isHost = std::get<0>(key);
+        int deviceIdx = std::get<1>(key);
+        hipError_t res;
 
-    CU_ASSERT(hipHostAlloc(&buffer, bufferSize, hipHostMallocPortable));
+        res = allocate(key, &buffer);
+        if (res == hipErrorOutOfMemory) {
+            // idle buffers of other size classes may be holding the memory, give it back and retry once
+            trim(isHost, deviceIdx);
+            res = allocate(key, &buffer);
+        }
+        // only the testcase fails, the next ones may need less memory
+        if (res == hipErrorOutOfMemory) {
+            throw std::string("Out of ") + (isHost ? "host" : "device " + std::to_string(deviceIdx)) + " memory for a buffer of " +
+                  std::to_string(std::get<2>(key)) + " bytes, lower --bufferSize or --fillFraction";
+        }
+        CU_ASSERT(res);
+    }
+
+    leasedBuffers[buffer] = key;
+    return buffer;
 }
 
-HostNode::~HostNode() {
-    if (isMemoryOwnedByCUDA(buffer)) {
-        CU_ASSERT(hipHostFree(buffer));
+hipError_t BufferPool::allocate(const Key &key, void** buffer) {
+    bool isHost = std::get<0>(key);
+    size_t size = std::get<2>(key);
+    // explicitly placed buffers follow the memory policy bound for the allocation instead of the device's closest node
+    int numaNode = std::get<4>(key);
+    unsigned int numaFlags = numaNode >= 0 ? hipHostMallocNumaUser : 0;
+
+    CU_ASSERT(hipCtxSetCurrent(getPrimaryCtx(std::get<1>(key))));
+    if (!isHost) {
+        if (std::get<5>(key) == DEVICE_MEM_FINE_GRAINED) {
+            return hipExtMallocWithFlags(buffer, size, hipDeviceMallocFinegrained);
+        }
+        return hipMalloc((hipDeviceptr_t*)buffer, size);
+    }
+
+    // only the explicit node's allocation is bound, later allocations of the thread keep its own policy
+    std::unique_ptr<NumaMemoryBinding> binding;
+    if (numaNode >= 0 && std::get<3>(key) != HOST_MEM_HSA) {
+        binding.reset(new NumaMemoryBinding(numaNode));
+        if (!binding->isBound()) {
+            return hipErrorInvalidValue;
+        }
+    }
+
+    switch (std::get<3>(key)) {
+        case HOST_MEM_REGISTERED:
+        case HOST_MEM_PAGEABLE: {
+            // page aligned like the buffers frameworks register, memory is placed on first touch by the affinitized
+            // thread, or on the explicit node whoever touches it first
+            size_t pageSize = sysconf(_SC_PAGESIZE);
+            *buffer = aligned_alloc(pageSize, ROUND_UP(size, pageSize));
+            if (*buffer == nullptr) {
+                return hipErrorOutOfMemory;
+            }
+            if (numaNode >= 0 && !bindBufferToNumaNode(*buffer, ROUND_UP(size, pageSize), numaNode)) {
+                free(*buffer);
+                return hipErrorInvalidValue;
+            }
+            if (std::get<3>(key) == HOST_MEM_PAGEABLE) {
+                return hipSuccess;
+            }
+            // ROCm maps registered memory at the same address on the device
+            hipError_t res = hipHostRegister(*buffer, size, hipHostRegisterPortable | hipHostRegisterMapped);
+            if (res != hipSuccess) {
+                free(*buffer);
+            }
+            return res;
+        }
+        case HOST_MEM_COHERENT:
+            return hipHostMalloc(buffer, size, hipHostMallocPortable | hipHostMallocCoherent | numaFlags);
+        case HOST_MEM_NONCOHERENT:
+            return hipHostMalloc(buffer, size, hipHostMallocPortable | hipHostMallocNonCoherent | numaFlags);
+        case HOST_MEM_MANAGED:
+            return hipMallocManaged(buffer, size, hipMemAttachGlobal);
+        case HOST_MEM_HSA:
+            return hsaHostAlloc(buffer, size, numaNode >= 0 ? numaNode : getDeviceNumaNode(std::get<1>(key)));
+        case HOST_MEM_PINNED:
+        default:
+            return hipHostAlloc(buffer, size, hipHostMallocPortable | numaFlags);
+    }
+}
+
+void BufferPool::deallocate(const Key &key, void* buffer) {
+    CU_ASSERT(hipCtxSetCurrent(getPrimaryCtx(std::get<1>(key))));
+    if (!std::get<0>(key)) {
+        CU_ASSERT(hipFree((hipDeviceptr_t)buffer));
+        return;
+    }
+
+    switch (std::get<3>(key)) {
+        case HOST_MEM_REGISTERED:
+            CU_ASSERT(hipHostUnregister(buffer));
+            free(buffer);
+            break;
+        case HOST_MEM_PAGEABLE:
+            free(buffer);
+            break;
+        case HOST_MEM_MANAGED:
+            CU_ASSERT(hipFree((hipDeviceptr_t)buffer));
+            break;
+        case HOST_MEM_HSA:
+            hsaHostFree(buffer);
+            break;
+        default:
+            CU_ASSERT(hipHostFree(buffer));
+    }
+}
+
+void* BufferPool::leaseHostBuffer(size_t size, int targetDeviceId, HostMemType memType, int numaNode) {
+    return lease(Key(true, targetDeviceId, size, memType, numaNode, DEVICE_MEM_COARSE_GRAINED));
+}
+
+void* BufferPool::leaseDeviceBuffer(size_t size, int deviceIdx, bool fineGrained) {
+    return lease(Key(false, deviceIdx, size, HOST_MEM_PINNED, -1, fineGrained ? DEVICE_MEM_FINE_GRAINED : DEVICE_MEM_COARSE_GRAINED));
+}
+
+// Managed buffers share the host managed size classes, the device only picks the allocating context
+void* BufferPool::leaseManagedBuffer(size_t size, int deviceIdx) {
+    return lease(Key(true, deviceIdx, size, HOST_MEM_MANAGED, -1, DEVICE_MEM_COARSE_GRAINED));
+}
+
+void BufferPool::release(void* buffer) {
+    auto it = leasedBuffers.find(buffer);
+    assert(it != leasedBuffers.end());
+    freeBuffers[it->second].push_back(buffer);
+    leasedBuffers.erase(it);
+}
+
+void BufferPool::trim(bool isHost, int deviceIdx) {
+    for (auto &entry : freeBuffers) {
+        if (std::get<0>(entry.first) != isHost || (!isHost && std::get<1>(entry.first) != deviceIdx)) {
+            continue;
+        }
+        for (void* buffer : entry.second) {
+            deallocate(entry.first, buffer);
+        }
+        entry.second.clear();
+    }
+}
+
+hipCtx_t BufferPool::getPrimaryCtx(int deviceIdx) {
+    auto it = primaryCtxs.find(deviceIdx);
+    if (it != primaryCtxs.end()) {
+        return it->second;
+    }
+
+    hipCtx_t ctx;
+    CU_ASSERT(hipDevicePrimaryCtxRetain(&ctx, deviceIdx));
+    primaryCtxs[deviceIdx] = ctx;
+    return ctx;
+}
+
+void BufferPool::clear() {
+    // nodes must have returned their buffers before the pool goes away
+    assert(leasedBuffers.empty());
+
+    trim(true, 0);
+    for (auto &entry : primaryCtxs) {
+        trim(false, entry.first);
+    }
+    freeBuffers.clear();
+
+    for (auto &entry : primaryCtxs) {
+        CU_ASSERT(hipDevicePrimaryCtxRelease(entry.first));
+    }
+    primaryCtxs.clear();
+}
+
+HostNode::HostNode(size_t bufferSize, int targetDeviceId, HostMemType memType, int numaNode): MemcpyNode(bufferSize), targetDeviceId(targetDeviceId), memType(memType), numaNode(numaNode) {
+    // Before allocating host memory, run on the CPUs of the NUMA node the buffer is copied from,
+    // BufferPool places explicitly requested nodes itself
+    if (numaNode >= 0) {
+        if (!bindToNumaNode(numaNode)) {
+            std::stringstream errmsg;
+            errmsg << "Can't bind to NUMA node " << numaNode;
+            throw errmsg.str();
+        }
     } else {
-        free(buffer);
+        setOptimalCpuAffinity(targetDeviceId);
     }
+    CU_ASSERT(hipCtxSetCurrent(BufferPool::getPrimaryCtx(targetDeviceId)));
+
+    buffer = BufferPool::leaseHostBuffer(bufferSize, targetDeviceId, memType, numaNode);
+}
+
+HostNode::~HostNode() {
+    BufferPool::release(buffer);
 }
 
 // Host nodes don't have a context, return null
@@ -148,16 +380,31 @@ std::string HostNode::getNodeString() const {
     return "Host";
 }
 
-DeviceNode::DeviceNode(size_t bufferSize, int deviceIdx): deviceIdx(deviceIdx), MemcpyNode(bufferSize) {
-    CU_ASSERT(hipDevicePrimaryCtxRetain(&primaryCtx, deviceIdx));
+bool HostNode::isKernelAccessible() const {
+    return memType != HOST_MEM_PAGEABLE;
+}
+
+bool HostNode::isPageable() const {
+    return memType == HOST_MEM_PAGEABLE;
+}
+
+HostMemType HostNode::getMemType() const {
+    return memType;
+}
+
+// Host buffers are verified by the device they were allocated for
+int HostNode::getOwnerDeviceIdx() const {
+    return targetDeviceId;
+}
+
+DeviceNode::DeviceNode(size_t bufferSize, int deviceIdx, bool fineGrained): deviceIdx(deviceIdx), MemcpyNode(bufferSize) {
+    primaryCtx = BufferPool::getPrimaryCtx(deviceIdx);
     CU_ASSERT(hipCtxSetCurrent(primaryCtx));
-    CU_ASSERT(hipMalloc((hipDeviceptr_t*)&buffer, bufferSize));
+    buffer = BufferPool::leaseDeviceBuffer(bufferSize, deviceIdx, fineGrained);
 }
 
 DeviceNode::~DeviceNode() {
-    CU_ASSERT(hipCtxSetCurrent(primaryCtx));
-    CU_ASSERT(hipFree((hipDeviceptr_t)buffer));
-    CU_ASSERT(hipDevicePrimaryCtxRelease(deviceIdx));
+    BufferPool::release(buffer);
 }
 
 hipCtx_t DeviceNode::getPrimaryCtx() const {
@@ -172,6 +419,10 @@ std::string DeviceNode::getNodeString() const {
     return "Device " + std::to_string(deviceIdx);
 }
 
+int DeviceNode::getOwnerDeviceIdx() const {
+    return deviceIdx;
+}
+
 bool DeviceNode::enablePeerAcess(const DeviceNode &peerNode) {
     int canAccessPeer = 0;
     CU_ASSERT(hipDeviceCanAccessPeer(&canAccessPeer, getNodeIdx(), peerNode.getNodeIdx()));
@@ -192,6 +443,102 @@ bool DeviceNode::enablePeerAcess(const DeviceNode &peerNode) {
     return false;
 }
 
+ManagedNode::ManagedNode(size_t bufferSize, int homeDeviceId, int ownerDeviceId): MemcpyNode(bufferSize), homeDeviceId(homeDeviceId), ownerDeviceId(ownerDeviceId) {
+    if (homeDeviceId == hipCpuDeviceId) {
+        setOptimalCpuAffinity(ownerDeviceId);
+    }
+    buffer = BufferPool::leaseManagedBuffer(bufferSize, ownerDeviceId);
+}
+
+ManagedNode::~ManagedNode() {
+    BufferPool::release(buffer);
+}
+
+// Managed memory has no context of its own, copies run from the other node's context
+hipCtx_t ManagedNode::getPrimaryCtx() const {
+    return nullptr;
+}
+
+int ManagedNode::getNodeIdx() const {
+    return homeDeviceId == hipCpuDeviceId ? 0 : homeDeviceId;
+}
+
+std::string ManagedNode::getNodeString() const {
+    return homeDeviceId == hipCpuDeviceId ? "Managed Host" : "Managed Device " + std::to_string(homeDeviceId);
+}
+
+int ManagedNode::getOwnerDeviceIdx() const {
+    return ownerDeviceId;
+}
+
+void ManagedNode::memsetPattern(unsigned long long size, unsigned int seed) const {
+    MemcpyNode::memsetPattern(size, seed);
+
+    // the fill kernel pulled the pages to the owner, every sample has to start from home
+    CU_ASSERT(hipCtxSetCurrent(BufferPool::getPrimaryCtx(ownerDeviceId)));
+    CU_ASSERT(hipMemPrefetchAsync(getBuffer(), getBufferSize(), homeDeviceId, 0));
+    CU_ASSERT(hipCtxSynchronize());
+}
+
+BackgroundLoad::BackgroundLoad(BackgroundLoadType type, int deviceIdx) :
+        type(type), deviceIdx(deviceIdx), node(type == LOAD_HBM ? BACKGROUND_LOAD_BUFFER_SIZE : PATTERN_SIZE, deviceIdx) {
+    CU_ASSERT(hipCtxSetCurrent(node.getPrimaryCtx()));
+    CU_ASSERT(hipStreamCreateWithFlags(&stream, hipStreamNonBlocking));
+    CU_ASSERT(hipEventCreateWithFlags(&startEvent, hipEventDefault));
+    CU_ASSERT(hipEventCreateWithFlags(&endEvent, hipEventDefault));
+    CU_ASSERT(hipMalloc((void **)&progress, sizeof(*progress)));
+    CU_ASSERT(hipHostAlloc((void **)&control, 2 * sizeof(*control), hipHostMallocPortable));
+}
+
+BackgroundLoad::~BackgroundLoad() {
+    CU_ASSERT(hipCtxSetCurrent(node.getPrimaryCtx()));
+    CU_ASSERT(hipHostFree((void *)control));
+    CU_ASSERT(hipFree(progress));
+    CU_ASSERT(hipEventDestroy(endEvent));
+    CU_ASSERT(hipEventDestroy(startEvent));
+    CU_ASSERT(hipStreamDestroy(stream));
+}
+
+void BackgroundLoad::start() {
+    hipCtx_t previousCtx;
+    CU_ASSERT(hipCtxGetCurrent(&previousCtx));
+    CU_ASSERT(hipCtxSetCurrent(node.getPrimaryCtx()));
+
+    control[0] = 0;
+    control[1] = 0;
+    CU_ASSERT(hipMemsetAsync(progress, 0, sizeof(*progress), stream));
+    CU_ASSERT(hipEventRecord(startEvent, stream));
+    backgroundLoadKernel(type, &control[0], &control[1], node.getBuffer(), node.getBufferSize(), progress, stream);
+    CU_ASSERT(hipEventRecord(endEvent, stream));
+
+    // the copies must not be released before the load occupies the device, unless it already timed out
+    while (!control[1] && hipStreamQuery(stream) == hipErrorNotReady);
+    CU_ASSERT(hipCtxSetCurrent(previousCtx));
+}
+
+void BackgroundLoad::stop() {
+    control[0] = 1;
+    CU_ASSERT(hipStreamSynchronize(stream));
+
+    unsigned long long completed = 0;
+    float elapsed = 0.0f;
+    CU_ASSERT(hipMemcpy(&completed, progress, sizeof(completed), hipMemcpyDeviceToHost));
+    CU_ASSERT(hipEventElapsedTime(&elapsed, startEvent, endEvent));
+    units += completed;
+    seconds += elapsed * 1e-3;
+}
+
+void BackgroundLoad::runAlone(double runSeconds) {
+    start();
+    std::this_thread::sleep_for(std::chrono::duration<double>(runSeconds));
+    stop();
+}
+
+void BackgroundLoad::reset() {
+    units = 0;
+    seconds = 0.0;
+}
+
 MemcpyOperation::MemcpyOperation(unsigned long long loopCount, ContextPreference ctxPreference, BandwidthValue bandwidthValue) : 
         loopCount(loopCount), ctxPreference(ctxPreference), bandwidthValue(bandwidthValue)
 {
@@ -209,115 +556,439 @@ double MemcpyOperation::doMemcpy(const MemcpyNode &srcNode, const MemcpyNode &ds
     return doMemcpy(srcNodes, dstNodes);
 }
 
+std::map<hipCtx_t, MemcpyOperation::ContextArena> MemcpyOperation::arenas;
+volatile int* MemcpyOperation::blockingVar = nullptr;
+std::map<MemcpyOperation::GraphKey, MemcpyOperation::CapturedCopies> MemcpyOperation::capturedCopies;
+std::mutex MemcpyOperation::capturedCopiesMutex;
+
+void MemcpyOperation::freeArenas() {
+    for (auto &entry : capturedCopies) {
+        CU_ASSERT(hipGraphExecDestroy(entry.second.exec));
+    }
+    capturedCopies.clear();
+
+    for (auto &entry : arenas) {
+        ContextArena &arena = entry.second;
+        CU_ASSERT(hipCtxSetCurrent(entry.first));
+        for (int i = 0; i < arena.streams.size(); i++) {
+            CU_ASSERT(hipStreamDestroy(arena.streams[i]));
+            CU_ASSERT(hipEventDestroy(arena.startEvents[i]));
+            CU_ASSERT(hipEventDestroy(arena.endEvents[i]));
+            for (hipEvent_t event : arena.iterationEvents[i]) {
+                CU_ASSERT(hipEventDestroy(event));
+            }
+        }
+        if (arena.totalEnd) {
+            CU_ASSERT(hipEventDestroy(arena.totalEnd));
+        }
+    }
+    arenas.clear();
+
+    if (blockingVar) {
+        CU_ASSERT(hipHostFree((void*)blockingVar));
+        blockingVar = nullptr;
+    }
+}
+
+void MemcpyOperation::reserveArenaSlot(ContextArena &arena, size_t slot) {
+    while (arena.streams.size() <= slot) {
+        size_t created = arena.streams.size();
+        arena.streams.emplace_back();
+        arena.startEvents.emplace_back();
+        arena.endEvents.emplace_back();
+        arena.iterationEvents.emplace_back();
+        CU_ASSERT(hipStreamCreateWithFlags(&arena.streams[created], hipStreamNonBlocking));
+        CU_ASSERT(hipEventCreateWithFlags(&arena.startEvents[created], hipEventDefault));
+        CU_ASSERT(hipEventCreateWithFlags(&arena.endEvents[created], hipEventDefault));
+    }
+}
+
+volatile int* MemcpyOperation::getBlockingVar() {
+    if (!blockingVar) {
+        CU_ASSERT(hipHostAlloc((void **)&blockingVar, sizeof(*blockingVar), hipHostMallocPortable));
+    }
+    return blockingVar;
+}
+
 double MemcpyOperation::doMemcpy(const std::vector<const MemcpyNode*> &srcNodes, const std::vector<const MemcpyNode*> &dstNodes) {
-    volatile int* blockingVar;
-    std::vector<hipCtx_t> contexts(srcNodes.size());
-    std::vector<hipStream_t> streams(srcNodes.size());
-    std::vector<hipEvent_t> startEvents(srcNodes.size());
-    std::vector<hipEvent_t> endEvents(srcNodes.size());
-    std::vector<PerformanceStatistic> bandwidthStats(srcNodes.size());
-    std::vector<size_t> adjustedCopySizes(srcNodes.size());
-    PerformanceStatistic totalBandwidth;
-    hipEvent_t totalEnd;
-    std::vector<size_t> finalCopySize(srcNodes.size());
+    CopyResources resources;
+    resources.contexts.resize(srcNodes.size());
+    resources.streams.resize(srcNodes.size());
+    resources.startEvents.resize(srcNodes.size());
+    resources.endEvents.resize(srcNodes.size());
+    resources.slots.resize(srcNodes.size());
+    // number of arena streams of each context already handed out to this call
+    std::map<hipCtx_t, size_t> arenaUsage;
 
-    CU_ASSERT(hipHostAlloc((void **)&blockingVar, sizeof(*blockingVar), hipHostMallocPortable));
+    resources.blockingVar = getBlockingVar();
 
     for (int i = 0; i < srcNodes.size(); i++) {
         // prefer source context
         if (ctxPreference == MemcpyOperation::PREFER_SRC_CONTEXT && srcNodes[i]->getPrimaryCtx() != nullptr) {
             CU_ASSERT(hipCtxSetCurrent(srcNodes[i]->getPrimaryCtx()));
-            contexts[i] = srcNodes[i]->getPrimaryCtx();
+            resources.contexts[i] = srcNodes[i]->getPrimaryCtx();
         } else if (dstNodes[i]->getPrimaryCtx() != nullptr) {
             CU_ASSERT(hipCtxSetCurrent(dstNodes[i]->getPrimaryCtx()));
-            contexts[i] = dstNodes[i]->getPrimaryCtx();
+            resources.contexts[i] = dstNodes[i]->getPrimaryCtx();
         }
 
-        // allocate the per simulaneous copy resources
-        CU_ASSERT(hipStreamCreateWithFlags(&streams[i], hipStreamNonBlocking));
-        CU_ASSERT(hipEventCreateWithFlags(&startEvents[i], hipEventDefault));
-        CU_ASSERT(hipEventCreateWithFlags(&endEvents[i], hipEventDefault));
+        // take the per simulaneous copy resources from the context's arena, growing it when needed
+        ContextArena &arena = arenas[resources.contexts[i]];
+        size_t slot = arenaUsage[resources.contexts[i]]++;
+        reserveArenaSlot(arena, slot);
+        resources.streams[i] = arena.streams[slot];
+        resources.startEvents[i] = arena.startEvents[slot];
+        resources.endEvents[i] = arena.endEvents[slot];
+        resources.slots[i] = slot;
+    }
+    CU_ASSERT(hipCtxSetCurrent(resources.contexts[0]));
+    ContextArena &firstArena = arenas[resources.contexts[0]];
+    if (!firstArena.totalEnd) {
+        CU_ASSERT(hipEventCreateWithFlags(&firstArena.totalEnd, hipEventDefault));
+    }
+    resources.totalEnd = firstArena.totalEnd;
+
+    return measureSizes(srcNodes, dstNodes, [&](const std::vector<size_t> &copySizes) {
+        return measureBandwidth(srcNodes, dstNodes, copySizes, resources);
+    });
+}
+
+double MemcpyOperation::measureSizes(const std::vector<const MemcpyNode*> &srcNodes, const std::vector<const MemcpyNode*> &dstNodes,
+                                     const std::function<double(const std::vector<size_t> &)> &measure) {
+    std::vector<size_t> copySizes(srcNodes.size());
+    double result = 0.0;
+
+    if (sweepSizes.empty()) {
+        for (int i = 0; i < srcNodes.size(); i++) {
+            copySizes[i] = srcNodes[i]->getBufferSize();
+        }
+        result = measure(copySizes);
+    } else {
+        // Buffers are allocated for the largest sweep size, every smaller size copies a sub-range of them.
+        // Interference copies keep their size ratio to the measured copy at every step.
+        // the table shows the bandwidth the measurement reports, which is only the first copy's with USE_FIRST_BW
+        std::string copyList = srcNodes[0]->getNodeString() + " -> " + dstNodes[0]->getNodeString();
+        if (srcNodes.size() > 1) {
+            std::string copyCount = std::to_string(srcNodes.size()) + " simultaneous copies";
+            copyList = bandwidthValue == BandwidthValue::SUM_BW ? "sum of the bandwidths of " + copyCount + " from " + copyList :
+                       bandwidthValue == BandwidthValue::TOTAL_BW ? "total bandwidth of " + copyCount + " from " + copyList :
+                       copyList + ", first of " + copyCount;
+        }
+        std::cout << "\t" << copyList << " sweep:" << std::endl;
+        std::cout << "\t" << std::setw(16) << "Size (bytes)" << std::setw(18) << "Bandwidth (GB/s)" << std::endl;
+        for (unsigned long long sweepSize : sweepSizes) {
+            if (sweepSize > srcNodes[0]->getBufferSize()) {
+                break;
+            }
+            for (int i = 0; i < srcNodes.size(); i++) {
+                copySizes[i] = sweepSize * (srcNodes[i]->getBufferSize() / srcNodes[0]->getBufferSize());
+            }
+            result = measure(copySizes);
+            std::cout << "\t" << std::setw(16) << sweepSize << std::setw(18) << std::fixed << std::setprecision(2) << result << std::endl;
+        }
+    }
+
+    return result;
+}
+
+size_t MemcpyOperation::enqueueCopies(hipDeviceptr_t dst, hipDeviceptr_t src, hipStream_t stream, size_t copySize, unsigned long long count) {
+    // a single copy has no launch overhead to amortize
+    if (!useGraphs || count <= 1) {
+        return memcpyFunc(dst, src, stream, copySize, count);
+    }
+
+    GraphKey key(typeid(*this).name() + ("/" + graphParameters()), stream, dst, src, copySize, count);
+    // --parallelEnqueue workers capture concurrently, each on its own stream, the lock only guards the map
+    CapturedCopies captured;
+    bool found = false;
+    {
+        std::lock_guard<std::mutex> lock(capturedCopiesMutex);
+        auto it = capturedCopies.find(key);
+        if (it != capturedCopies.end()) {
+            captured = it->second;
+            found = true;
+        }
+    }
+    if (!found) {
+        // Capturing doesn't execute anything, so it doesn't matter that the stream is held by the spin kernel
+        hipGraph_t graph;
+        CU_ASSERT(hipStreamBeginCapture(stream, hipStreamCaptureModeThreadLocal));
+        captured.copiedBytes = memcpyFunc(dst, src, stream, copySize, count);
+        CU_ASSERT(hipStreamEndCapture(stream, &graph));
+        CU_ASSERT(hipGraphInstantiate(&captured.exec, graph, nullptr, nullptr, 0));
+        CU_ASSERT(hipGraphDestroy(graph));
+
+        std::lock_guard<std::mutex> lock(capturedCopiesMutex);
+        auto inserted = capturedCopies.emplace(key, captured);
+        if (!inserted.second) {
+            // another worker captured the same copies meanwhile, its graph is kept
+            CU_ASSERT(hipGraphExecDestroy(captured.exec));
+            captured = inserted.first->second;
+        }
+    }
+
+    CU_ASSERT(hipGraphLaunch(captured.exec, stream));
+    return captured.copiedBytes;
+}
+
+std::vector<hipEvent_t> &MemcpyOperation::getIterationEvents(const CopyResources &resources, int copy, unsigned long long count) {
+    std::vector<hipEvent_t> &events = arenas[resources.contexts[copy]].iterationEvents[resources.slots[copy]];
+    while (events.size() < count) {
+        events.emplace_back();
+        CU_ASSERT(hipEventCreateWithFlags(&events.back(), hipEventDefault));
+    }
+    return events;
+}
+
+unsigned long long MemcpyOperation::getWarmupCount() const {
+    return WARMUP_COUNT;
+}
+
+unsigned long long MemcpyOperation::getTimedLoopCount() const {
+    return loopCount;
+}
+
+const std::vector<double> &MemcpyOperation::getCopyBandwidths() const {
+    return copyBandwidths;
+}
+
+double MemcpyOperation::measureBandwidth(const std::vector<const MemcpyNode*> &srcNodes, const std::vector<const MemcpyNode*> &dstNodes,
+                                         const std::vector<size_t> &copySizes, CopyResources &resources) {
+    const std::vector<hipCtx_t> &contexts = resources.contexts;
+    const std::vector<hipStream_t> &streams = resources.streams;
+    const std::vector<hipEvent_t> &startEvents = resources.startEvents;
+    const std::vector<hipEvent_t> &endEvents = resources.endEvents;
+    volatile int* blockingVar = resources.blockingVar;
+    SampleStatistics stats(srcNodes.size());
+    std::vector<PerformanceStatistic> &bandwidthStats = stats.bandwidths;
+    std::vector<size_t> adjustedCopySizes(srcNodes.size());
+    PerformanceStatistic &totalBandwidth = stats.totalBandwidth;
+    PerformanceStatistic &sumBandwidth = stats.sumBandwidth;
+    std::vector<size_t> finalCopySize(srcNodes.size());
+    unsigned long long timedLoopCount = getTimedLoopCount();
+    std::vector<TimingHistogram> &iterationTimes = stats.iterationTimes;
+    PerformanceStatistic &startSkew = stats.startSkew;
+
+    for (int i = 0; i < srcNodes.size(); i++) {
+        assert(copySizes[i] <= srcNodes[i]->getBufferSize() && copySizes[i] <= dstNodes[i]->getBufferSize());
         // Get the final copy size that will be used.
         // CE and SM copy sizes will differ due to possible truncation
         // during SM copies.
-        finalCopySize[i] = getAdjustedCopySize(srcNodes[0]->getBufferSize(), streams[i]);
-    }   
-    CU_ASSERT(hipCtxSetCurrent(contexts[0]));
-    CU_ASSERT(hipEventCreateWithFlags(&totalEnd, hipEventDefault));
-
-    // This loop is for sampling the testcase (which itself has a loop count)
-    for (unsigned int n = 0; n < averageLoopCount; n++) {
-        *blockingVar = 0;
+        CU_ASSERT(hipCtxSetCurrent(contexts[i]));
+        finalCopySize[i] = getAdjustedCopySize(dstNodes[i]->getBuffer(), srcNodes[i]->getBuffer(), copySizes[i], streams[i]);
+        if (perIterationTiming) {
+            getIterationEvents(resources, i, timedLoopCount);
+        }
+    }
+
+    // Copies from or to pageable memory may block the host until they complete, releasing the latch
+    // only after they are all enqueued would stall them until the spin kernel times out
+    bool latched = isLatched();
+    for (int i = 0; i < srcNodes.size(); i++) {
+        latched = latched && !srcNodes[i]->isPageable() && !dstNodes[i]->isPageable();
+    }
+
+    // This loop is for sampling the testcase (which itself has a loop count), until the reported statistic is precise enough
+    const PerformanceStatistic &reportedStat = bandwidthValue == BandwidthValue::SUM_BW ? sumBandwidth :
+                                               bandwidthValue == BandwidthValue::TOTAL_BW ? totalBandwidth : bandwidthStats[0];
+#ifdef ROCM_SMI
+    std::unique_ptr<CounterSampler> counters = createCounterSampler(srcNodes, dstNodes);
+#endif
+    SampleBudget budget;
+    unsigned int untimedSamples = 0;
+    for (unsigned long long n = 0; budget.needsMore(reportedStat); n++) {
+        *blockingVar = latched ? 0 : 1;
         // Set the memory patterns correctly before spin kernel launch etc.
         for (int i = 0; i < srcNodes.size(); i++) {
-            dstNodes[i]->memsetPattern(dstNodes[i]->getBuffer(), finalCopySize[i], 0xCAFEBABE);
-            srcNodes[i]->memsetPattern(srcNodes[i]->getBuffer(), finalCopySize[i], 0xBAADF00D);
+            dstNodes[i]->memsetPattern(finalCopySize[i], 0xCAFEBABE);
+            srcNodes[i]->memsetPattern(finalCopySize[i], 0xBAADF00D);
         }        
         // block stream, and enqueue copy
-        for (int i = 0; i < srcNodes.size(); i++) {
+        auto enqueueWarmup = [&](int i) {
             CU_ASSERT(hipCtxSetCurrent(contexts[i]));
 
             // start the spin kernel on the stream
             CU_ASSERT(spinKernel(blockingVar, streams[i]));
 
             // warmup
-            memcpyFunc(dstNodes[i]->getBuffer(), srcNodes[i]->getBuffer(), streams[i], srcNodes[i]->getBufferSize(), WARMUP_COUNT);
-        }
-
-        CU_ASSERT(hipCtxSetCurrent(contexts[0]));
-        CU_ASSERT(hipEventRecord(startEvents[0], streams[0]));
-        for (int i = 1; i < srcNodes.size(); i++) {
-            // ensure that all copies are launched at the same time
+            if (getWarmupCount() > 0) {
+                enqueueCopies(dstNodes[i]->getBuffer(), srcNodes[i]->getBuffer(), streams[i], copySizes[i], getWarmupCount());
+            }
+        };
+        auto enqueueStart = [&](int i) {
             CU_ASSERT(hipCtxSetCurrent(contexts[i]));
-            CU_ASSERT(hipStreamWaitEvent(streams[i], startEvents[0], 0));
+            if (i != 0) {
+                // ensure that all copies are launched at the same time
+                CU_ASSERT(hipStreamWaitEvent(streams[i], startEvents[0], 0));
+            }
             CU_ASSERT(hipEventRecord(startEvents[i], streams[i]));
-        }
-
-        for (int i = 0; i < srcNodes.size(); i++) {
+        };
+        auto enqueueTimed = [&](int i) {
             CU_ASSERT(hipCtxSetCurrent(contexts[i]));
             assert(srcNodes[i]->getBufferSize() == dstNodes[i]->getBufferSize());
-            adjustedCopySizes[i] = memcpyFunc(dstNodes[i]->getBuffer(), srcNodes[i]->getBuffer(), streams[i], srcNodes[i]->getBufferSize(), loopCount);
+            if (perIterationTiming) {
+                // one copy at a time, so the gaps between iteration events are single copy times
+                std::vector<hipEvent_t> &events = getIterationEvents(resources, i, timedLoopCount);
+                for (unsigned long long iter = 0; iter < timedLoopCount; iter++) {
+                    adjustedCopySizes[i] = enqueueCopies(dstNodes[i]->getBuffer(), srcNodes[i]->getBuffer(), streams[i], copySizes[i], 1);
+                    CU_ASSERT(hipEventRecord(events[iter], streams[i]));
+                }
+            } else {
+                adjustedCopySizes[i] = enqueueCopies(dstNodes[i]->getBuffer(), srcNodes[i]->getBuffer(), streams[i], copySizes[i], timedLoopCount);
+            }
             CU_ASSERT(hipEventRecord(endEvents[i], streams[i]));
-            if (bandwidthValue == BandwidthValue::TOTAL_BW && i != 0) {
-                // make stream0 wait on the all the others so we can measure total completion time
+        };
+
+        if (parallelEnqueue && srcNodes.size() > 1) {
+            // one worker per context, pinned to the NUMA node of its device. The copy 0 worker records the start
+            // event the others wait on, the barrier ensures it exists before they enqueue their waits.
+            std::map<hipCtx_t, std::vector<int>> contextCopies;
+            for (int i = 0; i < srcNodes.size(); i++) {
+                contextCopies[contexts[i]].push_back(i);
+            }
+            std::barrier startRecorded((std::ptrdiff_t)contextCopies.size());
+            std::vector<std::thread> workers;
+            for (auto &entry : contextCopies) {
+                const std::vector<int> &copies = entry.second;
+                workers.emplace_back([&, copies]() {
+                    hipDevice_t device;
+                    CU_ASSERT(hipCtxSetCurrent(contexts[copies[0]]));
+                    CU_ASSERT(hipCtxGetDevice(&device));
+                    setOptimalCpuAffinity(device);
+
+                    for (int i : copies) {
+                        enqueueWarmup(i);
+                    }
+                    if (copies[0] == 0) {
+                        enqueueStart(0);
+                    }
+                    startRecorded.arrive_and_wait();
+                    for (int i : copies) {
+                        if (i != 0) {
+                            enqueueStart(i);
+                        }
+                    }
+                    for (int i : copies) {
+                        enqueueTimed(i);
+                    }
+                });
+            }
+            for (std::thread &worker : workers) {
+                worker.join();
+            }
+        } else {
+            for (int i = 0; i < srcNodes.size(); i++) {
+                enqueueWarmup(i);
+            }
+            for (int i = 0; i < srcNodes.size(); i++) {
+                enqueueStart(i);
+            }
+            for (int i = 0; i < srcNodes.size(); i++) {
+                enqueueTimed(i);
+            }
+        }
+
+        if (bandwidthValue == BandwidthValue::TOTAL_BW) {
+            // make stream0 wait on the all the others so we can measure total completion time
+            CU_ASSERT(hipCtxSetCurrent(contexts[0]));
+            for (int i = 1; i < srcNodes.size(); i++) {
                 CU_ASSERT(hipStreamWaitEvent(streams[0], endEvents[i], 0));
             }
         }
 
         // record the total end - only valid if BandwidthValue::TOTAL_BW is used due to StreamWaitEvent above
         CU_ASSERT(hipCtxSetCurrent(contexts[0]));
-        CU_ASSERT(hipEventRecord(totalEnd, streams[0]));
+        CU_ASSERT(hipEventRecord(resources.totalEnd, streams[0]));
 
+        if (backgroundLoad) {
+            backgroundLoad->start();
+        }
+#ifdef ROCM_SMI
+        if (counters) {
+            counters->begin();
+        }
+#endif
         // unblock the streams
         *blockingVar = 1;
 
         for (hipStream_t stream : streams) {
             CU_ASSERT(hipStreamSynchronize(stream));
         }
+#ifdef ROCM_SMI
+        if (counters) {
+            counters->end();
+        }
+#endif
+        if (backgroundLoad) {
+            backgroundLoad->stop();
+        }
 
         if (!skipVerification) {
             for (int i = 0; i < srcNodes.size(); i++) {            
-                dstNodes[i]->memcmpPattern(dstNodes[i]->getBuffer(), finalCopySize[i], 0xBAADF00D);
+                getVerifiedNode(*srcNodes[i], *dstNodes[i]).memcmpPattern(finalCopySize[i], 0xBAADF00D);
             }
         }
 
+        // a sample timed as 0 us carries no bandwidth, it is re-run instead of recording an infinite one
+        std::vector<float> timesWithEvents(bandwidthStats.size());
+        float totalTime = 0.0f;
+        bool timed = true;
         for (int i = 0; i < bandwidthStats.size(); i++) {
-            float timeWithEvents = 0.0f;
-            CU_ASSERT(hipEventElapsedTime(&timeWithEvents, startEvents[i], endEvents[i]));
-            double elapsedWithEventsInUs = ((double) timeWithEvents * 1000.0);
-            unsigned long long bandwidth = (adjustedCopySizes[i] * loopCount * 1000ull * 1000ull) / (unsigned long long) elapsedWithEventsInUs;
-            bandwidthStats[i]((double) bandwidth);
+            CU_ASSERT(hipEventElapsedTime(&timesWithEvents[i], startEvents[i], endEvents[i]));
+            timed = timed && timesWithEvents[i] > 0.0f;
+        }
+        if (bandwidthValue == BandwidthValue::TOTAL_BW) {
+            CU_ASSERT(hipEventElapsedTime(&totalTime, startEvents[0], resources.totalEnd));
+            timed = timed && totalTime > 0.0f;
+        }
+        if (!timed) {
+            if (++untimedSamples > MAX_UNTIMED_SAMPLES) {
+                throw std::string("Copies of ") + std::to_string(copySizes[0]) + " bytes are too short for the event timer, raise --bufferSize";
+            }
+            VERBOSE << "\tSample " << n << ": timed as 0 us, running it again\n";
+            continue;
+        }
+
+        double sampleSum = 0.0;
+        for (int i = 0; i < bandwidthStats.size(); i++) {
+            double elapsedWithEventsInUs = ((double) timesWithEvents[i] * 1000.0);
+            // in floating point, bytes times loops times 1e6 overflow 64 bits for buffers of a large part of the device memory
+            double bandwidth = (double)adjustedCopySizes[i] * timedLoopCount * 1e6 / elapsedWithEventsInUs;
+            bandwidthStats[i](bandwidth);
+            sampleSum += bandwidth;
+
+            if (perIterationTiming) {
+                std::vector<hipEvent_t> &events = getIterationEvents(resources, i, timedLoopCount);
+                for (unsigned long long iter = 0; iter < timedLoopCount; iter++) {
+                    float iterationTime = 0.0f;
+                    CU_ASSERT(hipEventElapsedTime(&iterationTime, iter == 0 ? startEvents[i] : events[iter - 1], events[iter]));
+                    iterationTimes[i].recordNs((unsigned long long)((double)iterationTime * 1e6));
+                }
+            }
 
             if (bandwidthValue == BandwidthValue::SUM_BW || BandwidthValue::TOTAL_BW || i == 0) {
                 // Verbose print only the values that are used for the final output
                 VERBOSE << "\tSample " << n << ": " << srcNodes[i]->getNodeString() << " -> " << dstNodes[i]->getNodeString() << ": " <<
-                    std::fixed << std::setprecision(2) << (double)bandwidth * 1e-9 << " GB/s\n";
+                    std::fixed << std::setprecision(2) << bandwidth * 1e-9 << " GB/s\n";
             }
         }
 
+        sumBandwidth(sampleSum);
+
+        if (srcNodes.size() > 1) {
+            // how late the last stream started its copies after stream 0, not all devices can time events of another device
+            double maxSkew = 0.0;
+            for (int i = 1; i < srcNodes.size(); i++) {
+                float skew = 0.0f;
+                if (hipEventElapsedTime(&skew, startEvents[0], startEvents[i]) == hipSuccess) {
+                    maxSkew = std::max(maxSkew, (double)skew * 1000.0);
+                }
+            }
+            startSkew(maxSkew);
+            VERBOSE << "\tSample " << n << ": Start skew : " << std::fixed << std::setprecision(2) << maxSkew << " us\n";
+        }
+
         if (bandwidthValue == BandwidthValue::TOTAL_BW) {
-            float totalTime = 0.0f;
-            CU_ASSERT(hipEventElapsedTime(&totalTime, startEvents[0], totalEnd));
             double elapsedTotalInUs = ((double) totalTime * 1000.0);
 
             // get total bytes copied
@@ -326,24 +997,80 @@ double MemcpyOperation::doMemcpy(const std::vector<const MemcpyNode*> &srcNodes,
                 totalSize += size;
             }
 
-            unsigned long long bandwidth = (totalSize * loopCount * 1000ull * 1000ull) / (unsigned long long) elapsedTotalInUs;
-            totalBandwidth((double) bandwidth);
+            double bandwidth = (double)totalSize * timedLoopCount * 1e6 / elapsedTotalInUs;
+            totalBandwidth(bandwidth);
 
             VERBOSE << "\tSample " << n << ": Total Bandwidth : " <<
-                std::fixed << std::setprecision(2) << (double)bandwidth * 1e-9 << " GB/s\n";
+                std::fixed << std::setprecision(2) << bandwidth * 1e-9 << " GB/s\n";
         }
     }
 
-    // cleanup
-    CU_ASSERT(hipHostFree((void*)blockingVar));
-
-    CU_ASSERT(hipEventDestroy(totalEnd));
+#ifdef ROCM_SMI
+    if (counters) {
+        stats.counters = counters->getCounters();
+    }
+#endif
+    return reportBandwidth(srcNodes, dstNodes, copySizes, stats);
+}
 
+#ifdef ROCM_SMI
+std::unique_ptr<CounterSampler> MemcpyOperation::createCounterSampler(const std::vector<const MemcpyNode*> &srcNodes, const std::vector<const MemcpyNode*> &dstNodes) {
+    if (!sampleCounters) {
+        return nullptr;
+    }
+    std::set<int> devices;
     for (int i = 0; i < srcNodes.size(); i++) {
-        CU_ASSERT(hipStreamDestroy(streams[i]));
-        CU_ASSERT(hipEventDestroy(startEvents[i]));
-        CU_ASSERT(hipEventDestroy(endEvents[i]));
+        devices.insert(srcNodes[i]->getOwnerDeviceIdx());
+        devices.insert(dstNodes[i]->getOwnerDeviceIdx());
+    }
+    return std::make_unique<CounterSampler>(devices);
+}
+#endif
+
+double MemcpyOperation::reportBandwidth(const std::vector<const MemcpyNode*> &srcNodes, const std::vector<const MemcpyNode*> &dstNodes,
+                                        const std::vector<size_t> &copySizes, const SampleStatistics &stats) {
+    const std::vector<PerformanceStatistic> &bandwidthStats = stats.bandwidths;
+    const PerformanceStatistic &startSkew = stats.startSkew;
+
+    copyBandwidths.clear();
+    for (const PerformanceStatistic &stat : bandwidthStats) {
+        copyBandwidths.push_back(stat.returnAppropriateMetric() * 1e-9);
+    }
+
+    const PerformanceStatistic &reportedBandwidth = bandwidthValue == BandwidthValue::SUM_BW ? stats.sumBandwidth :
+                                                     bandwidthValue == BandwidthValue::TOTAL_BW ? stats.totalBandwidth : bandwidthStats[0];
+    output->recordMeasurement(*srcNodes[0], *dstNodes[0], srcNodes.size(), copySizes[0], reportedBandwidth, 1e-9, "GB/s");
+    output->recordCopyPairs(srcNodes, dstNodes);
+    if (startSkew.count() > 0) {
+        if (parallelEnqueue) {
+            std::cout << "\tStart skew between " << srcNodes.size() << " streams (us): median " << std::fixed << std::setprecision(2)
+                      << startSkew.median() << ", max " << startSkew.largest() << std::endl;
+        }
+        output->recordStartSkew(startSkew);
+    }
+    if (perIterationTiming) {
+        const TimingHistogram &times = stats.iterationTimes[0];
+        std::cout << "\t" << srcNodes[0]->getNodeString() << " -> " << dstNodes[0]->getNodeString() << " copy time (us): " << std::fixed << std::setprecision(2)
+                  << "P50 " << times.percentileNs(50) * 1e-3 << ", P90 " << times.percentileNs(90) * 1e-3 << ", P99 " << times.percentileNs(99) * 1e-3
+                  << ", P99.9 " << times.percentileNs(99.9) * 1e-3 << ", max " << times.largestNs() * 1e-3 << " (" << times.count() << " copies)" << std::endl;
+        output->recordIterationTimes(times);
+    }
+#ifdef ROCM_SMI
+    if (!stats.counters.empty()) {
+        std::vector<DeviceCounters> counters = stats.counters;
+        for (DeviceCounters &device : counters) {
+            // copies between host memory and the device cross its PCIe link
+            for (int i = 0; i < srcNodes.size(); i++) {
+                bool hostCopy = srcNodes[i]->getPrimaryCtx() == nullptr || dstNodes[i]->getPrimaryCtx() == nullptr;
+                if (hostCopy && (srcNodes[i]->getOwnerDeviceIdx() == device.deviceId || dstNodes[i]->getOwnerDeviceIdx() == device.deviceId)) {
+                    device.hostBandwidth += bandwidthStats[i].returnAppropriateMetric();
+                }
+            }
+            printCounters(device);
+        }
+        output->recordCounters(counters);
     }
+#endif
 
     if (bandwidthValue == BandwidthValue::SUM_BW) {
         double sum = 0.0;
@@ -352,52 +1079,522 @@ double MemcpyOperation::doMemcpy(const std::vector<const MemcpyNode*> &srcNodes,
         }
         return sum;
     } else if (bandwidthValue == BandwidthValue::TOTAL_BW) {
-        return totalBandwidth.returnAppropriateMetric() * 1e-9;
+        return stats.totalBandwidth.returnAppropriateMetric() * 1e-9;
     } else {
         return bandwidthStats[0].returnAppropriateMetric() * 1e-9;
     }
 }
-size_t MemcpyOperationCE::getAdjustedCopySize(size_t size, hipStream_t stream) {
+
+size_t MemcpyOperationCE::getAdjustedCopySize(hipDeviceptr_t dst, hipDeviceptr_t src, size_t size, hipStream_t stream) {
     //CE does not change/truncate buffer size
     return size;
 }
 
+std::map<MemcpyOperationSM::TuneKey, SmCopyConfig> MemcpyOperationSM::tunedConfigs;
+
 MemcpyOperationSM::MemcpyOperationSM(unsigned long long loopCount, ContextPreference ctxPreference, BandwidthValue bandwidthValue) : 
         MemcpyOperation(loopCount, ctxPreference, bandwidthValue) {}
 
 size_t MemcpyOperationSM::memcpyFunc(hipDeviceptr_t dst, hipDeviceptr_t src, hipStream_t stream, size_t copySize, unsigned long long loopCount) {
-    return copyKernel(dst, src, copySize, stream, loopCount);
+    return copyKernel(dst, src, copySize, stream, loopCount, getCopyConfig(dst, src, copySize, stream));
+}
+
+size_t MemcpyOperationSM::getAdjustedCopySize(hipDeviceptr_t dst, hipDeviceptr_t src, size_t size, hipStream_t stream) {
+    // We want to calculate the exact copy sizes that will be
+    // used by the copy kernels.
+    return copyKernelSize(size, getCopyConfig(dst, src, size, stream));
+}
+
+MemcpyOperationSMRead::MemcpyOperationSMRead(unsigned long long loopCount, ContextPreference ctxPreference, BandwidthValue bandwidthValue) :
+        MemcpyOperation(loopCount, ctxPreference, bandwidthValue) {}
+
+size_t MemcpyOperationSMRead::memcpyFunc(hipDeviceptr_t dst, hipDeviceptr_t src, hipStream_t stream, size_t copySize, unsigned long long loopCount) {
+    return readKernel(src, copySize, dst, stream, loopCount);
+}
+
+size_t MemcpyOperationSMRead::getAdjustedCopySize(hipDeviceptr_t dst, hipDeviceptr_t src, size_t size, hipStream_t stream) {
+    return readWriteKernelSize(size);
 }
-size_t MemcpyOperationSM::getAdjustedCopySize(size_t size, hipStream_t stream) {
+
+MemcpyOperationSMWrite::MemcpyOperationSMWrite(unsigned long long loopCount, ContextPreference ctxPreference, BandwidthValue bandwidthValue) :
+        MemcpyOperation(loopCount, ctxPreference, bandwidthValue) {}
+
+size_t MemcpyOperationSMWrite::memcpyFunc(hipDeviceptr_t dst, hipDeviceptr_t src, hipStream_t stream, size_t copySize, unsigned long long loopCount) {
+    return writeKernel(dst, copySize, stream, loopCount);
+}
+
+size_t MemcpyOperationSMWrite::getAdjustedCopySize(hipDeviceptr_t dst, hipDeviceptr_t src, size_t size, hipStream_t stream) {
+    return readWriteKernelSize(size);
+}
+
+MemcpyOperationSMAccessPattern::MemcpyOperationSMAccessPattern(unsigned long long loopCount, const AccessPattern &pattern,
+                                                               ContextPreference ctxPreference, BandwidthValue bandwidthValue) :
+        MemcpyOperation(loopCount, ctxPreference, bandwidthValue), pattern(pattern) {}
+
+size_t MemcpyOperationSMAccessPattern::memcpyFunc(hipDeviceptr_t dst, hipDeviceptr_t src, hipStream_t stream, size_t copySize, unsigned long long loopCount) {
+    return accessPatternKernel(src, copySize, pattern, dst, stream, loopCount);
+}
+
+size_t MemcpyOperationSMAccessPattern::getAdjustedCopySize(hipDeviceptr_t dst, hipDeviceptr_t src, size_t size, hipStream_t stream) {
+    return accessPatternKernelSize(size, pattern);
+}
+
+// Link between device and the memory at ptr, host memory has no device pointer attributes
+static std::string pointerLinkClass(hipDeviceptr_t ptr, int device) {
+    hipPointerAttribute_t attributes;
+    if (hipPointerGetAttributes(&attributes, (void *)ptr) != hipSuccess || attributes.type != hipMemoryTypeDevice) {
+        return "host";
+    }
+    if (attributes.device == device) {
+        return "local";
+    }
+
+    uint32_t linkType = 0, hopCount = 0;
+    if (hipExtGetLinkTypeAndHopCount(device, attributes.device, &linkType, &hopCount) != hipSuccess) {
+        return "unknown";
+    }
+    return linkTypeName(linkType);
+}
+
+SmCopyConfig MemcpyOperationSM::getCopyConfig(hipDeviceptr_t dst, hipDeviceptr_t src, size_t size, hipStream_t stream) {
+    if (!smAutotune) {
+        return defaultSmCopyConfig;
+    }
+
     hipDevice_t dev;
     hipCtx_t ctx;
-
     CU_ASSERT(cuStreamGetCtx(stream, &ctx));
     CU_ASSERT(hipCtxGetDevice(&dev));
-    int numSm;
-    CU_ASSERT(hipDeviceGetAttribute(&numSm, hipDeviceAttributeMultiprocessorCount, dev));
-    unsigned int totalThreadCount = numSm * numThreadPerBlock;
-    // We want to calculate the exact copy sizes that will be
-    // used by the copy kernels.
-    if (size < (defaultBufferSize * _MiB) ) {
-        // copy size is rounded down to 16 bytes
-        int numUint4 = size / sizeof(uint4);
-        return numUint4 * sizeof(uint4);
+
+    TuneKey key(dev, pointerLinkClass(src, dev), pointerLinkClass(dst, dev), size);
+    auto it = tunedConfigs.find(key);
+    if (it != tunedConfigs.end()) {
+        return it->second;
     }
-    // adjust size to elements (size is multiple of MB, so no truncation here)
-    size_t sizeInElement = size / sizeof(uint4);
-    // this truncates the copy
-    sizeInElement = totalThreadCount * (sizeInElement / totalThreadCount);
-    return sizeInElement * sizeof(uint4);
+
+    // Coordinate descent from the default config, one parameter at a time, which needs
+    // a few trials per parameter instead of one per instantiation
+    SmCopyConfig best = defaultSmCopyConfig;
+    double bestBandwidth = timeCopyConfig(best, dst, src, size, stream);
+    auto tune = [&](auto SmCopyConfig::*field, const auto &candidates) {
+        for (auto candidate : candidates) {
+            SmCopyConfig config = best;
+            config.*field = candidate;
+            if (config.*field == best.*field) {
+                continue;
+            }
+            double bandwidth = timeCopyConfig(config, dst, src, size, stream);
+            VERBOSE << "\tSM autotune device " << dev << ": " << config.toString() << ": " << std::fixed << std::setprecision(2) << bandwidth * 1e-9 << " GB/s\n";
+            if (bandwidth > bestBandwidth) {
+                best = config;
+                bestBandwidth = bandwidth;
+            }
+        }
+    };
+    tune(&SmCopyConfig::vectorWidth, smCopyVectorWidths);
+    tune(&SmCopyConfig::unroll, smCopyUnrolls);
+    tune(&SmCopyConfig::blockSize, smCopyBlockSizes);
+    tune(&SmCopyConfig::blocksPerSm, smCopyBlocksPerSm);
+    tune(&SmCopyConfig::cacheHint, smCopyCacheHints);
+
+    std::cout << "SM copy autotune: device " << dev << ", " << std::get<1>(key) << " -> " << std::get<2>(key) << ", " << size << " bytes: "
+              << best.toString() << " (" << std::fixed << std::setprecision(2) << bestBandwidth * 1e-9 << " GB/s)" << std::endl;
+
+    tunedConfigs[key] = best;
+    return best;
+}
+
+double MemcpyOperationSM::timeCopyConfig(const SmCopyConfig &config, hipDeviceptr_t dst, hipDeviceptr_t src, size_t size, hipStream_t stream) {
+    const unsigned long long trialLoopCount = 4;
+    hipEvent_t startEvent, endEvent;
+    float elapsed = 0.0f;
+
+    CU_ASSERT(hipEventCreateWithFlags(&startEvent, hipEventDefault));
+    CU_ASSERT(hipEventCreateWithFlags(&endEvent, hipEventDefault));
+
+    // warmup
+    copyKernel(dst, src, size, stream, 1, config);
+    CU_ASSERT(hipEventRecord(startEvent, stream));
+    size_t copied = copyKernel(dst, src, size, stream, trialLoopCount, config);
+    CU_ASSERT(hipEventRecord(endEvent, stream));
+    CU_ASSERT(hipStreamSynchronize(stream));
+    CU_ASSERT(hipEventElapsedTime(&elapsed, startEvent, endEvent));
+
+    CU_ASSERT(hipEventDestroy(startEvent));
+    CU_ASSERT(hipEventDestroy(endEvent));
+
+    return elapsed > 0.0f ? (double)copied * trialLoopCount * 1000.0 / elapsed : 0.0;
 }
 
 MemcpyOperationCE::MemcpyOperationCE(unsigned long long loopCount, ContextPreference ctxPreference, BandwidthValue bandwidthValue) : 
         MemcpyOperation(loopCount, ctxPreference, bandwidthValue) {}
 
 size_t MemcpyOperationCE::memcpyFunc(hipDeviceptr_t dst, hipDeviceptr_t src, hipStream_t stream, size_t copySize, unsigned long long loopCount) {
-    for (unsigned int l = 0; l < loopCount; l++) {
+    for (unsigned long long l = 0; l < loopCount; l++) {
         CU_ASSERT(cuMemcpyAsync(dst, src, copySize, stream));
     }
 
     return copySize;
 }
+
+MemcpyOperationCESdma::MemcpyOperationCESdma(unsigned long long loopCount, ContextPreference ctxPreference, BandwidthValue bandwidthValue) :
+        MemcpyOperationCE(loopCount, ctxPreference, bandwidthValue) {}
+
+void MemcpyOperationCESdma::checkSdmaNodes(const std::vector<const MemcpyNode*> &nodes) {
+    for (const MemcpyNode *node : nodes) {
+        if (dynamic_cast<const ManagedNode *>(node)) {
+            throw std::string("The sdma CE copy path doesn't support managed memory");
+        }
+        const HostNode *host = dynamic_cast<const HostNode *>(node);
+        if (host && (host->getMemType() == HOST_MEM_PAGEABLE || host->getMemType() == HOST_MEM_REGISTERED ||
+                     host->getMemType() == HOST_MEM_MANAGED)) {
+            throw std::string("The sdma CE copy path doesn't support ") + hostMemTypeNames[host->getMemType()] + " host memory";
+        }
+    }
+}
+
+double MemcpyOperationCESdma::doMemcpy(const std::vector<const MemcpyNode*> &srcNodes, const std::vector<const MemcpyNode*> &dstNodes) {
+    checkSdmaNodes(srcNodes);
+    checkSdmaNodes(dstNodes);
+    return MemcpyOperation::doMemcpy(srcNodes, dstNodes);
+}
+
+// NoCU copies are done by SDMA engines whatever the direction, doMemcpy only lets pinned and mapped host buffers through
+size_t MemcpyOperationCESdma::memcpyFunc(hipDeviceptr_t dst, hipDeviceptr_t src, hipStream_t stream, size_t copySize, unsigned long long loopCount) {
+    for (unsigned long long l = 0; l < loopCount; l++) {
+        CU_ASSERT(hipMemcpyAsync(dst, src, copySize, hipMemcpyDeviceToDeviceNoCU, stream));
+    }
+
+    return copySize;
+}
+
+std::unique_ptr<MemcpyOperation> createMemcpyOperationCE(unsigned long long loopCount, MemcpyOperation::ContextPreference ctxPreference,
+                                                         MemcpyOperation::BandwidthValue bandwidthValue) {
+    if (copyBackend == BACKEND_HSA) {
+        return std::make_unique<MemcpyOperationHsa>(loopCount, ctxPreference, bandwidthValue);
+    }
+    if (ceCopyPath == CE_PATH_SDMA) {
+        return std::make_unique<MemcpyOperationCESdma>(loopCount, ctxPreference, bandwidthValue);
+    }
+    return std::make_unique<MemcpyOperationCE>(loopCount, ctxPreference, bandwidthValue);
+}
+
+MemcpyOperationCEPipelined::MemcpyOperationCEPipelined(unsigned long long loopCount, size_t chunkSize, unsigned int streamCount,
+                                                       ContextPreference ctxPreference, BandwidthValue bandwidthValue) :
+        MemcpyOperation(loopCount, ctxPreference, bandwidthValue), chunkSize(chunkSize), streamCount(streamCount) {}
+
+MemcpyOperationCEPipelined::~MemcpyOperationCEPipelined() {
+    for (auto &entry : pipelines) {
+        Pipeline &pipeline = entry.second;
+        for (size_t i = 0; i < pipeline.helperStreams.size(); i++) {
+            CU_ASSERT(hipStreamDestroy(pipeline.helperStreams[i]));
+            CU_ASSERT(hipEventDestroy(pipeline.joins[i]));
+        }
+        CU_ASSERT(hipEventDestroy(pipeline.fork));
+    }
+}
+
+MemcpyOperationCEPipelined::Pipeline &MemcpyOperationCEPipelined::getPipeline(hipStream_t stream) {
+    std::lock_guard<std::mutex> lock(pipelinesMutex);
+    auto it = pipelines.find(stream);
+    if (it != pipelines.end()) {
+        return it->second;
+    }
+
+    // the copy stream's context is current when its copies are enqueued
+    Pipeline &pipeline = pipelines[stream];
+    CU_ASSERT(hipEventCreateWithFlags(&pipeline.fork, hipEventDisableTiming));
+    pipeline.helperStreams.resize(streamCount - 1);
+    pipeline.joins.resize(streamCount - 1);
+    for (unsigned int i = 0; i + 1 < streamCount; i++) {
+        CU_ASSERT(hipStreamCreateWithFlags(&pipeline.helperStreams[i], hipStreamNonBlocking));
+        CU_ASSERT(hipEventCreateWithFlags(&pipeline.joins[i], hipEventDisableTiming));
+    }
+    return pipeline;
+}
+
+double MemcpyOperationCEPipelined::doMemcpy(const std::vector<const MemcpyNode*> &srcNodes, const std::vector<const MemcpyNode*> &dstNodes) {
+    if (ceCopyPath == CE_PATH_SDMA) {
+        MemcpyOperationCESdma::checkSdmaNodes(srcNodes);
+        MemcpyOperationCESdma::checkSdmaNodes(dstNodes);
+    }
+    return MemcpyOperation::doMemcpy(srcNodes, dstNodes);
+}
+
+size_t MemcpyOperationCEPipelined::memcpyFunc(hipDeviceptr_t dst, hipDeviceptr_t src, hipStream_t stream, size_t copySize, unsigned long long loopCount) {
+    Pipeline &pipeline = getPipeline(stream);
+
+    // helper streams start after the spin kernel and the copies already on the copy stream
+    CU_ASSERT(hipEventRecord(pipeline.fork, stream));
+    for (hipStream_t helperStream : pipeline.helperStreams) {
+        CU_ASSERT(hipStreamWaitEvent(helperStream, pipeline.fork, 0));
+    }
+
+    size_t chunk = 0;
+    for (unsigned long long l = 0; l < loopCount; l++) {
+        for (size_t offset = 0; offset < copySize; offset += chunkSize, chunk++) {
+            hipStream_t chunkStream = chunk % streamCount == 0 ? stream : pipeline.helperStreams[chunk % streamCount - 1];
+            size_t size = std::min(chunkSize, copySize - offset);
+            if (ceCopyPath == CE_PATH_SDMA) {
+                CU_ASSERT(hipMemcpyAsync((char *)dst + offset, (char *)src + offset, size, hipMemcpyDeviceToDeviceNoCU, chunkStream));
+            } else {
+                CU_ASSERT(cuMemcpyAsync((char *)dst + offset, (char *)src + offset, size, chunkStream));
+            }
+        }
+    }
+
+    for (size_t i = 0; i < pipeline.helperStreams.size(); i++) {
+        CU_ASSERT(hipEventRecord(pipeline.joins[i], pipeline.helperStreams[i]));
+        CU_ASSERT(hipStreamWaitEvent(stream, pipeline.joins[i], 0));
+    }
+    return copySize;
+}
+
+size_t MemcpyOperationCEPipelined::getAdjustedCopySize(hipDeviceptr_t dst, hipDeviceptr_t src, size_t size, hipStream_t stream) {
+    return size;
+}
+
+MemcpyOperationPrefetch::MemcpyOperationPrefetch(unsigned long long loopCount, size_t pageSize) :
+        MemcpyOperation(loopCount, PREFER_DST_CONTEXT, USE_FIRST_BW), pageSize(pageSize) {}
+
+size_t MemcpyOperationPrefetch::memcpyFunc(hipDeviceptr_t dst, hipDeviceptr_t src, hipStream_t stream, size_t copySize, unsigned long long loopCount) {
+    hipDevice_t dev;
+    hipCtx_t ctx;
+    CU_ASSERT(cuStreamGetCtx(stream, &ctx));
+    CU_ASSERT(hipCtxGetDevice(&dev));
+
+    for (size_t offset = 0; offset < copySize; offset += pageSize) {
+        CU_ASSERT(hipMemPrefetchAsync((char *)src + offset, std::min(pageSize, copySize - offset), dev, stream));
+    }
+    return copySize;
+}
+
+size_t MemcpyOperationPrefetch::getAdjustedCopySize(hipDeviceptr_t dst, hipDeviceptr_t src, size_t size, hipStream_t stream) {
+    return size;
+}
+
+// Every sample writes the pattern, which moves the pages back home, then migrates the buffer once in latched sections
+double MemcpyOperationPrefetch::doMemcpy(const std::vector<const MemcpyNode*> &srcNodes, const std::vector<const MemcpyNode*> &dstNodes) {
+    assert(srcNodes.size() == 1 && dstNodes.size() == 1);
+    const MemcpyNode &srcNode = *srcNodes[0];
+    const MemcpyNode &dstNode = *dstNodes[0];
+    hipCtx_t ctx = dstNode.getPrimaryCtx() != nullptr ? dstNode.getPrimaryCtx() : srcNode.getPrimaryCtx();
+    size_t sectionSize = MAX_LATCHED_COMMANDS * pageSize;
+
+    return measureSizes(srcNodes, dstNodes, [&](const std::vector<size_t> &copySizes) {
+        size_t copySize = copySizes[0];
+        SampleStatistics stats(1);
+        SampleBudget budget;
+        unsigned int untimedSamples = 0;
+        for (unsigned long long n = 0; budget.needsMore(stats.bandwidths[0]); n++) {
+            dstNode.memsetPattern(copySize, 0xCAFEBABE);
+            srcNode.memsetPattern(copySize, 0xBAADF00D);
+
+            double elapsed = 0.0;
+            for (size_t offset = 0; offset < copySize; offset += sectionSize) {
+                elapsed += timeLatched(ctx, [&](hipStream_t stream) {
+                    memcpyFunc(dstNode.getBuffer(), (char *)srcNode.getBuffer() + offset, stream, std::min(sectionSize, copySize - offset), 1);
+                });
+            }
+
+            if (!skipVerification) {
+                getVerifiedNode(srcNode, dstNode).memcmpPattern(copySize, 0xBAADF00D);
+            }
+
+            if (elapsed <= 0.0) {
+                if (++untimedSamples > MAX_UNTIMED_SAMPLES) {
+                    throw std::string("Prefetches of ") + std::to_string(copySize) + " bytes are too short for the event timer, raise --bufferSize";
+                }
+                VERBOSE << "\tSample " << n << ": timed as 0 us, running it again\n";
+                continue;
+            }
+
+            // elapsed times are in ms
+            double bandwidth = (double)copySize * 1e3 / elapsed;
+            stats.bandwidths[0](bandwidth);
+            stats.sumBandwidth(bandwidth);
+            VERBOSE << "\tSample " << n << ": " << srcNode.getNodeString() << " -> " << dstNode.getNodeString() << ": " <<
+                std::fixed << std::setprecision(2) << bandwidth * 1e-9 << " GB/s\n";
+        }
+        return reportBandwidth(srcNodes, dstNodes, copySizes, stats);
+    });
+}
+
+MemcpyOperationPageFault::MemcpyOperationPageFault(unsigned long long loopCount, size_t pageSize) :
+        MemcpyOperation(loopCount, PREFER_DST_CONTEXT, USE_FIRST_BW), pageSize(pageSize) {}
+
+size_t MemcpyOperationPageFault::memcpyFunc(hipDeviceptr_t dst, hipDeviceptr_t src, hipStream_t stream, size_t copySize, unsigned long long loopCount) {
+    pageTouchKernel(src, copySize, pageSize, dst, stream);
+    return copySize;
+}
+
+// Whole pages migrate, so every byte of the touched pages counts
+size_t MemcpyOperationPageFault::getAdjustedCopySize(hipDeviceptr_t dst, hipDeviceptr_t src, size_t size, hipStream_t stream) {
+    return size;
+}
+
+PerformanceStatistic MemcpyOperation::sampleLatched(hipCtx_t ctx, const std::function<void(hipStream_t)> &enqueue) {
+    return sampleLatched(ctx, 1, [&](hipStream_t stream, unsigned long long section) {
+        enqueue(stream);
+    });
+}
+
+// The measured work runs alone, so it takes the first stream and events of the context's arena
+float MemcpyOperation::timeLatched(hipCtx_t ctx, const std::function<void(hipStream_t)> &enqueue) {
+    float elapsed = 0.0f;
+
+    CU_ASSERT(hipCtxSetCurrent(ctx));
+    volatile int* blockingVar = getBlockingVar();
+    ContextArena &arena = arenas[ctx];
+    reserveArenaSlot(arena, 0);
+    hipStream_t stream = arena.streams[0];
+
+    *blockingVar = 0;
+    CU_ASSERT(spinKernel(blockingVar, stream));
+    CU_ASSERT(hipEventRecord(arena.startEvents[0], stream));
+    enqueue(stream);
+    CU_ASSERT(hipEventRecord(arena.endEvents[0], stream));
+    *blockingVar = 1;
+
+    CU_ASSERT(hipStreamSynchronize(stream));
+    CU_ASSERT(hipEventElapsedTime(&elapsed, arena.startEvents[0], arena.endEvents[0]));
+    return elapsed;
+}
+
+PerformanceStatistic MemcpyOperation::sampleLatched(hipCtx_t ctx, unsigned long long sections,
+                                                    const std::function<void(hipStream_t, unsigned long long)> &enqueueSection) {
+    PerformanceStatistic elapsedStat;
+
+    // warmup
+    CU_ASSERT(hipCtxSetCurrent(ctx));
+    ContextArena &arena = arenas[ctx];
+    reserveArenaSlot(arena, 0);
+    enqueueSection(arena.streams[0], 0);
+    CU_ASSERT(hipStreamSynchronize(arena.streams[0]));
+
+    SampleBudget budget;
+    unsigned int untimedSamples = 0;
+    for (unsigned long long n = 0; budget.needsMore(elapsedStat); n++) {
+        double elapsed = 0.0;
+        for (unsigned long long section = 0; section < sections; section++) {
+            elapsed += timeLatched(ctx, [&](hipStream_t stream) {
+                enqueueSection(stream, section);
+            });
+        }
+        // a sample timed as 0 us would be recorded as an infinite rate by the callers, it is re-run instead
+        if (elapsed <= 0.0) {
+            if (++untimedSamples > MAX_UNTIMED_SAMPLES) {
+                throw std::string("The measured work is too short for the event timer, raise --loopCount");
+            }
+            VERBOSE << "\tSample " << n << ": timed as 0 us, running it again\n";
+            continue;
+        }
+        elapsedStat(elapsed);
+    }
+
+    return elapsedStat;
+}
+
+MemPtrChaseOperation::MemPtrChaseOperation(unsigned long long loopCount) : accessCount(loopCount * PTR_CHASE_ACCESSES_PER_LOOP) {}
+
+double MemPtrChaseOperation::doPtrChase(int srcDeviceId, const MemcpyNode &node) {
+    size_t hopCount = node.getBufferSize() / PTR_CHASE_STRIDE;
+    size_t slotsPerHop = PTR_CHASE_STRIDE / sizeof(unsigned long long);
+    std::vector<unsigned long long> chain(hopCount * slotsPerHop, 0);
+    std::vector<size_t> order(hopCount);
+    char* base = (char*)node.getBuffer();
+
+    assert(hopCount > 1);
+
+    // Sattolo's shuffle builds a single cycle through every hop, so the chain never revisits a shorter loop
+    std::iota(order.begin(), order.end(), 0);
+    std::mt19937_64 generator(0xBAADF00D);
+    for (size_t i = hopCount - 1; i > 0; i--) {
+        std::uniform_int_distribution<size_t> distribution(0, i - 1);
+        std::swap(order[i], order[distribution(generator)]);
+    }
+    for (size_t i = 0; i < hopCount; i++) {
+        chain[i * slotsPerHop] = (unsigned long long)(base + order[i] * PTR_CHASE_STRIDE);
+    }
+
+    CU_ASSERT(hipCtxSetCurrent(BufferPool::getPrimaryCtx(node.getOwnerDeviceIdx())));
+    CU_ASSERT(hipMemcpy(node.getBuffer(), chain.data(), chain.size() * sizeof(unsigned long long), hipMemcpyDefault));
+
+    // the kernel stores its final pointer on the chasing device
+    DeviceNode sinkNode(sizeof(unsigned long long), srcDeviceId);
+    PerformanceStatistic elapsedStat = MemcpyOperation::sampleLatched(sinkNode.getPrimaryCtx(), [&](hipStream_t stream) {
+        ptrChaseKernel(node.getBuffer(), accessCount, sinkNode.getBuffer(), stream);
+    });
+    output->recordMeasurement(sinkNode, node, 1, node.getBufferSize(), elapsedStat, 1e6 / accessCount, "ns");
+    double elapsed = elapsedStat.returnAppropriateMetric();
+
+    VERBOSE << "\tDevice " << srcDeviceId << " -> " << node.getNodeString() << ": " << accessCount << " accesses in " << elapsed << " ms\n";
+
+    return elapsed * 1e6 / accessCount;
+}
+
+MemAtomicOperation::MemAtomicOperation(unsigned long long loopCount, AtomicOp op) :
+        op(op), opsPerThread(loopCount * ATOMIC_OPS_PER_THREAD_PER_LOOP), latencyOpCount(loopCount * ATOMIC_LATENCY_OPS_PER_LOOP) {}
+
+double MemAtomicOperation::doAtomicThroughput(int srcDeviceId, const MemcpyNode &node, unsigned int contention) {
+    CU_ASSERT(hipCtxSetCurrent(BufferPool::getPrimaryCtx(node.getOwnerDeviceIdx())));
+    CU_ASSERT(hipMemset(node.getBuffer(), 0, node.getBufferSize()));
+
+    DeviceNode sinkNode(sizeof(unsigned int), srcDeviceId);
+    unsigned long long opCount = 0;
+    PerformanceStatistic elapsedStat = MemcpyOperation::sampleLatched(sinkNode.getPrimaryCtx(), [&](hipStream_t stream) {
+        opCount = atomicThroughputKernel(node.getBuffer(), node.getBufferSize(), op, contention, opsPerThread, sinkNode.getBuffer(), stream);
+    });
+    // elapsed times are in ms and never 0, sampleLatched re-runs those samples, recorded as Mops/s
+    PerformanceStatistic throughputStat;
+    for (double elapsed : elapsedStat.samples()) {
+        throughputStat(opCount * 1e3 / elapsed);
+    }
+    output->recordMeasurement(sinkNode, node, 1, node.getBufferSize(), throughputStat, 1e-6, "Mops/s");
+    double throughput = throughputStat.returnAppropriateMetric() * 1e-6;
+
+    VERBOSE << "\tDevice " << srcDeviceId << " -> " << node.getNodeString() << ": " << opCount << " atomic " << atomicOpNames[op] << " with "
+            << contention << " threads per word at " << std::fixed << std::setprecision(2) << throughput << " Mops/s\n";
+
+    return throughput;
+}
+
+double MemAtomicOperation::doAtomicLatency(int srcDeviceId, const MemcpyNode &node) {
+    CU_ASSERT(hipCtxSetCurrent(BufferPool::getPrimaryCtx(node.getOwnerDeviceIdx())));
+    CU_ASSERT(hipMemset(node.getBuffer(), 0, sizeof(unsigned int)));
+
+    DeviceNode sinkNode(sizeof(unsigned int), srcDeviceId);
+    PerformanceStatistic elapsedStat = MemcpyOperation::sampleLatched(sinkNode.getPrimaryCtx(), [&](hipStream_t stream) {
+        atomicLatencyKernel(node.getBuffer(), op, latencyOpCount, sinkNode.getBuffer(), stream);
+    });
+    output->recordMeasurement(sinkNode, node, 1, sizeof(unsigned int), elapsedStat, 1e6 / latencyOpCount, "ns");
+    double elapsed = elapsedStat.returnAppropriateMetric();
+
+    VERBOSE << "\tDevice " << srcDeviceId << " -> " << node.getNodeString() << ": " << latencyOpCount << " dependent atomic " << atomicOpNames[op] << " in " << elapsed << " ms\n";
+
+    return elapsed * 1e6 / latencyOpCount;
+}
+
+MemcpyRoundTripOperationCE::MemcpyRoundTripOperationCE(unsigned long long loopCount, size_t copySize) :
+        roundTripCount(loopCount * ROUND_TRIPS_PER_LOOP), copySize(copySize) {}
+
+double MemcpyRoundTripOperationCE::doRoundTrip(const MemcpyNode &hostNode, const MemcpyNode &deviceNode) {
+    assert(copySize <= hostNode.getBufferSize() && copySize <= deviceNode.getBufferSize());
+
+    // every round trip queues two copies, the latched sections together run all of them
+    unsigned long long sectionRoundTrips = MAX_LATCHED_COMMANDS / 2;
+    unsigned long long sections = (roundTripCount + sectionRoundTrips - 1) / sectionRoundTrips;
+    PerformanceStatistic elapsedStat = MemcpyOperation::sampleLatched(deviceNode.getPrimaryCtx(), sections, [&](hipStream_t stream, unsigned long long section) {
+        unsigned long long first = section * sectionRoundTrips;
+        for (unsigned long long l = first; l < std::min(first + sectionRoundTrips, roundTripCount); l++) {
+            CU_ASSERT(hipMemcpyAsync(deviceNode.getBuffer(), hostNode.getBuffer(), copySize, hipMemcpyDefault, stream));
+            CU_ASSERT(hipMemcpyAsync(hostNode.getBuffer(), deviceNode.getBuffer(), copySize, hipMemcpyDefault, stream));
+        }
+    });
+    output->recordMeasurement(hostNode, deviceNode, 1, copySize, elapsedStat, 1e6 / roundTripCount, "ns");
+    double elapsed = elapsedStat.returnAppropriateMetric();
+
+    VERBOSE << "\t" << hostNode.getNodeString() << " <-> " << deviceNode.getNodeString() << ": " << roundTripCount << " round trips in " << elapsed << " ms\n";
+
+    return elapsed * 1e6 / roundTripCount;
+}
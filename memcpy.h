@@ -18,7 +18,52 @@
 #ifndef MEMCPY_H
 #define MEMCPY_H
 
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+
 #include "common.h"
+#include "counters.h"
+#include "kernels.h"
+
+// Caches node buffers by owner and size, so nodes created for every peer pair and testcase lease an
+// existing allocation instead of paying for allocation, pinning and primary context retains each time.
+// Each size class is allocated once per device (or per host NUMA placement) and kept until clear().
+class BufferPool {
+private:
+    enum DeviceMemKind {
+        DEVICE_MEM_COARSE_GRAINED,
+        DEVICE_MEM_FINE_GRAINED
+    };
+
+    // (isHost, deviceIdx, size, memType, numaNode, deviceMemKind). Host buffers are keyed by the device whose NUMA affinity they
+    // were allocated with, or by an explicit NUMA node when numaNode isn't -1, and ignore deviceMemKind. Device buffers
+    // ignore memType and numaNode
+    typedef std::tuple<bool, int, size_t, HostMemType, int, DeviceMemKind> Key;
+
+    static std::map<Key, std::vector<void*>> freeBuffers;
+    static std::map<void*, Key> leasedBuffers;
+    static std::map<int, hipCtx_t> primaryCtxs;
+
+    static void* lease(const Key &key);
+    static hipError_t allocate(const Key &key, void** buffer);
+    static void deallocate(const Key &key, void* buffer);
+    // Frees the idle buffers matching isHost (and deviceIdx for device buffers), used when an allocation runs out of memory
+    static void trim(bool isHost, int deviceIdx);
+public:
+    static void* leaseHostBuffer(size_t size, int targetDeviceId, HostMemType memType, int numaNode = -1);
+    static void* leaseDeviceBuffer(size_t size, int deviceIdx, bool fineGrained = false);
+    static void* leaseManagedBuffer(size_t size, int deviceIdx);
+    static void release(void* buffer);
+
+    // The pool retains each primary context once, so nodes don't retain and release it per allocation
+    static hipCtx_t getPrimaryCtx(int deviceIdx);
+
+    // Frees every idle buffer and releases the retained primary contexts
+    static void clear();
+};
 
 class MemcpyNode {
 protected:
@@ -33,21 +78,50 @@ public:
     virtual int getNodeIdx() const = 0;
     virtual hipCtx_t getPrimaryCtx() const = 0;
     virtual std::string getNodeString() const = 0;
-    static void memsetPattern(hipDeviceptr_t buffer, unsigned long long size, unsigned int seed);
-    static void memcmpPattern(hipDeviceptr_t buffer, unsigned long long size, unsigned int seed);
+    // Device whose kernels fill and verify the buffer's pattern
+    virtual int getOwnerDeviceIdx() const = 0;
+
+    // Pattern fill and verification run as kernels on the owning device, on the first size bytes of the buffer
+    virtual void memsetPattern(unsigned long long size, unsigned int seed) const;
+    void memcmpPattern(unsigned long long size, unsigned int seed) const;
     static void xorshift2MBPattern(unsigned int* buffer, unsigned int seed);
+    // Buffers kernels can't access, like pageable host memory, are filled and verified by the CPU
+    virtual bool isKernelAccessible() const { return true; }
+    // Copies from or to pageable memory may block the host until they complete, so they can't be latched
+    virtual bool isPageable() const { return false; }
+    // Frees the per device pattern tables and check results
+    static void freePatternResources();
+private:
+    // The 2MB xorshift pattern of seed, uploaded once to each owning device
+    static std::map<std::pair<int, unsigned int>, hipDeviceptr_t> patternTables;
+    static std::map<int, PatternCheckResult*> patternCheckResults;
+    static std::map<unsigned int, std::vector<unsigned int>> hostPatternTables;
+    hipDeviceptr_t getPatternTable(unsigned int seed) const;
+    static const std::vector<unsigned int> &getHostPatternTable(unsigned int seed);
 };
 
 // Represents the host buffer abstraction
 class HostNode : public MemcpyNode {
+private:
+    int targetDeviceId;
+    HostMemType memType;
+    int numaNode;
 public:
-    // NUMA affinity is set here through allocation of memory in the socket group where `targetDeviceId` resides
-    HostNode(size_t bufferSize, int targetDeviceId);
+    // NUMA affinity is set here through allocation of memory in the socket group where `targetDeviceId` resides,
+    // or on `numaNode` when it isn't -1
+    HostNode(size_t bufferSize, int targetDeviceId, HostMemType memType = hostMemType, int numaNode = -1);
     ~HostNode();
 
+    bool isKernelAccessible() const override;
+    bool isPageable() const override;
+    HostMemType getMemType() const;
+    // NUMA node the buffer was explicitly placed on, -1 if it follows the target device
+    int getNumaNode() const { return numaNode; }
+
     int getNodeIdx() const override;
     hipCtx_t getPrimaryCtx() const override;
     virtual std::string getNodeString() const override;
+    int getOwnerDeviceIdx() const override;
 };
 
 // Represents the device buffer and context abstraction
@@ -56,16 +130,73 @@ private:
     int deviceIdx;
     hipCtx_t primaryCtx{};
 public:
-    DeviceNode(size_t bufferSize, int deviceIdx);
+    // Fine grained buffers stay coherent with the peers and the host while kernels run, for system scope atomics
+    DeviceNode(size_t bufferSize, int deviceIdx, bool fineGrained = false);
     ~DeviceNode();
 
     int getNodeIdx() const override;
     hipCtx_t getPrimaryCtx() const override;
     virtual std::string getNodeString() const override;
+    int getOwnerDeviceIdx() const override;
 
     bool enablePeerAcess(const DeviceNode &peerNode);
 };
 
+// Represents a hipMallocManaged buffer whose pages start every sample at a home location
+class ManagedNode : public MemcpyNode {
+private:
+    int homeDeviceId;   // hipCpuDeviceId for host memory
+    int ownerDeviceId;
+public:
+    // ownerDeviceId fills and verifies the pattern, the pages are moved back home afterwards
+    ManagedNode(size_t bufferSize, int homeDeviceId, int ownerDeviceId);
+    ~ManagedNode();
+
+    int getNodeIdx() const override;
+    hipCtx_t getPrimaryCtx() const override;
+    virtual std::string getNodeString() const override;
+    int getOwnerDeviceIdx() const override;
+
+    void memsetPattern(unsigned long long size, unsigned int seed) const override;
+};
+
+// Samples timed as 0 us after which a measurement gives up, its copies are too short for the timer
+const unsigned int MAX_UNTIMED_SAMPLES = 16;
+
+// Buffer streamed by the hbm background load, large enough to miss the last level caches
+const size_t BACKGROUND_LOAD_BUFFER_SIZE = 1024ull * 1024 * 1024;
+
+// Background kernel keeping one device busy while copies are measured. Its completed work is accumulated over
+// every run, so its rate next to the copies can be compared against its rate with the device to itself.
+class BackgroundLoad {
+private:
+    BackgroundLoadType type;
+    int deviceIdx;
+    DeviceNode node;
+    hipStream_t stream;
+    hipEvent_t startEvent, endEvent;
+    unsigned long long *progress;
+    // stop and running flags shared with the kernel
+    volatile int *control;
+    unsigned long long units = 0;
+    double seconds = 0.0;
+public:
+    BackgroundLoad(BackgroundLoadType type, int deviceIdx);
+    ~BackgroundLoad();
+
+    // Launches the kernel and returns once it runs on the device
+    void start();
+    // Stops the kernel and adds the work it completed
+    void stop();
+    // Runs the kernel alone for the given wall time
+    void runAlone(double runSeconds);
+
+    // Work units per second and seconds run since the last reset
+    double getRate() const { return seconds > 0.0 ? units / seconds : 0.0; }
+    double getSeconds() const { return seconds; }
+    void reset();
+};
+
 // Abstraction of a memcpy operation
 class MemcpyOperation {
 public:
@@ -85,45 +216,321 @@ public:
 
 private:
     unsigned long long loopCount;
+    // Bandwidth of each simultaneous copy measured by the last doMemcpy call, in GB/s
+    std::vector<double> copyBandwidths;
 
 protected:
     size_t *procMask;
     ContextPreference ctxPreference;
     BandwidthValue bandwidthValue;
+    // started before the copies of every sample are released and stopped once they completed
+    BackgroundLoad *backgroundLoad = nullptr;
 
     // Pure virtual function for implementation of the actual memcpy function
     // return actual bytes copied
     // This can vary from copySize due to SM copies truncated the copy to achieve max bandwidth
     virtual size_t memcpyFunc(hipDeviceptr_t dst, hipDeviceptr_t src, hipStream_t stream, size_t copySize, unsigned long long loopCount) = 0;
+
+    // Copies issued before and during each sample. Operations that move pages can only do it once per sample
+    virtual unsigned long long getWarmupCount() const;
+    virtual unsigned long long getTimedLoopCount() const;
+    // Whether the copies of a sample can be held back by the spin kernel until they are all enqueued
+    virtual bool isLatched() const { return true; }
+    // Parameters of the copies a memcpyFunc call issues beyond its arguments, they tell the graphs captured
+    // with --useGraphs of operations of the same type apart
+    virtual std::string graphParameters() const { return ""; }
+    // Node whose buffer must hold the source pattern after a sample
+    virtual const MemcpyNode &getVerifiedNode(const MemcpyNode &srcNode, const MemcpyNode &dstNode) const { return dstNode; }
+
+    // Statistics collected over the samples of one measurement, bandwidths in bytes/s
+    struct SampleStatistics {
+        std::vector<PerformanceStatistic> bandwidths;
+        PerformanceStatistic totalBandwidth;
+        PerformanceStatistic sumBandwidth;
+        // largest start delay of a copy after copy 0 in each sample, in microseconds
+        PerformanceStatistic startSkew;
+        // single copy times of every sample, with --perIterationTiming
+        std::vector<TimingHistogram> iterationTimes;
+#ifdef ROCM_SMI
+        // counters of the devices owning the nodes over the timed sections, with --counters
+        std::vector<DeviceCounters> counters;
+#endif
+
+        SampleStatistics(size_t copies) : bandwidths(copies), iterationTimes(copies) {}
+    };
+
+    // Calls measure with the copy sizes of every measured size, all buffer sizes or every --sweep step, returns the last result
+    double measureSizes(const std::vector<const MemcpyNode*> &srcNodes, const std::vector<const MemcpyNode*> &dstNodes,
+                        const std::function<double(const std::vector<size_t> &)> &measure);
+#ifdef ROCM_SMI
+    // Sampler of the devices owning the nodes, null without --counters
+    static std::unique_ptr<CounterSampler> createCounterSampler(const std::vector<const MemcpyNode*> &srcNodes, const std::vector<const MemcpyNode*> &dstNodes);
+#endif
+    // Runs the work enqueued by enqueue on a latched arena stream of ctx and returns its elapsed time in ms
+    static float timeLatched(hipCtx_t ctx, const std::function<void(hipStream_t)> &enqueue);
+    // Records the statistics in the output and returns the bandwidth selected by bandwidthValue in GB/s
+    double reportBandwidth(const std::vector<const MemcpyNode*> &srcNodes, const std::vector<const MemcpyNode*> &dstNodes,
+                           const std::vector<size_t> &copySizes, const SampleStatistics &stats);
 public:
     MemcpyOperation(unsigned long long loopCount, ContextPreference ctxPreference = ContextPreference::PREFER_SRC_CONTEXT, BandwidthValue bandwidthValue = BandwidthValue::USE_FIRST_BW);
     virtual ~MemcpyOperation();
 
     // Lists of paired nodes will be executed sumultaneously
     // context of srcNodes is preferred (if not host) unless otherwise specified
-    double doMemcpy(const std::vector<const MemcpyNode*> &srcNodes, const std::vector<const MemcpyNode*> &dstNodes);
+    virtual double doMemcpy(const std::vector<const MemcpyNode*> &srcNodes, const std::vector<const MemcpyNode*> &dstNodes);
     double doMemcpy(const MemcpyNode &srcNode, const MemcpyNode &dstNode);
+    // Per copy bandwidths (GB/s) of the last doMemcpy call, in the order of its node lists
+    const std::vector<double> &getCopyBandwidths() const;
+    // Runs load during the timed section of every sample of the following doMemcpy calls, nullptr to stop
+    void setBackgroundLoad(BackgroundLoad *load) { backgroundLoad = load; }
+
+    // Destroys the streams, events, captured graphs and latch of all arenas, contexts must still be alive
+    static void freeArenas();
+    // Samples the work enqueued by enqueue on a latched arena stream of ctx, so enqueue overhead is excluded like in doMemcpy.
+    // Returns the statistic of the elapsed times in ms.
+    static PerformanceStatistic sampleLatched(hipCtx_t ctx, const std::function<void(hipStream_t)> &enqueue);
+    // Same for work too large to queue behind the spin kernel at once: every sample runs sections latched one after the
+    // other, enqueued by enqueueSection(stream, section), and is the sum of their elapsed times
+    static PerformanceStatistic sampleLatched(hipCtx_t ctx, unsigned long long sections,
+                                              const std::function<void(hipStream_t, unsigned long long)> &enqueueSection);
 private:
+    // Streams and events created in one context. Arenas grow on demand and are reused by every
+    // doMemcpy call of every testcase, so samples aren't preceded by driver resource creation
+    struct ContextArena {
+        std::vector<hipStream_t> streams;
+        std::vector<hipEvent_t> startEvents;
+        std::vector<hipEvent_t> endEvents;
+        // events recorded after every copy of a sample with --perIterationTiming, per stream
+        std::vector<std::vector<hipEvent_t>> iterationEvents;
+        hipEvent_t totalEnd{};
+    };
+    static std::map<hipCtx_t, ContextArena> arenas;
+    // Latch released by the host to start all copies, shared by all operations
+    static volatile int* blockingVar;
+
+    // Creates the stream and events of the arena's slot if it doesn't have them yet, in the current context
+    static void reserveArenaSlot(ContextArena &arena, size_t slot);
+    static volatile int* getBlockingVar();
+
+    // Copy sequences captured with --useGraphs, keyed by (operation type and graphParameters, stream, dst, src, size, count)
+    typedef std::tuple<std::string, hipStream_t, hipDeviceptr_t, hipDeviceptr_t, size_t, unsigned long long> GraphKey;
+    struct CapturedCopies {
+        hipGraphExec_t exec;
+        size_t copiedBytes;
+    };
+    static std::map<GraphKey, CapturedCopies> capturedCopies;
+    static std::mutex capturedCopiesMutex;
+
+    // Enqueues count copies with memcpyFunc, or with --useGraphs launches them as one graph captured on first use
+    size_t enqueueCopies(hipDeviceptr_t dst, hipDeviceptr_t src, hipStream_t stream, size_t copySize, unsigned long long count);
+
+    // Resources of the simultaneous copies shared by every size measured in one doMemcpy call
+    struct CopyResources {
+        std::vector<hipCtx_t> contexts;
+        std::vector<hipStream_t> streams;
+        std::vector<hipEvent_t> startEvents;
+        std::vector<hipEvent_t> endEvents;
+        // arena slot of each copy's stream and events
+        std::vector<size_t> slots;
+        hipEvent_t totalEnd;
+        volatile int* blockingVar;
+    };
+
+    // Iteration events of the copy's arena slot, created on first use until there are count of them
+    std::vector<hipEvent_t> &getIterationEvents(const CopyResources &resources, int copy, unsigned long long count);
+
+    // Samples the simultaneous copies of copySizes[i] bytes from the start of each node's buffer
+    double measureBandwidth(const std::vector<const MemcpyNode*> &srcNodes, const std::vector<const MemcpyNode*> &dstNodes,
+                            const std::vector<size_t> &copySizes, CopyResources &resources);
+
     // Pure virtual function to get final calculated copy sizes
-    virtual size_t getAdjustedCopySize (size_t size, hipStream_t stream) = 0;
+    virtual size_t getAdjustedCopySize(hipDeviceptr_t dst, hipDeviceptr_t src, size_t size, hipStream_t stream) = 0;
 };
 
 class MemcpyOperationSM : public MemcpyOperation {
 private:
+    // (device, source link, destination link, copy size)
+    typedef std::tuple<int, std::string, std::string, size_t> TuneKey;
+    // Autotuned kernel configs, shared by every operation and testcase
+    static std::map<TuneKey, SmCopyConfig> tunedConfigs;
+
     size_t memcpyFunc(hipDeviceptr_t dst, hipDeviceptr_t src, hipStream_t stream, size_t copySize, unsigned long long loopCount);
-    // Calculate the truncated sizes used by copy kernels
-    size_t getAdjustedCopySize(size_t size, hipStream_t stream);
+    // Calculate the truncated sizes used by copy kernels, autotuning the kernel first if needed
+    size_t getAdjustedCopySize(hipDeviceptr_t dst, hipDeviceptr_t src, size_t size, hipStream_t stream);
+    // Kernel config for copies between dst and src from the stream's device, the default one unless --smAutotune is used
+    SmCopyConfig getCopyConfig(hipDeviceptr_t dst, hipDeviceptr_t src, size_t size, hipStream_t stream);
+    // Times one config on the unlatched stream, returns bytes/s
+    double timeCopyConfig(const SmCopyConfig &config, hipDeviceptr_t dst, hipDeviceptr_t src, size_t size, hipStream_t stream);
 public:
     MemcpyOperationSM(unsigned long long loopCount, ContextPreference ctxPreference = ContextPreference::PREFER_SRC_CONTEXT, BandwidthValue bandwidthValue = BandwidthValue::SUM_BW);
 };
 
+// SM kernel only reading the source buffer, the destination is the kernel's sink. Runs in the destination's
+// context by default, so the reading device is the one owning the destination.
+class MemcpyOperationSMRead : public MemcpyOperation {
+private:
+    size_t memcpyFunc(hipDeviceptr_t dst, hipDeviceptr_t src, hipStream_t stream, size_t copySize, unsigned long long loopCount);
+    size_t getAdjustedCopySize(hipDeviceptr_t dst, hipDeviceptr_t src, size_t size, hipStream_t stream);
+    // the destination never receives the pattern, the source must still hold it
+    const MemcpyNode &getVerifiedNode(const MemcpyNode &srcNode, const MemcpyNode &dstNode) const override { return srcNode; }
+public:
+    MemcpyOperationSMRead(unsigned long long loopCount, ContextPreference ctxPreference = ContextPreference::PREFER_DST_CONTEXT, BandwidthValue bandwidthValue = BandwidthValue::USE_FIRST_BW);
+};
+
+// SM kernel only writing the destination buffer, the source is unused. Runs in the source's context by default.
+class MemcpyOperationSMWrite : public MemcpyOperation {
+private:
+    size_t memcpyFunc(hipDeviceptr_t dst, hipDeviceptr_t src, hipStream_t stream, size_t copySize, unsigned long long loopCount);
+    size_t getAdjustedCopySize(hipDeviceptr_t dst, hipDeviceptr_t src, size_t size, hipStream_t stream);
+    // the fill value isn't the pattern, only the untouched source can be checked
+    const MemcpyNode &getVerifiedNode(const MemcpyNode &srcNode, const MemcpyNode &dstNode) const override { return srcNode; }
+public:
+    MemcpyOperationSMWrite(unsigned long long loopCount, ContextPreference ctxPreference = ContextPreference::PREFER_SRC_CONTEXT, BandwidthValue bandwidthValue = BandwidthValue::USE_FIRST_BW);
+};
+
+// SM kernel reading the source buffer in chunks of an access pattern into the destination's sink, in the
+// destination's context by default like MemcpyOperationSMRead
+class MemcpyOperationSMAccessPattern : public MemcpyOperation {
+private:
+    AccessPattern pattern;
+
+    std::string graphParameters() const override {
+        return std::to_string(pattern.accessSize) + "/" + std::to_string(pattern.strideChunks) + "/" + (pattern.random ? "random" : "ordered");
+    }
+    size_t memcpyFunc(hipDeviceptr_t dst, hipDeviceptr_t src, hipStream_t stream, size_t copySize, unsigned long long loopCount);
+    size_t getAdjustedCopySize(hipDeviceptr_t dst, hipDeviceptr_t src, size_t size, hipStream_t stream);
+    const MemcpyNode &getVerifiedNode(const MemcpyNode &srcNode, const MemcpyNode &dstNode) const override { return srcNode; }
+public:
+    MemcpyOperationSMAccessPattern(unsigned long long loopCount, const AccessPattern &pattern,
+                                   ContextPreference ctxPreference = ContextPreference::PREFER_DST_CONTEXT, BandwidthValue bandwidthValue = BandwidthValue::USE_FIRST_BW);
+};
+
 class MemcpyOperationCE : public MemcpyOperation {
 private:
     size_t memcpyFunc(hipDeviceptr_t dst, hipDeviceptr_t src, hipStream_t stream, size_t copySize, unsigned long long loopCount);
     // CE copies do not adjust size, so a simple return of size
-    size_t getAdjustedCopySize(size_t size, hipStream_t stream);
+    size_t getAdjustedCopySize(hipDeviceptr_t dst, hipDeviceptr_t src, size_t size, hipStream_t stream);
 public:
     MemcpyOperationCE(unsigned long long loopCount, ContextPreference ctxPreference = ContextPreference::PREFER_SRC_CONTEXT, BandwidthValue bandwidthValue = BandwidthValue::USE_FIRST_BW);
 };
 
+// CE copies forced onto the SDMA engines, even the device local ones the runtime would do with a blit kernel
+class MemcpyOperationCESdma : public MemcpyOperationCE {
+private:
+    size_t memcpyFunc(hipDeviceptr_t dst, hipDeviceptr_t src, hipStream_t stream, size_t copySize, unsigned long long loopCount);
+public:
+    MemcpyOperationCESdma(unsigned long long loopCount, ContextPreference ctxPreference = ContextPreference::PREFER_SRC_CONTEXT, BandwidthValue bandwidthValue = BandwidthValue::USE_FIRST_BW);
+
+    // Throws for nodes whose memory isn't pinned and mapped, which NoCU copies can't reach
+    static void checkSdmaNodes(const std::vector<const MemcpyNode*> &nodes);
+    double doMemcpy(const std::vector<const MemcpyNode*> &srcNodes, const std::vector<const MemcpyNode*> &dstNodes) override;
+    using MemcpyOperation::doMemcpy;
+};
+
+// CE operation of the copy path selected with --ceCopyPath, or MemcpyOperationHsa with --backend hsa. Blit copies
+// use MemcpyOperationCE, SDMA is disabled for the whole process before hipInit
+std::unique_ptr<MemcpyOperation> createMemcpyOperationCE(unsigned long long loopCount,
+                                                         MemcpyOperation::ContextPreference ctxPreference = MemcpyOperation::PREFER_SRC_CONTEXT,
+                                                         MemcpyOperation::BandwidthValue bandwidthValue = MemcpyOperation::USE_FIRST_BW);
+
+// CE copies split into chunkSize chunks spread round robin over streamCount streams: the copy's own stream and
+// streamCount - 1 helper streams forked from it and joined back after the copies of each call
+class MemcpyOperationCEPipelined : public MemcpyOperation {
+private:
+    struct Pipeline {
+        std::vector<hipStream_t> helperStreams;
+        hipEvent_t fork;
+        std::vector<hipEvent_t> joins;
+    };
+
+    size_t chunkSize;
+    unsigned int streamCount;
+    // helper streams of each copy stream, created in the stream's context on first use
+    std::map<hipStream_t, Pipeline> pipelines;
+    std::mutex pipelinesMutex;
+
+    Pipeline &getPipeline(hipStream_t stream);
+    std::string graphParameters() const override { return std::to_string(chunkSize) + "/" + std::to_string(streamCount); }
+    size_t memcpyFunc(hipDeviceptr_t dst, hipDeviceptr_t src, hipStream_t stream, size_t copySize, unsigned long long loopCount);
+    size_t getAdjustedCopySize(hipDeviceptr_t dst, hipDeviceptr_t src, size_t size, hipStream_t stream);
+public:
+    MemcpyOperationCEPipelined(unsigned long long loopCount, size_t chunkSize, unsigned int streamCount,
+                               ContextPreference ctxPreference = ContextPreference::PREFER_SRC_CONTEXT, BandwidthValue bandwidthValue = BandwidthValue::USE_FIRST_BW);
+    ~MemcpyOperationCEPipelined();
+
+    double doMemcpy(const std::vector<const MemcpyNode*> &srcNodes, const std::vector<const MemcpyNode*> &dstNodes) override;
+    using MemcpyOperation::doMemcpy;
+};
+
+// Migrates a managed source buffer to the destination node's device with hipMemPrefetchAsync, prefetching
+// pageSize bytes per call. The destination buffer is unused.
+class MemcpyOperationPrefetch : public MemcpyOperation {
+private:
+    size_t pageSize;
+
+    size_t memcpyFunc(hipDeviceptr_t dst, hipDeviceptr_t src, hipStream_t stream, size_t copySize, unsigned long long loopCount);
+    size_t getAdjustedCopySize(hipDeviceptr_t dst, hipDeviceptr_t src, size_t size, hipStream_t stream);
+    const MemcpyNode &getVerifiedNode(const MemcpyNode &srcNode, const MemcpyNode &dstNode) const override { return srcNode; }
+public:
+    MemcpyOperationPrefetch(unsigned long long loopCount, size_t pageSize);
+
+    // Migrates the buffer once per sample, thousands of small prefetches would fill the queue while the host holds the
+    // latch, so they are latched in sections of a bounded number of prefetches whose times add up to the sample
+    double doMemcpy(const std::vector<const MemcpyNode*> &srcNodes, const std::vector<const MemcpyNode*> &dstNodes) override;
+    using MemcpyOperation::doMemcpy;
+};
+
+// Migrates a managed source buffer on demand with a kernel on the destination node's device reading one
+// element of every pageSize bytes. The destination buffer receives the kernel's sink value only.
+class MemcpyOperationPageFault : public MemcpyOperation {
+private:
+    size_t pageSize;
+
+    size_t memcpyFunc(hipDeviceptr_t dst, hipDeviceptr_t src, hipStream_t stream, size_t copySize, unsigned long long loopCount);
+    size_t getAdjustedCopySize(hipDeviceptr_t dst, hipDeviceptr_t src, size_t size, hipStream_t stream);
+    unsigned long long getWarmupCount() const override { return 0; }
+    unsigned long long getTimedLoopCount() const override { return 1; }
+    const MemcpyNode &getVerifiedNode(const MemcpyNode &srcNode, const MemcpyNode &dstNode) const override { return srcNode; }
+public:
+    MemcpyOperationPageFault(unsigned long long loopCount, size_t pageSize);
+};
+
+// Measures the latency of dependent loads from a device onto a node's buffer with a pointer chasing kernel
+class MemPtrChaseOperation {
+private:
+    unsigned long long accessCount;
+public:
+    MemPtrChaseOperation(unsigned long long loopCount);
+
+    // Returns the average latency of one access in ns, node's buffer is overwritten with the chain
+    double doPtrChase(int srcDeviceId, const MemcpyNode &node);
+};
+
+// Measures system scope atomics from a device onto a node's fine grained buffer with a latched kernel launch
+class MemAtomicOperation {
+private:
+    AtomicOp op;
+    unsigned long long opsPerThread;
+    unsigned long long latencyOpCount;
+public:
+    MemAtomicOperation(unsigned long long loopCount, AtomicOp op);
+
+    // Returns the millions of atomics per second of a full grid of srcDeviceId, contention threads hit each word of node's buffer
+    double doAtomicThroughput(int srcDeviceId, const MemcpyNode &node, unsigned int contention);
+    // Returns the average latency in ns of one atomic issued by a single thread, each waiting for the previous one
+    double doAtomicLatency(int srcDeviceId, const MemcpyNode &node);
+};
+
+// Measures the latency of small CE copies from host to device and back, each copy depending on the previous one
+class MemcpyRoundTripOperationCE {
+private:
+    unsigned long long roundTripCount;
+    size_t copySize;
+public:
+    MemcpyRoundTripOperationCE(unsigned long long loopCount, size_t copySize = sizeof(unsigned long long));
+
+    // Returns the average latency of one round trip in ns
+    double doRoundTrip(const MemcpyNode &hostNode, const MemcpyNode &deviceNode);
+};
+
 #endif
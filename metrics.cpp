@@ -0,0 +1,186 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <arpa/inet.h>
+#include <chrono>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "metrics.h"
+
+// OpenMetrics label values escape backslashes, quotes and newlines
+static std::string labelValue(const std::string &str) {
+    std::string escaped;
+    for (char c : str) {
+        switch (c) {
+            case '\\': escaped += "\\\\"; break;
+            case '"': escaped += "\\\""; break;
+            case '\n': escaped += "\\n"; break;
+            default: escaped += c;
+        }
+    }
+    return escaped;
+}
+
+MetricsServer::MetricsServer(int port) : stopping(false), iterations(0), lastIterationSeconds(0), lastIterationTimestamp(0) {
+    listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listenFd < 0) {
+        throw std::string("Can't create the metrics socket");
+    }
+    int reuse = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(listenFd, (sockaddr *)&addr, sizeof(addr)) != 0 || listen(listenFd, 8) != 0) {
+        close(listenFd);
+        throw "Can't listen for metrics on port " + std::to_string(port);
+    }
+
+    thread = std::thread(&MetricsServer::serve, this);
+}
+
+MetricsServer::~MetricsServer() {
+    stopping = true;
+    thread.join();
+    close(listenFd);
+}
+
+void MetricsServer::beginTestcase(const std::string &key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    // the matrices of the previous pass stay visible until the testcase replaces them
+    results[key].status = "Passed";
+    results[key].nextMatrix = 0;
+}
+
+void MetricsServer::setStatus(const std::string &key, const std::string &status) {
+    std::lock_guard<std::mutex> lock(mutex);
+    results[key].status = status;
+}
+
+void MetricsServer::addTestcaseResults(const std::string &key, const PeerValueMatrix<double> &matrix, const std::string &title) {
+    std::vector<std::optional<double>> values;
+    for (int row = 0; row < matrix.m_rows; row++) {
+        for (int column = 0; column < matrix.m_columns; column++) {
+            values.push_back(matrix.value(row, column));
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    Result &result = results[key];
+    if (result.nextMatrix >= result.matrices.size()) {
+        result.matrices.resize(result.nextMatrix + 1);
+    }
+    result.matrices[result.nextMatrix++] = {title, matrix.m_columns, values};
+}
+
+void MetricsServer::finishIteration(double seconds) {
+    std::lock_guard<std::mutex> lock(mutex);
+    iterations++;
+    lastIterationSeconds = seconds;
+    lastIterationTimestamp = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+std::string MetricsServer::render() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::stringstream s;
+    s << std::defaultfloat << std::setprecision(10);
+
+    s << "# TYPE nvbandwidth_result gauge\n";
+    s << "# HELP nvbandwidth_result Latest value of each matrix cell, the unit is part of the title\n";
+    for (const auto &result : results) {
+        for (size_t m = 0; m < result.second.matrices.size(); m++) {
+            const Matrix &matrix = result.second.matrices[m];
+            for (size_t i = 0; i < matrix.values.size(); i++) {
+                if (!matrix.values[i]) {
+                    continue;
+                }
+                s << "nvbandwidth_result{testcase=\"" << labelValue(result.first) << "\",matrix=\"" << m
+                  << "\",title=\"" << labelValue(matrix.title) << "\",row=\"" << i / matrix.columns
+                  << "\",column=\"" << i % matrix.columns << "\"} " << matrix.values[i].value() << "\n";
+            }
+        }
+    }
+
+    s << "# TYPE nvbandwidth_testcase_passed gauge\n";
+    s << "# HELP nvbandwidth_testcase_passed 1 when the last run of the testcase passed, 0 when it was waived or failed\n";
+    for (const auto &result : results) {
+        s << "nvbandwidth_testcase_passed{testcase=\"" << labelValue(result.first) << "\",status=\"" << labelValue(result.second.status)
+          << "\"} " << (result.second.status == "Passed" ? 1 : 0) << "\n";
+    }
+
+    s << "# TYPE nvbandwidth_iterations counter\n";
+    s << "nvbandwidth_iterations_total " << iterations << "\n";
+    s << "# TYPE nvbandwidth_iteration_seconds gauge\n";
+    s << "# UNIT nvbandwidth_iteration_seconds seconds\n";
+    s << "nvbandwidth_iteration_seconds " << lastIterationSeconds << "\n";
+    s << "# TYPE nvbandwidth_last_iteration_timestamp_seconds gauge\n";
+    s << "# UNIT nvbandwidth_last_iteration_timestamp_seconds seconds\n";
+    s << "nvbandwidth_last_iteration_timestamp_seconds " << lastIterationTimestamp << "\n";
+    s << "# EOF\n";
+    return s.str();
+}
+
+// Every request gets the metrics whatever its path, connections are closed after one response
+void MetricsServer::serve() {
+    while (!stopping) {
+        pollfd pfd = {listenFd, POLLIN, 0};
+        if (poll(&pfd, 1, 200) <= 0) {
+            continue;
+        }
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0) {
+            continue;
+        }
+
+        // read the request headers, a slow client can't hold the server for more than a second
+        std::string request;
+        char chunk[1024];
+        pollfd cfd = {fd, POLLIN, 0};
+        while (request.find("\r\n\r\n") == std::string::npos && request.size() < 16384 && poll(&cfd, 1, 1000) > 0) {
+            ssize_t len = recv(fd, chunk, sizeof(chunk), 0);
+            if (len <= 0) {
+                break;
+            }
+            request.append(chunk, len);
+        }
+
+        std::string body = render();
+        std::stringstream response;
+        response << "HTTP/1.1 200 OK\r\n"
+                 << "Content-Type: application/openmetrics-text; version=1.0.0; charset=utf-8\r\n"
+                 << "Content-Length: " << body.size() << "\r\n"
+                 << "Connection: close\r\n\r\n";
+        if (request.rfind("HEAD ", 0) != 0) {
+            response << body;
+        }
+
+        std::string data = response.str();
+        for (size_t sent = 0; sent < data.size();) {
+            ssize_t len = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (len <= 0) {
+                break;
+            }
+            sent += len;
+        }
+        close(fd);
+    }
+}
@@ -0,0 +1,67 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <map>
+#include <mutex>
+
+#include "common.h"
+
+// Serves the latest matrix of every testcase as OpenMetrics over HTTP on a local port, for --daemon.
+// Values are replaced as each testcase finishes, the socket is served by a background thread.
+class MetricsServer {
+private:
+    struct Matrix {
+        std::string title;
+        int columns;
+        std::vector<std::optional<double>> values;
+    };
+
+    struct Result {
+        std::string status;
+        std::vector<Matrix> matrices;
+        // index of the matrix the next result of the running testcase replaces
+        size_t nextMatrix;
+    };
+
+    int listenFd;
+    std::thread thread;
+    std::atomic<bool> stopping;
+    std::mutex mutex;
+    std::map<std::string, Result> results;
+    unsigned long long iterations;
+    double lastIterationSeconds;
+    double lastIterationTimestamp;
+
+    void serve();
+    std::string render();
+public:
+    // Listens on 127.0.0.1:port, throws a string when the port can't be bound
+    MetricsServer(int port);
+    ~MetricsServer();
+
+    void beginTestcase(const std::string &key);
+    void setStatus(const std::string &key, const std::string &status);
+    void addTestcaseResults(const std::string &key, const PeerValueMatrix<double> &matrix, const std::string &title);
+    // Marks the end of a pass over the daemon testcases, which took seconds
+    void finishIteration(double seconds);
+};
+
+#endif
@@ -0,0 +1,172 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef MULTINODE
+
+#include <hip/hip_runtime.h>
+#include <memory>
+#if defined(OPEN_MPI) && OPEN_MPI
+#include <mpi-ext.h>
+#endif
+
+#include "multinode.h"
+
+int worldRank = 0;
+int worldSize = 1;
+int localDevice = 0;
+bool mpiDeviceAware = false;
+
+static const int MULTINODE_TAG = 0x6e76;
+
+static void MPI_ASSERT(int mpiResult, const char *msg = nullptr) {
+    if (mpiResult != MPI_SUCCESS) {
+        char errorString[MPI_MAX_ERROR_STRING];
+        int length = 0;
+        MPI_Error_string(mpiResult, errorString, &length);
+        std::cerr << "MPI_ERROR: [" << errorString << "] on rank " << worldRank;
+        if (msg != nullptr) std::cerr << ":\n\t" << msg;
+        std::cerr << std::endl;
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+}
+
+MultinodeSession::MultinodeSession(int &argc, char **&argv, bool forceStaged) {
+    MPI_ASSERT(MPI_Init(&argc, &argv));
+    MPI_ASSERT(MPI_Comm_rank(MPI_COMM_WORLD, &worldRank));
+    MPI_ASSERT(MPI_Comm_size(MPI_COMM_WORLD, &worldSize));
+
+    // ranks on the same node share its devices
+    MPI_Comm nodeComm;
+    int nodeRank;
+    MPI_ASSERT(MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, worldRank, MPI_INFO_NULL, &nodeComm));
+    MPI_ASSERT(MPI_Comm_rank(nodeComm, &nodeRank));
+    MPI_ASSERT(MPI_Comm_free(&nodeComm));
+
+    int localDeviceCount = 0;
+    CU_ASSERT(hipGetDeviceCount(&localDeviceCount));
+    localDevice = localDeviceCount > 0 ? nodeRank % localDeviceCount : 0;
+
+#if defined(MPIX_ROCM_AWARE_SUPPORT) && MPIX_ROCM_AWARE_SUPPORT
+    mpiDeviceAware = !forceStaged && MPIX_Query_rocm_support() == 1;
+#else
+    mpiDeviceAware = false;
+#endif
+    // every rank has to agree, a single staged rank stages everyone
+    int deviceAware = mpiDeviceAware;
+    MPI_ASSERT(MPI_Allreduce(MPI_IN_PLACE, &deviceAware, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD));
+    mpiDeviceAware = deviceAware;
+
+    if (worldRank != 0) {
+        std::cout.rdbuf(nullptr);
+    }
+}
+
+MultinodeSession::~MultinodeSession() {
+    MPI_Finalize();
+}
+
+MultinodeMemcpyOperation::MultinodeMemcpyOperation(unsigned long long loopCount, bool bidirectional) : loopCount(loopCount), bidirectional(bidirectional) {}
+
+void MultinodeMemcpyOperation::transfer(int srcRank, int dstRank, const MemcpyNode &sendNode, const MemcpyNode &recvNode,
+                                        const MemcpyNode *sendStage, const MemcpyNode *recvStage, size_t size, unsigned long long count) {
+    bool sends = worldRank == srcRank || bidirectional;
+    bool receives = worldRank == dstRank || bidirectional;
+    int peerRank = worldRank == srcRank ? dstRank : srcRank;
+    void *sendBuffer = (void *)(mpiDeviceAware ? sendNode.getBuffer() : sendStage->getBuffer());
+    void *recvBuffer = (void *)(mpiDeviceAware ? recvNode.getBuffer() : recvStage->getBuffer());
+
+    for (unsigned long long l = 0; l < count; l++) {
+        MPI_Request requests[2];
+        int requestCount = 0;
+
+        if (sends && !mpiDeviceAware) {
+            CU_ASSERT(hipMemcpy(sendBuffer, (void *)sendNode.getBuffer(), size, hipMemcpyDefault));
+        }
+        if (receives) {
+            MPI_ASSERT(MPI_Irecv(recvBuffer, (int)size, MPI_BYTE, peerRank, MULTINODE_TAG, MPI_COMM_WORLD, &requests[requestCount++]));
+        }
+        if (sends) {
+            MPI_ASSERT(MPI_Isend(sendBuffer, (int)size, MPI_BYTE, peerRank, MULTINODE_TAG, MPI_COMM_WORLD, &requests[requestCount++]));
+        }
+        MPI_ASSERT(MPI_Waitall(requestCount, requests, MPI_STATUSES_IGNORE));
+        if (receives && !mpiDeviceAware) {
+            CU_ASSERT(hipMemcpy((void *)recvNode.getBuffer(), recvBuffer, size, hipMemcpyDefault));
+        }
+    }
+}
+
+double MultinodeMemcpyOperation::doMemcpy(int srcRank, int dstRank, const MemcpyNode &deviceNode) {
+    PerformanceStatistic bandwidthStat;
+    bool participates = worldRank == srcRank || worldRank == dstRank;
+    // MPI counts are ints, larger buffers are sent as their first INT_MAX bytes rounded down to a uint4
+    size_t size = std::min(deviceNode.getBufferSize(), (size_t)INT_MAX & ~(sizeof(uint4) - 1));
+
+    MPI_Comm pairComm;
+    MPI_ASSERT(MPI_Comm_split(MPI_COMM_WORLD, participates ? 0 : MPI_UNDEFINED, worldRank, &pairComm));
+
+    if (participates) {
+        // staging buffers are pinned close to this rank's device
+        std::unique_ptr<HostNode> sendStage, recvStage;
+        if (!mpiDeviceAware) {
+            sendStage.reset(new HostNode(size, localDevice));
+            recvStage.reset(new HostNode(size, localDevice));
+        }
+        // bidirectional copies receive into a second buffer, so the one being sent isn't overwritten
+        std::unique_ptr<DeviceNode> bidirRecvNode;
+        if (bidirectional) {
+            bidirRecvNode.reset(new DeviceNode(size, localDevice));
+        }
+        const MemcpyNode &recvNode = bidirectional ? *bidirRecvNode : deviceNode;
+        unsigned int ownSeed = worldRank == srcRank ? 0xBAADF00D : 0xCAFEBABE;
+        unsigned int peerSeed = worldRank == srcRank ? 0xCAFEBABE : 0xBAADF00D;
+        CU_ASSERT(hipCtxSetCurrent(deviceNode.getPrimaryCtx()));
+
+        // warmup, lets MPI register the buffers and set up the connection
+        transfer(srcRank, dstRank, deviceNode, recvNode, sendStage.get(), recvStage.get(), size, 1);
+
+        for (unsigned long long n = 0; n < averageLoopCount; n++) {
+            // received buffers start with this rank's pattern and must end with the peer's
+            deviceNode.memsetPattern(size, ownSeed);
+            if (bidirectional) {
+                recvNode.memsetPattern(size, ownSeed);
+            }
+
+            MPI_ASSERT(MPI_Barrier(pairComm));
+            double start = MPI_Wtime();
+            transfer(srcRank, dstRank, deviceNode, recvNode, sendStage.get(), recvStage.get(), size, loopCount);
+            double elapsed = MPI_Wtime() - start;
+
+            if (worldRank == dstRank) {
+                double bandwidth = (double)size * loopCount / elapsed;
+                bandwidthStat(bandwidth);
+                VERBOSE << "\tSample " << n << ": rank " << srcRank << " -> rank " << dstRank << ": " <<
+                    std::fixed << std::setprecision(2) << bandwidth * 1e-9 << " GB/s\n";
+            }
+            if (!skipVerification && (worldRank == dstRank || bidirectional)) {
+                recvNode.memcmpPattern(size, peerSeed);
+            }
+        }
+        MPI_ASSERT(MPI_Comm_free(&pairComm));
+    }
+
+    // the receiver measured the copy, every rank gets the result so rank 0 can report it
+    double bandwidth = worldRank == dstRank ? bandwidthStat.returnAppropriateMetric() * 1e-9 : 0.0;
+    MPI_ASSERT(MPI_Bcast(&bandwidth, 1, MPI_DOUBLE, dstRank, MPI_COMM_WORLD));
+    return bandwidth;
+}
+
+#endif // MULTINODE
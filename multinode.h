@@ -0,0 +1,63 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MULTINODE_H
+#define MULTINODE_H
+
+#ifdef MULTINODE
+
+#include <mpi.h>
+
+#include "common.h"
+#include "memcpy.h"
+
+// Rank of this process and number of processes in MPI_COMM_WORLD
+extern int worldRank;
+extern int worldSize;
+// Device used by this rank, picked round robin across the ranks sharing the node
+extern int localDevice;
+// MPI accepts device pointers, otherwise copies are staged through pinned host buffers
+extern bool mpiDeviceAware;
+
+// Initializes MPI for the lifetime of the object. Only rank 0 writes to stdout.
+class MultinodeSession {
+public:
+    MultinodeSession(int &argc, char **&argv, bool forceStaged);
+    ~MultinodeSession();
+};
+
+// Rank to rank copies of a buffer on each rank's device, sent with MPI. The calls are collective over
+// MPI_COMM_WORLD: every rank calls them with the same arguments, and all ranks align their start with a barrier
+// the way the spin kernel latch aligns the streams of doMemcpy.
+class MultinodeMemcpyOperation {
+private:
+    unsigned long long loopCount;
+    bool bidirectional;
+
+    // Sends size bytes count times from srcRank to dstRank (and back when bidirectional), this rank's part only
+    void transfer(int srcRank, int dstRank, const MemcpyNode &sendNode, const MemcpyNode &recvNode,
+                  const MemcpyNode *sendStage, const MemcpyNode *recvStage, size_t size, unsigned long long count);
+public:
+    MultinodeMemcpyOperation(unsigned long long loopCount, bool bidirectional = false);
+
+    // Returns the srcRank -> dstRank bandwidth in GB/s on every rank, deviceNode is this rank's buffer
+    double doMemcpy(int srcRank, int dstRank, const MemcpyNode &deviceNode);
+};
+
+#endif // MULTINODE
+
+#endif
@@ -0,0 +1,161 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <hip/hip_runtime.h>
+#include <fstream>
+#include <map>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "common.h"
+#include "numa.h"
+
+// From linux/mempolicy.h
+#define NUMA_MPOL_DEFAULT 0
+#define NUMA_MPOL_BIND 2
+#define NUMA_MAX_NODES 1024
+#define NUMA_MASK_WORDS (NUMA_MAX_NODES / (8 * sizeof(unsigned long)))
+
+// Parses a sysfs list like "0-3,8-11"
+static std::vector<int> parseSysfsList(const std::string &list) {
+    std::vector<int> values;
+    std::stringstream s(list);
+    std::string range;
+    while (std::getline(s, range, ',')) {
+        if (range.empty()) {
+            continue;
+        }
+        size_t dash = range.find('-');
+        int first = std::stoi(range.substr(0, dash));
+        int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+        for (int value = first; value <= last; value++) {
+            values.push_back(value);
+        }
+    }
+    return values;
+}
+
+static std::string readSysfsLine(const std::string &path) {
+    std::ifstream file(path);
+    std::string line;
+    std::getline(file, line);
+    return line;
+}
+
+int getDeviceNumaNode(int deviceId) {
+    static std::map<int, int> deviceNodes;
+    auto it = deviceNodes.find(deviceId);
+    if (it != deviceNodes.end()) {
+        return it->second;
+    }
+
+    char busId[64];
+    int numaNode = -1;
+    CU_ASSERT(hipDeviceGetPCIBusId(busId, sizeof(busId), deviceId));
+    std::string path = std::string("/sys/bus/pci/devices/") + busId + "/numa_node";
+    for (char &c : path) {
+        c = tolower(c);
+    }
+
+    std::string line = readSysfsLine(path);
+    if (!line.empty()) {
+        numaNode = std::stoi(line);
+    }
+    deviceNodes[deviceId] = numaNode;
+    return numaNode;
+}
+
+const std::vector<int> &getNumaNodes() {
+    static std::vector<int> nodes = parseSysfsList(readSysfsLine("/sys/devices/system/node/online"));
+    return nodes;
+}
+
+static std::vector<unsigned long> nodeMask(int numaNode) {
+    std::vector<unsigned long> mask(NUMA_MASK_WORDS);
+    mask[numaNode / (8 * sizeof(unsigned long))] |= 1UL << (numaNode % (8 * sizeof(unsigned long)));
+    return mask;
+}
+
+std::vector<int> getNumaNodeCpus(int numaNode) {
+    return parseSysfsList(readSysfsLine("/sys/devices/system/node/node" + std::to_string(numaNode) + "/cpulist"));
+}
+
+// Affinity of the process before the first binding, restored by resetNumaBinding
+static bool savedAffinity = false;
+static cpu_set_t originalAffinity;
+
+bool bindToNumaNode(int numaNode) {
+    if (numaNode < 0 || numaNode >= NUMA_MAX_NODES) {
+        return false;
+    }
+
+    std::vector<int> cpus = getNumaNodeCpus(numaNode);
+    if (!savedAffinity) {
+        savedAffinity = sched_getaffinity(0, sizeof(originalAffinity), &originalAffinity) == 0;
+    }
+
+    // memory only nodes have no CPUs, the thread then stays where it is
+    if (!cpus.empty()) {
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        for (int cpu : cpus) {
+            CPU_SET(cpu, &cpuSet);
+        }
+        if (sched_setaffinity(0, sizeof(cpuSet), &cpuSet) != 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void setOptimalCpuAffinity(int deviceId) {
+    if (disableAffinity) {
+        return;
+    }
+    bindToNumaNode(getDeviceNumaNode(deviceId));
+}
+
+void resetNumaBinding() {
+    if (savedAffinity) {
+        sched_setaffinity(0, sizeof(originalAffinity), &originalAffinity);
+    }
+}
+
+NumaMemoryBinding::NumaMemoryBinding(int numaNode) : bound(false), previousMode(NUMA_MPOL_DEFAULT), previousMask(NUMA_MASK_WORDS) {
+    if (numaNode < 0 || numaNode >= NUMA_MAX_NODES ||
+        syscall(SYS_get_mempolicy, &previousMode, previousMask.data(), NUMA_MAX_NODES, nullptr, 0) != 0) {
+        return;
+    }
+    std::vector<unsigned long> mask = nodeMask(numaNode);
+    bound = syscall(SYS_set_mempolicy, NUMA_MPOL_BIND, mask.data(), NUMA_MAX_NODES) == 0;
+}
+
+NumaMemoryBinding::~NumaMemoryBinding() {
+    if (bound) {
+        syscall(SYS_set_mempolicy, previousMode, previousMode == NUMA_MPOL_DEFAULT ? nullptr : previousMask.data(), NUMA_MAX_NODES);
+    }
+}
+
+bool bindBufferToNumaNode(void *buffer, size_t size, int numaNode) {
+    if (numaNode < 0 || numaNode >= NUMA_MAX_NODES) {
+        return false;
+    }
+    std::vector<unsigned long> mask = nodeMask(numaNode);
+    return syscall(SYS_mbind, buffer, size, NUMA_MPOL_BIND, mask.data(), NUMA_MAX_NODES, 0) == 0;
+}
@@ -0,0 +1,64 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef NUMA_H
+#define NUMA_H
+
+#include <vector>
+
+// GPU to NUMA node discovery from sysfs, binding of the calling thread's CPUs to a NUMA node and placement of
+// host allocations on a NUMA node. The memory policy of the thread is only changed around the allocations
+// placed explicitly, so the runtime's own host allocations are never bound.
+
+// NUMA node of the device's PCI bus, -1 if the system doesn't report one
+int getDeviceNumaNode(int deviceId);
+// Online NUMA nodes in ascending order, empty if the system has no NUMA information
+const std::vector<int> &getNumaNodes();
+// CPUs of the NUMA node, empty for memory only nodes
+std::vector<int> getNumaNodeCpus(int numaNode);
+
+// Runs the calling thread on the node's CPUs, memory only nodes leave it where it is
+bool bindToNumaNode(int numaNode);
+// Runs the calling thread on the CPUs of the device's NUMA node, unless --disableAffinity is set
+void setOptimalCpuAffinity(int deviceId);
+// Restores the CPU affinity the process started with
+void resetNumaBinding();
+
+// Calls resetNumaBinding when it goes out of scope, also when a testcase throws
+class NumaBindingReset {
+public:
+    ~NumaBindingReset() { resetNumaBinding(); }
+};
+
+// Binds the allocations of the calling thread to the node's memory while it lives and restores the previous
+// memory policy afterwards, for allocators following the thread's policy like hipHostMallocNumaUser
+class NumaMemoryBinding {
+private:
+    bool bound;
+    int previousMode;
+    std::vector<unsigned long> previousMask;
+public:
+    explicit NumaMemoryBinding(int numaNode);
+    ~NumaMemoryBinding();
+
+    bool isBound() const { return bound; }
+};
+
+// Places the pages of a buffer that wasn't touched yet on the node's memory, whatever thread touches them first
+bool bindBufferToNumaNode(void *buffer, size_t size, int numaNode);
+
+#endif
@@ -18,24 +18,79 @@
 #include <boost/program_options.hpp>
 #include <hip/hip_runtime.h>
 #include <hip/hip_runtime_api.h>
-#include <nvml.h>
+#include <chrono>
+#include <csignal>
+#include <fstream>
 #include <iostream>
+#include <unistd.h>
 
+#include "counters.h"
+#include "hsa_backend.h"
 #include "kernels.h"
+#include "multinode.h"
+#include "numa.h"
+#include "output.h"
 #include "testcase.h"
+#include "topology.h"
 #include "version.h"
 
 namespace opt = boost::program_options;
 
 int deviceCount;
 unsigned int averageLoopCount;
+double targetPrecision;
+unsigned int maxSamples;
+double maxSampleTime;
 unsigned long long bufferSize;
 unsigned long long loopCount;
 bool verbose;
 bool disableAffinity;
 bool skipVerification;
 bool useMean;
+bool smAutotune;
+bool useGraphs;
+bool perIterationTiming;
+bool parallelEnqueue;
+unsigned int maxStreams;
+std::vector<unsigned long long> pipelineChunkSizes;
+std::vector<unsigned int> atomicContention = {1, 64, 4096};
+#ifdef ROCM_SMI
+bool sampleCounters;
+#endif
+HostMemType hostMemType;
+CeCopyPath ceCopyPath;
+CopyBackend copyBackend;
+int sdmaEngine;
+std::vector<BackgroundLoadType> backgroundLoads;
+std::vector<unsigned long long> sweepSizes;
 Verbosity VERBOSE;
+Output *output;
+
+// --fillFraction, and the free memory of the smallest device and of the host it splits among the buffers of a testcase
+static double fillFraction = 0.0;
+static size_t fillDeviceMemory = 0;
+static size_t fillHostMemory = 0;
+
+// Size of every buffer of the testcase, the fraction of the free memory shared by the buffers it holds at once with --fillFraction
+static unsigned long long testcaseBufferSize(const Testcase *test) {
+    if (!sweepSizes.empty()) {
+        return sweepSizes.back();
+    }
+    if (fillFraction <= 0.0) {
+        return bufferSize * _MiB;
+    }
+
+    double deviceMemory = fillDeviceMemory * fillFraction - test->reservedDeviceMemory();
+    unsigned long long size = deviceMemory > 0.0 ? (unsigned long long)(deviceMemory / test->deviceBuffers()) : 0;
+    if (test->hostBuffers() > 0) {
+        size = std::min(size, (unsigned long long)(fillHostMemory * fillFraction / test->hostBuffers()));
+    }
+    size -= size % _MiB;
+    if (size == 0) {
+        throw std::string("--fillFraction ") + std::to_string(fillFraction) + " leaves less than 1 MiB for each buffer of the testcase";
+    }
+    return size;
+}
 
 // Define testcases here
 std::vector<Testcase*> createTestcases() {
@@ -56,6 +111,13 @@ std::vector<Testcase*> createTestcases() {
         new AllToOneReadCE(),
         new OneToAllWriteCE(),
         new OneToAllReadCE(),
+        new AllToAllCE(),
+        new HostNumaToDeviceCE(),
+        new HostToDeviceStreamScalingCE(),
+        new DeviceToHostStreamScalingCE(),
+        new DeviceToDeviceStreamScalingCE(),
+        new HostToDevicePipelinedCE(),
+        new DeviceToHostPipelinedCE(),
         new HostToDeviceSM(),
         new DeviceToHostSM(),
         new DeviceToDeviceReadSM(),
@@ -69,7 +131,27 @@ std::vector<Testcase*> createTestcases() {
         new AllToOneWriteSM(),
         new AllToOneReadSM(),
         new OneToAllWriteSM(),
-        new OneToAllReadSM()
+        new OneToAllReadSM(),
+        new AllToAllSM(),
+        new DeviceLocalMemorySM(),
+        new HostDeviceReadWriteSM(),
+        new DeviceToDeviceReadWriteSM(),
+        new HostDeviceAccessSweepSM(),
+        new DeviceToDeviceAccessSweepSM(),
+        new HostDeviceLatencySM(),
+        new DeviceToDeviceLatencySM(),
+        new HostDeviceLatencyCE(),
+        new HostDeviceAtomicSM(),
+        new DeviceToDeviceAtomicSM(),
+        new HostToDeviceUnderLoadCE(),
+        new HostToDeviceUnderLoadSM(),
+        new HostToDevicePrefetchManaged(),
+        new DeviceToDevicePrefetchManaged(),
+        new HostToDeviceFaultManagedSM(),
+#ifdef MULTINODE
+        new MultinodeDeviceToDevice(),
+        new MultinodeDeviceToDeviceBidir(),
+#endif
     };
 }
 
@@ -92,46 +174,184 @@ Testcase* findTestcase(std::vector<Testcase*> &testcases, std::string id) {
     }
 }
 
-void runTestcase(std::vector<Testcase*> &testcases, const std::string &testcaseID) {
-    hipCtx_t testCtx;
+// Parses a size with an optional binary K/M/G/T suffix, plain numbers are bytes
+static bool parseSize(const std::string &str, unsigned long long &size) {
+    char* end;
+    size = strtoull(str.c_str(), &end, 10);
+    if (end == str.c_str()) {
+        return false;
+    }
+    switch (toupper(*end)) {
+        case '\0': return true;
+        case 'T': size *= 1024ull; [[fallthrough]];
+        case 'G': size *= 1024ull; [[fallthrough]];
+        case 'M': size *= 1024ull; [[fallthrough]];
+        case 'K': size *= 1024ull; break;
+        default: return false;
+    }
+    return *(end + 1) == '\0';
+}
+
+// Parses a non negative percentage like "5%" or "5" into a fraction
+static bool parsePercentage(const std::string &str, double &fraction) {
+    char* end;
+    fraction = strtod(str.c_str(), &end) / 100.0;
+    // strtod also parses nan and inf, which no comparison against a tolerance or precision would catch
+    if (end == str.c_str() || !std::isfinite(fraction) || fraction < 0.0) {
+        return false;
+    }
+    return *end == '\0' || (*end == '%' && *(end + 1) == '\0');
+}
+
+// Expands a "start:end:step" sweep specification, where step is either a size to add ("+4M" or "4M")
+// or a multiplication factor ("x2"), into the list of sizes to measure
+static bool parseSweep(const std::string &spec, std::vector<unsigned long long> &sizes) {
+    size_t first = spec.find(':');
+    size_t second = spec.find(':', first + 1);
+    if (first == std::string::npos || second == std::string::npos) {
+        return false;
+    }
+
+    unsigned long long start, end, step;
+    std::string stepStr = spec.substr(second + 1);
+    bool multiply = !stepStr.empty() && tolower(stepStr[0]) == 'x';
+    if (!stepStr.empty() && (multiply || stepStr[0] == '+')) {
+        stepStr = stepStr.substr(1);
+    }
+    if (!parseSize(spec.substr(0, first), start) || !parseSize(spec.substr(first + 1, second - first - 1), end) || !parseSize(stepStr, step)) {
+        return false;
+    }
+    // copy kernels move at least one uint4 per thread
+    if (start < sizeof(uint4) || end < start || (multiply ? step < 2 : step == 0)) {
+        return false;
+    }
+
+    for (unsigned long long size = start; size <= end; size = multiply ? size * step : size + step) {
+        sizes.push_back(size);
+        if (multiply ? size > ULLONG_MAX / step : size > ULLONG_MAX - step) {
+            break;
+        }
+    }
+    return true;
+}
+
+// Testcases of a --daemon pass when none are given, cheap enough to run often and covering host and peer links
+static const std::vector<std::string> defaultDaemonTestcases = {
+    "host_to_device_memcpy_ce",
+    "device_to_host_memcpy_ce",
+    "device_to_device_memcpy_read_ce",
+};
+
+static volatile std::sig_atomic_t stopDaemon = 0;
+
+static void handleStopSignal(int) {
+    stopDaemon = 1;
+}
+
+// Runs the testcase in a fresh context, or in daemonCtx when given so passes of a daemon don't recreate it
+void runTestcase(std::vector<Testcase*> &testcases, const std::string &testcaseID, hipCtx_t daemonCtx = nullptr) {
+    hipCtx_t testCtx = daemonCtx;
 
     try {
         Testcase* test = findTestcase(testcases, testcaseID);
+        output->beginTestcase(test->testKey());
         if (!test->filter()) {
             std::cout << "Waiving " << test->testKey() << "." << std::endl << std::endl;
+            output->waiveTestcase();
             return;
         }
         std::cout << "Running " << test->testKey() << ".\n";
+        unsigned long long size = testcaseBufferSize(test);
+        if (fillFraction > 0.0) {
+            std::cout << "Buffer size: " << size / _MiB << " MiB" << std::endl;
+        }
 
-        CU_ASSERT(hipCtxCreate(&testCtx, 0, 0));
+        if (daemonCtx == nullptr) {
+            CU_ASSERT(hipCtxCreate(&testCtx, 0, 0));
+        }
         CU_ASSERT(hipCtxSetCurrent(testCtx));
-        // Run the testcase
-        test->run(bufferSize * _MiB, loopCount);
-        CU_ASSERT(hipCtxDestroy(testCtx));
+        // Run the testcase, a sweep allocates for its largest size and copies sub-ranges of the buffers
+        test->run(size, loopCount);
+        output->endTestcase();
+        if (daemonCtx == nullptr) {
+            CU_ASSERT(hipCtxDestroy(testCtx));
+        }
     } catch (std::string &s) {
         std::cout << "ERROR: " << s << std::endl;
+        output->errorTestcase(s);
     }
 }
 
 int main(int argc, char **argv) {
-    std::cout << "nvbandwidth Version: " << NVBANDWIDTH_VERSION << std::endl;
-    std::cout << "Built from Git version: " << GIT_VERSION << std::endl << std::endl;
-    
     std::vector<Testcase*> testcases = createTestcases();
     std::vector<std::string> testcasesToRun;
+    std::string sweep;
+    bool showTopology = false;
+    std::string outputFormat;
+    std::string outputFile;
+    std::string hostMemTypeName;
+    std::string ceCopyPathName;
+    std::string copyBackendName;
+    std::string saveBaselineFile;
+    std::string compareBaselineFile;
+    std::string toleranceName;
+    std::string targetPrecisionName;
+    std::vector<int> selectedDevices;
+    bool daemon = false;
+    unsigned int daemonInterval;
+    std::vector<std::string> pipelineChunkSizeNames = {"256K", "1M", "4M", "16M"};
+    std::vector<std::string> backgroundLoadTypeNames = backgroundLoadNames;
+    int metricsPort;
+#ifdef MULTINODE
+    bool mpiStaged = false;
+#endif
 
     // Args parsing
     opt::options_description visible_opts("nvbandwidth CLI");
     visible_opts.add_options()
         ("help,h", "Produce help message")
         ("bufferSize,b", opt::value<unsigned long long int>(&bufferSize)->default_value(defaultBufferSize), "Memcpy buffer size in MiB")
+        ("sweep", opt::value<std::string>(&sweep), "Sweep buffer sizes as start:end:step, e.g. 4K:4G:x2 (overrides bufferSize)")
+        ("fillFraction", opt::value<double>(&fillFraction), "Size the buffers of every testcase to share this fraction of the smallest free device memory, e.g. 0.8 (overrides bufferSize)")
         ("list,l", "List available testcases")
         ("testcase,t", opt::value<std::vector<std::string>>(&testcasesToRun)->multitoken(), "Testcase(s) to run (by name or index)")
+        ("devices", opt::value<std::vector<int>>(&selectedDevices)->multitoken(), "Devices to test, e.g. 2 5, numbered from 0 in the results")
         ("verbose,v", opt::bool_switch(&verbose)->default_value(false), "Verbose output")
         ("skipVerification,s", opt::bool_switch(&skipVerification)->default_value(false), "Skips data verification after copy")
         ("disableAffinity,d", opt::bool_switch(&disableAffinity)->default_value(false), "Disable automatic CPU affinity control")
         ("testSamples,i", opt::value<unsigned int>(&averageLoopCount)->default_value(defaultAverageLoopCount), "Iterations of the benchmark")
-        ("useMean,m", opt::bool_switch(&useMean)->default_value(false), "Use mean instead of median for results");
+        ("targetPrecision", opt::value<std::string>(&targetPrecisionName), "Sample each measurement until its 95% confidence interval is within this percentage, e.g. 1% (overrides testSamples)")
+        ("maxSamples", opt::value<unsigned int>(&maxSamples)->default_value(defaultMaxSamples), "Most samples of one measurement with --targetPrecision")
+        ("maxSampleTime", opt::value<double>(&maxSampleTime)->default_value(defaultMaxSampleTime), "Most seconds spent sampling one measurement with --targetPrecision")
+        ("useMean,m", opt::bool_switch(&useMean)->default_value(false), "Use mean instead of median for results")
+        ("smAutotune", opt::bool_switch(&smAutotune)->default_value(false), "Autotune the SM copy kernel per device, link type and copy size")
+        ("useGraphs", opt::bool_switch(&useGraphs)->default_value(false), "Capture the copies of each sample into a graph and replay it with hipGraphLaunch")
+        ("maxStreams", opt::value<unsigned int>(&maxStreams)->default_value(defaultMaxStreams), "Largest number of concurrent streams per device of the stream scaling testcases")
+        ("pipelineChunkSizes", opt::value<std::vector<std::string>>(&pipelineChunkSizeNames)->multitoken(), "Chunk sizes of the pipelined testcases, e.g. 256K 1M (default 256K 1M 4M 16M)")
+        ("atomicContention", opt::value<std::vector<unsigned int>>(&atomicContention)->multitoken(), "Threads sharing each word in the atomic testcases, e.g. 1 64 (default 1 64 4096)")
+        ("backgroundLoad", opt::value<std::vector<std::string>>(&backgroundLoadTypeNames)->multitoken(), "Background kernels of the interference testcases: hbm, alu or occupancy (default all)")
+        ("parallelEnqueue", opt::bool_switch(&parallelEnqueue)->default_value(false), "Enqueue the simultaneous copies of each device from a dedicated thread pinned near it")
+        ("perIterationTiming", opt::bool_switch(&perIterationTiming)->default_value(false), "Time every copy of a sample and report the copy time percentiles")
+        ("hostMemType", opt::value<std::string>(&hostMemTypeName)->default_value("pinned"), "Host memory of host testcases: pinned, registered, pageable, coherent, noncoherent, managed or hsa")
+        ("ceCopyPath", opt::value<std::string>(&ceCopyPathName)->default_value("default"), "Copy path of CE testcases: default, sdma or blit")
+        ("backend", opt::value<std::string>(&copyBackendName)->default_value("hip"), "Runtime issuing the CE testcase copies: hip or hsa")
+        ("sdmaEngine", opt::value<int>(&sdmaEngine)->default_value(-1), "SDMA engine of the hsa backend copies, -1 lets the runtime pick")
+        ("output", opt::value<std::string>(&outputFormat), "Structured results format: json or csv")
+        ("outputFile", opt::value<std::string>(&outputFile)->default_value("-"), "File for structured results, - writes them to stdout and the log to stderr")
+        ("saveBaseline", opt::value<std::string>(&saveBaselineFile), "Save every testcase result to a baseline file")
+        ("compareBaseline", opt::value<std::string>(&compareBaselineFile), "Compare the results against a baseline file, exit with status 2 if any regressed")
+        ("tolerance", opt::value<std::string>(&toleranceName)->default_value("5%"), "Change from the baseline tolerated before a result regresses, in percent")
+        ("daemon", opt::bool_switch(&daemon)->default_value(false), "Rerun the testcases periodically and serve the latest results as OpenMetrics")
+        ("daemonInterval", opt::value<unsigned int>(&daemonInterval)->default_value(300), "Seconds between the starts of two daemon passes")
+        ("metricsPort", opt::value<int>(&metricsPort)->default_value(9489), "Local port serving the daemon metrics")
+        ("topology", opt::bool_switch(&showTopology)->default_value(false), "Print the link types, hop counts and peak bandwidths between the host and devices, and the link efficiency of every testcase")
+#ifdef MULTINODE
+        ("mpiStaged", opt::bool_switch(&mpiStaged)->default_value(false), "Stage multinode copies through host memory even if MPI is ROCm aware")
+#endif
+#ifdef ROCM_SMI
+        ("counters", opt::bool_switch(&sampleCounters)->default_value(false), "Sample the link, memory, clock and power counters of the devices during every copy sample")
+#endif
+        ;
 
     opt::options_description all_opts("");
     all_opts.add(visible_opts);
@@ -157,6 +377,168 @@ int main(int argc, char **argv) {
         return 0;
     }
 
+    auto copyPath = std::find(ceCopyPathNames.begin(), ceCopyPathNames.end(), ceCopyPathName);
+    if (copyPath == ceCopyPathNames.end()) {
+        std::cout << "ERROR: Invalid CE copy path " << ceCopyPathName << ", expected default, sdma or blit" << std::endl;
+        return 1;
+    }
+    ceCopyPath = (CeCopyPath)std::distance(ceCopyPathNames.begin(), copyPath);
+    if (ceCopyPath == CE_PATH_BLIT) {
+        // only read when the runtime initializes, which MPI may already do in MPI_Init
+        setenv("HSA_ENABLE_SDMA", "0", 1);
+    }
+
+    // Only the selected devices are initialized by the runtime, and every testcase sees them as devices 0 to n - 1.
+    // A HIP_VISIBLE_DEVICES set by the caller is narrowed further, indices then refer to its list.
+    std::vector<std::string> selectedDeviceIds;
+    if (!selectedDevices.empty()) {
+        std::vector<std::string> visibleIds;
+        const char *visible = getenv("HIP_VISIBLE_DEVICES");
+        std::stringstream visibleList(visible ? visible : "");
+        std::string id;
+        while (std::getline(visibleList, id, ',')) {
+            visibleIds.push_back(id);
+        }
+
+        std::string selection;
+        for (int device : selectedDevices) {
+            bool duplicate = std::count(selectedDevices.begin(), selectedDevices.end(), device) > 1;
+            if (device < 0 || duplicate || (visible && device >= visibleIds.size())) {
+                std::cout << "ERROR: Invalid device " << device << " in --devices" << std::endl;
+                return 1;
+            }
+            selectedDeviceIds.push_back(visible ? visibleIds[device] : std::to_string(device));
+            selection += (selection.empty() ? "" : ",") + selectedDeviceIds.back();
+        }
+        setenv("HIP_VISIBLE_DEVICES", selection.c_str(), 1);
+    }
+
+#ifdef MULTINODE
+    // lives until main returns, only rank 0 reports results
+    MultinodeSession multinodeSession(argc, argv, mpiStaged);
+#endif
+
+    Output::Format format = Output::NONE;
+    if (outputFormat == "json") {
+        format = Output::JSON;
+    } else if (outputFormat == "csv") {
+        format = Output::CSV;
+    } else if (!outputFormat.empty()) {
+        std::cout << "ERROR: Invalid output format " << outputFormat << ", expected json or csv" << std::endl;
+        return 1;
+    }
+#ifdef MULTINODE
+    if (worldRank != 0) {
+        format = Output::NONE;
+    }
+    if (daemon && worldSize > 1) {
+        std::cout << "ERROR: --daemon runs on a single rank" << std::endl;
+        return 1;
+    }
+#endif
+    if (daemon && format != Output::NONE) {
+        std::cout << "ERROR: --daemon publishes its results as metrics, --output can't be used with it" << std::endl;
+        return 1;
+    }
+    try {
+        output = new Output(format, outputFile);
+    } catch (std::string &s) {
+        std::cout << "ERROR: " << s << std::endl;
+        return 1;
+    }
+
+    bool useBaseline = !saveBaselineFile.empty() || !compareBaselineFile.empty();
+#ifdef MULTINODE
+    // every rank measures the same links in the multinode testcases, rank 0 reports them
+    useBaseline = useBaseline && worldRank == 0;
+#endif
+    double tolerance = 0.0;
+    if (useBaseline) {
+        if (daemon) {
+            std::cout << "ERROR: --saveBaseline and --compareBaseline can't be used with --daemon" << std::endl;
+            return 1;
+        }
+        if (!parsePercentage(toleranceName, tolerance)) {
+            std::cout << "ERROR: Invalid tolerance " << toleranceName << ", expected a percentage like 5%" << std::endl;
+            return 1;
+        }
+        output->retainResults();
+    }
+
+    if (showTopology) {
+        if (daemon) {
+            std::cout << "ERROR: --topology can't be used with --daemon" << std::endl;
+            return 1;
+        }
+        output->summarizeLinks();
+    }
+
+    if (vm.count("targetPrecision") && (!parsePercentage(targetPrecisionName, targetPrecision) || targetPrecision == 0.0)) {
+        std::cout << "ERROR: Invalid target precision " << targetPrecisionName << ", expected a percentage like 1%" << std::endl;
+        return 1;
+    }
+
+    std::cout << "nvbandwidth Version: " << NVBANDWIDTH_VERSION << std::endl;
+    std::cout << "Built from Git version: " << GIT_VERSION << std::endl << std::endl;
+
+    auto backend = std::find(copyBackendNames.begin(), copyBackendNames.end(), copyBackendName);
+    if (backend == copyBackendNames.end()) {
+        std::cout << "ERROR: Invalid backend " << copyBackendName << ", expected hip or hsa" << std::endl;
+        return 1;
+    }
+    copyBackend = (CopyBackend)std::distance(copyBackendNames.begin(), backend);
+    if (sdmaEngine >= 32 || (sdmaEngine >= 0 && copyBackend != BACKEND_HSA)) {
+        std::cout << "ERROR: --sdmaEngine takes an engine index below 32 and requires --backend hsa" << std::endl;
+        return 1;
+    }
+    // the HSA backend copies to its own system memory pool allocations unless told otherwise
+    if (copyBackend == BACKEND_HSA && vm["hostMemType"].defaulted()) {
+        hostMemTypeName = "hsa";
+    }
+
+    auto memType = std::find(hostMemTypeNames.begin(), hostMemTypeNames.end(), hostMemTypeName);
+    if (memType == hostMemTypeNames.end()) {
+        std::cout << "ERROR: Invalid host memory type " << hostMemTypeName << ", expected pinned, registered, pageable, coherent, noncoherent, managed or hsa" << std::endl;
+        return 1;
+    }
+    hostMemType = (HostMemType)std::distance(hostMemTypeNames.begin(), memType);
+
+    for (const std::string &name : pipelineChunkSizeNames) {
+        unsigned long long chunkSize;
+        if (!parseSize(name, chunkSize) || chunkSize == 0) {
+            std::cout << "ERROR: Invalid pipeline chunk size " << name << std::endl;
+            return 1;
+        }
+        pipelineChunkSizes.push_back(chunkSize);
+    }
+    std::sort(pipelineChunkSizes.begin(), pipelineChunkSizes.end());
+    if (std::find(atomicContention.begin(), atomicContention.end(), 0) != atomicContention.end()) {
+        std::cout << "ERROR: --atomicContention levels must be at least 1" << std::endl;
+        return 1;
+    }
+    for (const std::string &name : backgroundLoadTypeNames) {
+        auto load = std::find(backgroundLoadNames.begin(), backgroundLoadNames.end(), name);
+        if (load == backgroundLoadNames.end()) {
+            std::cout << "ERROR: Invalid background load " << name << ", expected hbm, alu or occupancy" << std::endl;
+            return 1;
+        }
+        backgroundLoads.push_back((BackgroundLoadType)std::distance(backgroundLoadNames.begin(), load));
+    }
+
+    if (maxStreams == 0) {
+        std::cout << "ERROR: --maxStreams must be at least 1" << std::endl;
+        return 1;
+    }
+
+    if (vm.count("sweep") && !parseSweep(sweep, sweepSizes)) {
+        std::cout << "ERROR: Invalid sweep " << sweep << ", expected start:end:step (e.g. 4K:4G:x2)" << std::endl;
+        return 1;
+    }
+    if (vm.count("fillFraction") && (fillFraction <= 0.0 || fillFraction > 1.0 || vm.count("sweep"))) {
+        std::cout << "ERROR: --fillFraction takes a fraction above 0 and up to 1 and can't be used with --sweep" << std::endl;
+        return 1;
+    }
+
     if (vm.count("list")) {
         size_t numTestcases = testcases.size();
         std::cout << "Index, Name:\n\tDescription\n";
@@ -171,9 +553,35 @@ int main(int argc, char **argv) {
               << "Additional system-specific tuning may be required to achieve maximal peak bandwidth." << std::endl << std::endl;
 
     hipInit(0);
-    nvmlInit();
     CU_ASSERT(hipGetDeviceCount(&deviceCount));
-    if (bufferSize < defaultBufferSize) {
+    if (!selectedDevices.empty() && deviceCount != selectedDevices.size()) {
+        std::cout << "ERROR: Only " << deviceCount << " of the " << selectedDevices.size() << " devices in --devices exist" << std::endl;
+        return 1;
+    }
+#ifdef ROCM_SMI
+    // devices are matched after the visible devices are known
+    sampleCounters = sampleCounters && initCounters();
+#endif
+    if (fillFraction > 0.0) {
+        // measured before any buffer is allocated, the buffers each testcase holds at once share the fraction
+        fillDeviceMemory = SIZE_MAX;
+        for (int deviceId = 0; deviceId < deviceCount; deviceId++) {
+            size_t freeMemory, totalMemory;
+            CU_ASSERT(hipSetDevice(deviceId));
+            CU_ASSERT(hipMemGetInfo(&freeMemory, &totalMemory));
+            fillDeviceMemory = std::min(fillDeviceMemory, freeMemory);
+        }
+        fillHostMemory = (size_t)sysconf(_SC_AVPHYS_PAGES) * sysconf(_SC_PAGESIZE);
+        // the size of a single buffer, recorded in baselines
+        bufferSize = (unsigned long long)(fillDeviceMemory * fillFraction) / _MiB;
+        if (bufferSize == 0) {
+            std::cout << "ERROR: --fillFraction " << fillFraction << " of " << fillDeviceMemory << " free bytes is less than 1 MiB" << std::endl;
+            return 1;
+        }
+        std::cout << "Buffers: " << fillFraction << " of the smallest free device memory (" << fillDeviceMemory / _MiB << " MiB) and of the free host memory ("
+                  << fillHostMemory / _MiB << " MiB), split among the buffers of each testcase" << std::endl << std::endl;
+    }
+    if (sweepSizes.empty() && bufferSize < defaultBufferSize) {
         std::cout << "NOTE: You have chosen a buffer size that is smaller than the default buffer size. " << std::endl
         << "It is suggested to use the default buffer size (64MB) to achieve maximal peak bandwidth." << std::endl << std::endl;
     }
@@ -185,9 +593,10 @@ int main(int argc, char **argv) {
     CU_ASSERT(hipDriverGetVersion(&cudaVersion));
     std::cout << "CUDA Driver Version: " << cudaVersion << std::endl;
 
-    char driverVersion[NVML_SYSTEM_DRIVER_VERSION_BUFFER_SIZE];
-    NVML_ASSERT(nvmlSystemGetDriverVersion(driverVersion, NVML_SYSTEM_DRIVER_VERSION_BUFFER_SIZE));
-    std::cout << "Driver Version: " << driverVersion << std::endl << std::endl;
+    // only reported by the out of tree amdgpu module
+    std::string driverVersion;
+    std::getline(std::ifstream("/sys/module/amdgpu/version"), driverVersion);
+    std::cout << "Driver Version: " << (driverVersion.empty() ? "N/A" : driverVersion) << std::endl << std::endl;
 
     for (int iDev = 0; iDev < deviceCount; iDev++) {
         hipDevice_t dev;
@@ -196,18 +605,84 @@ int main(int argc, char **argv) {
         CU_ASSERT(hipDeviceGet(&dev, iDev));
         CU_ASSERT(hipDeviceGetName(name, 256, dev));
 
-        std::cout << "Device " << iDev << ": " << name << std::endl;
+        std::cout << "Device " << iDev << ": " << name;
+        if (!selectedDeviceIds.empty()) {
+            std::cout << " (system device " << selectedDeviceIds[iDev] << ")";
+        }
+        int numaNode = getDeviceNumaNode(iDev);
+        if (numaNode >= 0) {
+            std::cout << " (NUMA node " << numaNode << ")";
+        }
+        std::cout << std::endl;
     }
+    std::cout << "Host memory: " << hostMemTypeNames[hostMemType] << std::endl;
+    std::cout << "CE copy path: " << ceCopyPathNames[ceCopyPath] << std::endl;
+    std::cout << "Copy backend: " << copyBackendNames[copyBackend];
+    if (sdmaEngine >= 0) {
+        std::cout << " (SDMA engine " << sdmaEngine << ")";
+    }
+    std::cout << std::endl;
     std::cout << std::endl;
 
-    // This triggers the loading of all kernels on all devices, even with lazy loading enabled.
-    // Some tests can create complex dependencies between devices and function loading requires a
-    // device synchronization, so loading in the middle of a test can deadlock.
+    if (showTopology) {
+        printTopology();
+    }
+
+#ifdef MULTINODE
+    std::cout << "MPI ranks: " << worldSize << ", " << (mpiDeviceAware ? "ROCm aware MPI" : "copies staged through host memory") << std::endl << std::endl;
+#endif
+
+    // Loads all kernels on the devices selected with --devices, in parallel, before the first testcase.
+    // Loading isn't deferred to the first use of a device: some tests create complex dependencies between
+    // devices and function loading requires a device synchronization, so loading in the middle of a test
+    // can deadlock. Every testcase measures all the selected devices, so --devices is what limits the loading.
     preloadKernels(deviceCount);
 
-    if (testcasesToRun.size() == 0) {
+    if (daemon) {
+        if (testcasesToRun.empty()) {
+            testcasesToRun = defaultDaemonTestcases;
+        }
+        try {
+            for (const auto& testcaseIndex : testcasesToRun) {
+                findTestcase(testcases, testcaseIndex);
+            }
+            output->setMetricsServer(new MetricsServer(metricsPort));
+        } catch (std::string &s) {
+            std::cout << "ERROR: " << s << std::endl;
+            return 1;
+        }
+        std::cout << "Serving metrics on 127.0.0.1:" << metricsPort << ", a pass every " << daemonInterval << " seconds" << std::endl << std::endl;
+
+        // contexts, pooled buffers, captured graphs and tuned kernels stay resident between passes
+        hipCtx_t daemonCtx;
+        CU_ASSERT(hipCtxCreate(&daemonCtx, 0, 0));
+        std::signal(SIGINT, handleStopSignal);
+        std::signal(SIGTERM, handleStopSignal);
+        while (!stopDaemon) {
+            auto start = std::chrono::steady_clock::now();
+            for (const auto& testcaseIndex : testcasesToRun) {
+                runTestcase(testcases, testcaseIndex, daemonCtx);
+            }
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            output->getMetricsServer()->finishIteration(elapsed.count());
+
+            auto next = start + std::chrono::seconds(daemonInterval);
+            while (!stopDaemon && std::chrono::steady_clock::now() < next) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+        }
+        CU_ASSERT(hipCtxDestroy(daemonCtx));
+        delete output->getMetricsServer();
+        output->setMetricsServer(nullptr);
+    } else if (testcasesToRun.size() == 0) {
         // run all testcases
         for (auto testcase : testcases) {
+#ifdef MULTINODE
+            // ranks would share devices in the single node testcases
+            if (worldSize > 1 && !testcase->isMultinode()) {
+                continue;
+            }
+#endif
             runTestcase(testcases, testcase->testKey());
         }
     } else {
@@ -216,7 +691,34 @@ int main(int argc, char **argv) {
         }
     }
 
+    output->print();
+
+    size_t regressions = 0;
+    if (useBaseline) {
+        unsigned long long measuredSize = sweepSizes.empty() ? bufferSize * _MiB : sweepSizes.back();
+        try {
+            if (!saveBaselineFile.empty()) {
+                output->saveBaseline(saveBaselineFile, measuredSize);
+            }
+            if (!compareBaselineFile.empty()) {
+                regressions = output->compareBaseline(compareBaselineFile, measuredSize, tolerance);
+            }
+        } catch (std::string &s) {
+            std::cout << "ERROR: " << s << std::endl;
+            return 1;
+        }
+    }
+    delete output;
+
     for (auto testcase : testcases) { delete testcase; }
+    MemcpyOperation::freeArenas();
+    MemcpyNode::freePatternResources();
+    BufferPool::clear();
+    hsaShutdown();
+#ifdef ROCM_SMI
+    shutdownCounters();
+#endif
 
-    return 0;
+    // distinct from the status of other errors, so a burn-in gate can tell a slow node from a failed run
+    return regressions > 0 ? 2 : 0;
 }
@@ -0,0 +1,582 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <hip/hip_runtime.h>
+#include <climits>
+#include <cmath>
+#include <map>
+#include <sstream>
+
+#include "output.h"
+#include "topology.h"
+#include "version.h"
+
+static std::string jsonString(const std::string &str) {
+    std::stringstream s;
+    s << '"';
+    for (char c : str) {
+        switch (c) {
+            case '"': s << "\\\""; break;
+            case '\\': s << "\\\\"; break;
+            case '\n': s << "\\n"; break;
+            case '\t': s << "\\t"; break;
+            default: s << c;
+        }
+    }
+    s << '"';
+    return s.str();
+}
+
+// CSV fields are quoted when they could break the row
+static std::string csvString(const std::string &str) {
+    if (str.find_first_of(",\"\n") == std::string::npos) {
+        return str;
+    }
+    std::string quoted = "\"";
+    for (char c : str) {
+        if (c == '"') quoted += '"';
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+static std::string hostName() {
+    static std::string name;
+    if (name.empty()) {
+        std::ifstream cpuinfo("/proc/cpuinfo");
+        std::string line;
+        name = "Host";
+        while (std::getline(cpuinfo, line)) {
+            if (line.rfind("model name", 0) == 0 && line.find(':') != std::string::npos) {
+                name = line.substr(line.find(':') + 2);
+                break;
+            }
+        }
+    }
+    return name;
+}
+
+static std::string deviceName(int deviceIdx) {
+    static std::map<int, std::string> names;
+    auto it = names.find(deviceIdx);
+    if (it != names.end()) {
+        return it->second;
+    }
+
+    hipDevice_t dev;
+    char name[256];
+    CU_ASSERT(hipDeviceGet(&dev, deviceIdx));
+    CU_ASSERT(hipDeviceGetName(name, 256, dev));
+    names[deviceIdx] = name;
+    return names[deviceIdx];
+}
+
+Output::Output(Format format, const std::string &outputFile) : format(format), structuredStream(nullptr), metrics(nullptr) {
+    if (format == NONE) {
+        return;
+    }
+
+    if (outputFile == "-") {
+        // keep stdout for the structured results only
+        structuredStream = new std::ostream(std::cout.rdbuf());
+        std::cout.rdbuf(std::cerr.rdbuf());
+    } else {
+        this->outputFile.open(outputFile);
+        if (!this->outputFile) {
+            throw "Can't open output file " + outputFile;
+        }
+        structuredStream = new std::ostream(this->outputFile.rdbuf());
+    }
+}
+
+Output::~Output() {
+    delete structuredStream;
+}
+
+void Output::beginTestcase(const std::string &key) {
+    if (metrics) {
+        metrics->beginTestcase(key);
+    }
+    currentKey = key;
+    // nothing is kept without a structured format, so a daemon doesn't grow with every pass
+    if (keepsResults()) {
+        testcases.push_back({key, "Passed"});
+    }
+}
+
+void Output::waiveTestcase() {
+    if (metrics) {
+        metrics->setStatus(currentKey, "Waived");
+    }
+    if (!testcases.empty()) {
+        testcases.back().status = "Waived";
+    }
+}
+
+void Output::errorTestcase(const std::string &error) {
+    if (metrics) {
+        metrics->setStatus(currentKey, "Error");
+    }
+    if (!testcases.empty()) {
+        testcases.back().status = "Error";
+        testcases.back().error = error;
+    }
+}
+
+void Output::endTestcase() {
+    if (!linkSummary || testcases.empty() || testcases.back().key != currentKey) {
+        return;
+    }
+
+    std::map<std::string, std::vector<const Measurement *>> classes;
+    for (const Measurement &measurement : testcases.back().measurements) {
+        if (measurement.efficiency < 0.0) {
+            continue;
+        }
+        classes[measurement.linkClass].push_back(&measurement);
+    }
+    if (classes.empty()) {
+        return;
+    }
+
+    std::cout << "Link efficiency (median GB/s against the link peak):" << std::endl;
+    for (auto &linkClass : classes) {
+        std::vector<double> bandwidths, efficiencies;
+        for (const Measurement *measurement : linkClass.second) {
+            bandwidths.push_back(measurement->median);
+            efficiencies.push_back(measurement->efficiency);
+        }
+        std::sort(bandwidths.begin(), bandwidths.end());
+        std::sort(efficiencies.begin(), efficiencies.end());
+        std::cout << "\t" << linkClass.first << ": " << linkClass.second.size() << " cells, " << std::fixed << std::setprecision(2)
+                  << bandwidths[bandwidths.size() / 2] << " GB/s, efficiency " << efficiencies[efficiencies.size() / 2] * 100
+                  << "% (" << efficiencies.front() * 100 << "% - " << efficiencies.back() * 100 << "%)" << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+void Output::recordMeasurement(const MemcpyNode &src, const MemcpyNode &dst, size_t copies, unsigned long long bufferSize,
+                               const PerformanceStatistic &stat, double scale, const std::string &unit) {
+    if (targetPrecision > 0.0) {
+        std::cout << "\t" << src.getNodeString() << " -> " << dst.getNodeString() << ": " << std::fixed << std::setprecision(2)
+                  << stat.returnAppropriateMetric() * scale << " " << unit << " +/- " << stat.relativeCiHalfWidth() * 100 << "% after "
+                  << stat.count() << " samples" << std::endl;
+    }
+    if (!keepsResults() || testcases.empty()) {
+        return;
+    }
+
+    Measurement measurement;
+    measurement.src = src.getNodeString();
+    measurement.dst = dst.getNodeString();
+    measurement.srcName = src.getPrimaryCtx() == nullptr ? hostName() : deviceName(src.getNodeIdx());
+    measurement.dstName = dst.getPrimaryCtx() == nullptr ? hostName() : deviceName(dst.getNodeIdx());
+    // host nodes have no context, their links are recorded as "host" without a hop count
+    bool hostLink = src.getPrimaryCtx() == nullptr || dst.getPrimaryCtx() == nullptr;
+    const LinkDescription &link = getLink(src.getPrimaryCtx() == nullptr ? TOPOLOGY_HOST : src.getNodeIdx(),
+                                          dst.getPrimaryCtx() == nullptr ? TOPOLOGY_HOST : dst.getNodeIdx());
+    measurement.link = hostLink ? "host" : link.type;
+    measurement.hops = hostLink ? -1 : link.hops;
+    if (unit == "GB/s" && copies == 1) {
+        measurement.peakBandwidth = link.peakBandwidth * 1e-9;
+        if (link.peakBandwidth > 0.0) {
+            measurement.efficiency = stat.median() / link.peakBandwidth;
+        }
+        measurement.linkClass = hostLink ? "host " + link.type : link.type;
+        if (measurement.hops > 0) {
+            measurement.linkClass += " " + std::to_string(measurement.hops) + " hop" + (measurement.hops > 1 ? "s" : "");
+        }
+    }
+    measurement.bufferSize = bufferSize;
+    measurement.copies = copies;
+    measurement.unit = unit;
+    measurement.samples = stat.count();
+    measurement.median = stat.median() * scale;
+    measurement.mean = stat.mean() * scale;
+    measurement.stddev = stat.stddev() * scale;
+    measurement.min = stat.smallest() * scale;
+    measurement.max = stat.largest() * scale;
+    measurement.ci95Relative = stat.relativeCiHalfWidth();
+
+    testcases.back().measurements.push_back(measurement);
+}
+
+void Output::recordCopyPairs(const std::vector<const MemcpyNode*> &srcNodes, const std::vector<const MemcpyNode*> &dstNodes) {
+    if (!keepsResults() || testcases.empty() || testcases.back().measurements.empty()) {
+        return;
+    }
+
+    Measurement &measurement = testcases.back().measurements.back();
+    measurement.pairs.clear();
+    for (size_t i = 0; i < srcNodes.size(); i++) {
+        measurement.pairs.emplace_back(srcNodes[i]->getNodeString(), dstNodes[i]->getNodeString());
+    }
+}
+
+void Output::recordStartSkew(const PerformanceStatistic &skew) {
+    if (!keepsResults() || testcases.empty() || testcases.back().measurements.empty()) {
+        return;
+    }
+
+    Measurement &measurement = testcases.back().measurements.back();
+    measurement.hasStartSkew = true;
+    measurement.startSkewMedian = skew.median();
+    measurement.startSkewMax = skew.largest();
+}
+
+void Output::recordIterationTimes(const TimingHistogram &times) {
+    if (!keepsResults() || testcases.empty() || testcases.back().measurements.empty()) {
+        return;
+    }
+
+    Measurement &measurement = testcases.back().measurements.back();
+    measurement.iterations = times.count();
+    measurement.iterationP50 = times.percentileNs(50) * 1e-3;
+    measurement.iterationP90 = times.percentileNs(90) * 1e-3;
+    measurement.iterationP99 = times.percentileNs(99) * 1e-3;
+    measurement.iterationP999 = times.percentileNs(99.9) * 1e-3;
+    measurement.iterationMax = times.largestNs() * 1e-3;
+}
+
+#ifdef ROCM_SMI
+void Output::recordCounters(const std::vector<DeviceCounters> &counters) {
+    if (!keepsResults() || testcases.empty() || testcases.back().measurements.empty()) {
+        return;
+    }
+
+    testcases.back().measurements.back().counters = counters;
+}
+#endif
+
+void Output::addTestcaseResults(const PeerValueMatrix<double> &matrix, const std::string &title, Direction direction) {
+    std::cout << title << std::endl;
+    std::cout << std::fixed << std::setprecision(2) << matrix << std::endl;
+
+    if (metrics) {
+        metrics->addTestcaseResults(currentKey, matrix, title);
+    }
+
+    if (!keepsResults() || testcases.empty()) {
+        return;
+    }
+
+    Matrix result = {title, matrix.m_rows, matrix.m_columns, {}, matrix.rowLabels, matrix.columnLabels, direction};
+    for (int row = 0; row < matrix.m_rows; row++) {
+        for (int column = 0; column < matrix.m_columns; column++) {
+            result.values.push_back(matrix.value(row, column));
+        }
+    }
+    testcases.back().matrices.push_back(result);
+}
+
+void Output::print() {
+    if (format == JSON) {
+        printJson();
+    } else if (format == CSV) {
+        printCsv();
+    }
+}
+
+void Output::printJson() {
+    std::ostream &o = *structuredStream;
+
+    o << std::defaultfloat << std::setprecision(10);
+    o << "{\n";
+    o << "  \"nvbandwidth\": {\"version\": " << jsonString(NVBANDWIDTH_VERSION) << ", \"git_version\": " << jsonString(GIT_VERSION) << "},\n";
+    o << "  \"host_mem_type\": " << jsonString(hostMemTypeNames[hostMemType]) << ",\n";
+    o << "  \"ce_copy_path\": " << jsonString(ceCopyPathNames[ceCopyPath]) << ",\n";
+    o << "  \"backend\": " << jsonString(copyBackendNames[copyBackend]) << ",\n";
+    o << "  \"testcases\": [";
+    for (size_t t = 0; t < testcases.size(); t++) {
+        const TestcaseResult &testcase = testcases[t];
+        o << (t ? "," : "") << "\n    {\n";
+        o << "      \"name\": " << jsonString(testcase.key) << ",\n";
+        o << "      \"status\": " << jsonString(testcase.status) << ",\n";
+        if (!testcase.error.empty()) {
+            o << "      \"error\": " << jsonString(testcase.error) << ",\n";
+        }
+
+        o << "      \"results\": [";
+        for (size_t m = 0; m < testcase.matrices.size(); m++) {
+            const Matrix &matrix = testcase.matrices[m];
+            o << (m ? "," : "") << "\n        {\"title\": " << jsonString(matrix.title) << ", ";
+            for (const auto &labels : {std::make_pair("row_labels", &matrix.rowLabels), std::make_pair("column_labels", &matrix.columnLabels)}) {
+                if (labels.second->empty()) {
+                    continue;
+                }
+                o << "\"" << labels.first << "\": [";
+                for (size_t l = 0; l < labels.second->size(); l++) {
+                    o << (l ? ", " : "") << jsonString(labels.second->at(l));
+                }
+                o << "], ";
+            }
+            o << "\"matrix\": [";
+            for (int row = 0; row < matrix.rows; row++) {
+                o << (row ? ", " : "") << "[";
+                for (int column = 0; column < matrix.columns; column++) {
+                    const std::optional<double> &value = matrix.values[row * matrix.columns + column];
+                    o << (column ? ", " : "");
+                    if (value) {
+                        o << value.value();
+                    } else {
+                        o << "null";
+                    }
+                }
+                o << "]";
+            }
+            o << "]}";
+        }
+        o << (testcase.matrices.empty() ? "" : "\n      ") << "],\n";
+
+        o << "      \"measurements\": [";
+        for (size_t m = 0; m < testcase.measurements.size(); m++) {
+            const Measurement &measurement = testcase.measurements[m];
+            o << (m ? "," : "") << "\n        {";
+            o << "\"src\": " << jsonString(measurement.src) << ", \"dst\": " << jsonString(measurement.dst) << ", ";
+            o << "\"src_name\": " << jsonString(measurement.srcName) << ", \"dst_name\": " << jsonString(measurement.dstName) << ", ";
+            o << "\"link\": " << jsonString(measurement.link) << ", \"hops\": " << measurement.hops << ", ";
+            if (measurement.efficiency >= 0.0) {
+                o << "\"link_peak_gbps\": " << measurement.peakBandwidth << ", \"efficiency\": " << measurement.efficiency << ", ";
+            }
+            o << "\"buffer_size\": " << measurement.bufferSize << ", \"copies\": " << measurement.copies << ", ";
+            o << "\"unit\": " << jsonString(measurement.unit) << ", \"samples\": " << measurement.samples << ", ";
+            o << "\"median\": " << measurement.median << ", \"mean\": " << measurement.mean << ", \"stddev\": " << measurement.stddev << ", ";
+            o << "\"min\": " << measurement.min << ", \"max\": " << measurement.max;
+            if (std::isfinite(measurement.ci95Relative)) {
+                o << ", \"ci95_relative\": " << measurement.ci95Relative;
+            }
+            if (measurement.pairs.size() > 1) {
+                o << ", \"pairs\": [";
+                for (size_t p = 0; p < measurement.pairs.size(); p++) {
+                    o << (p ? ", " : "") << "{\"src\": " << jsonString(measurement.pairs[p].first) << ", \"dst\": " << jsonString(measurement.pairs[p].second) << "}";
+                }
+                o << "]";
+            }
+            if (measurement.hasStartSkew) {
+                o << ", \"start_skew_us\": {\"median\": " << measurement.startSkewMedian << ", \"max\": " << measurement.startSkewMax << "}";
+            }
+            if (measurement.iterations) {
+                o << ", \"iteration_time_us\": {\"copies\": " << measurement.iterations << ", \"p50\": " << measurement.iterationP50
+                  << ", \"p90\": " << measurement.iterationP90 << ", \"p99\": " << measurement.iterationP99
+                  << ", \"p99.9\": " << measurement.iterationP999 << ", \"max\": " << measurement.iterationMax << "}";
+            }
+#ifdef ROCM_SMI
+            if (!measurement.counters.empty()) {
+                o << ", \"counters\": [";
+                for (size_t d = 0; d < measurement.counters.size(); d++) {
+                    const DeviceCounters &counters = measurement.counters[d];
+                    // values the device doesn't report are left out
+                    auto field = [&](const char *name, double value) {
+                        if (value >= 0.0) {
+                            o << ", \"" << name << "\": " << value;
+                        }
+                    };
+                    o << (d ? ", " : "") << "{\"device\": " << counters.deviceId << ", \"seconds\": " << counters.seconds;
+                    field("xgmi_read_bytes", counters.xgmiReadBytes);
+                    field("xgmi_write_bytes", counters.xgmiWriteBytes);
+                    field("xgmi_busiest_link_bytes", counters.busiestXgmiLinkBytes);
+                    field("xgmi_link_utilization", counters.xgmiUtilization());
+                    field("pcie_utilization", counters.pcieUtilization());
+                    field("hbm_activity_percent", counters.hbmActivity);
+                    field("average_power_w", counters.averagePower);
+                    field("gfx_clock_mhz", counters.gfxClock);
+                    field("memory_clock_mhz", counters.memClock);
+                    o << "}";
+                }
+                o << "]";
+            }
+#endif
+            o << "}";
+        }
+        o << (testcase.measurements.empty() ? "" : "\n      ") << "]\n";
+        o << "    }";
+    }
+    o << (testcases.empty() ? "" : "\n  ") << "]\n";
+    o << "}" << std::endl;
+}
+
+// One row per measurement, waived and failed testcases get a row with their status only
+void Output::printCsv() {
+    std::ostream &o = *structuredStream;
+
+    o << std::defaultfloat << std::setprecision(10);
+    o << "testcase,status,src,dst,src_name,dst_name,link,hops,buffer_size,copies,unit,samples,median,mean,stddev,min,max,ci95_relative,link_peak_gbps,efficiency,pairs" << std::endl;
+    for (const TestcaseResult &testcase : testcases) {
+        if (testcase.measurements.empty()) {
+            o << csvString(testcase.key) << "," << csvString(testcase.error.empty() ? testcase.status : testcase.error) << std::string(19, ',') << std::endl;
+        }
+        for (const Measurement &m : testcase.measurements) {
+            o << csvString(testcase.key) << "," << testcase.status << "," << csvString(m.src) << "," << csvString(m.dst) << ","
+              << csvString(m.srcName) << "," << csvString(m.dstName) << "," << m.link << "," << m.hops << ","
+              << m.bufferSize << "," << m.copies << "," << m.unit << "," << m.samples << ","
+              << m.median << "," << m.mean << "," << m.stddev << "," << m.min << "," << m.max << ",";
+            if (std::isfinite(m.ci95Relative)) {
+                o << m.ci95Relative;
+            }
+            o << ",";
+            if (m.efficiency >= 0.0) {
+                o << m.peakBandwidth << "," << m.efficiency;
+            } else {
+                o << ",";
+            }
+            // simultaneous copies as src->dst separated by semicolons
+            o << ",";
+            if (m.pairs.size() > 1) {
+                std::string pairs;
+                for (const auto &pair : m.pairs) {
+                    pairs += (pairs.empty() ? "" : ";") + pair.first + "->" + pair.second;
+                }
+                o << csvString(pairs);
+            }
+            o << std::endl;
+        }
+    }
+}
+
+static std::string cellName(const std::string &title, const std::vector<std::string> &rowLabels, const std::vector<std::string> &columnLabels, int row, int column) {
+    return title + " [" + (rowLabels.empty() ? std::to_string(row) : rowLabels[row]) + ", " +
+           (columnLabels.empty() ? std::to_string(column) : columnLabels[column]) + "]";
+}
+
+// The baseline is a tab separated text file. Header lines hold the buffer size and every device name,
+// then one "cell" line per matrix value: testcase key, index of the matrix in the testcase, matrix title,
+// direction ("higher" or "lower" is better), row, column and value.
+void Output::saveBaseline(const std::string &path, unsigned long long bufferSize) {
+    std::ofstream file(path);
+    if (!file) {
+        throw "Can't open baseline file " + path;
+    }
+
+    file << std::defaultfloat << std::setprecision(10);
+    file << "nvbandwidth_baseline\t" << NVBANDWIDTH_VERSION << "\n";
+    file << "buffer_size\t" << bufferSize << "\n";
+    for (int deviceId = 0; deviceId < deviceCount; deviceId++) {
+        file << "device\t" << deviceId << "\t" << deviceName(deviceId) << "\n";
+    }
+    for (const TestcaseResult &testcase : testcases) {
+        if (testcase.status != "Passed") {
+            continue;
+        }
+        for (size_t index = 0; index < testcase.matrices.size(); index++) {
+            const Matrix &matrix = testcase.matrices[index];
+            for (int row = 0; row < matrix.rows; row++) {
+                for (int column = 0; column < matrix.columns; column++) {
+                    const std::optional<double> &value = matrix.values[row * matrix.columns + column];
+                    if (value) {
+                        file << "cell\t" << testcase.key << "\t" << index << "\t" << matrix.title << "\t"
+                             << (matrix.direction == LOWER_IS_BETTER ? "lower" : "higher") << "\t" << row << "\t" << column << "\t" << value.value() << "\n";
+                    }
+                }
+            }
+        }
+    }
+    if (!file) {
+        throw "Can't write baseline file " + path;
+    }
+    std::cout << "Saved baseline to " << path << std::endl;
+}
+
+size_t Output::compareBaseline(const std::string &path, unsigned long long bufferSize, double tolerance) {
+    std::ifstream file(path);
+    if (!file) {
+        throw "Can't open baseline file " + path;
+    }
+
+    // (testcase, matrix index, row, column) -> cell
+    struct BaselineCell {
+        std::string title;
+        Direction direction;
+        double value;
+    };
+    std::map<std::tuple<std::string, int, int, int>, BaselineCell> baseline;
+    std::vector<std::string> baselineDevices;
+    unsigned long long baselineBufferSize = 0;
+    std::string line;
+    while (std::getline(file, line)) {
+        std::vector<std::string> fields;
+        std::stringstream stream(line);
+        std::string field;
+        while (std::getline(stream, field, '\t')) {
+            fields.push_back(field);
+        }
+        try {
+            if (fields.size() == 2 && fields[0] == "buffer_size") {
+                baselineBufferSize = std::stoull(fields[1]);
+            } else if (fields.size() == 3 && fields[0] == "device") {
+                baselineDevices.push_back(fields[2]);
+            } else if (fields.size() == 8 && fields[0] == "cell" && (fields[4] == "higher" || fields[4] == "lower")) {
+                baseline[{fields[1], std::stoi(fields[2]), std::stoi(fields[5]), std::stoi(fields[6])}] =
+                    {fields[3], fields[4] == "lower" ? LOWER_IS_BETTER : HIGHER_IS_BETTER, std::stod(fields[7])};
+            } else if (!fields.empty() && fields[0] == "cell") {
+                throw std::invalid_argument("cell");
+            }
+        } catch (std::exception &) {
+            throw "Invalid baseline line in " + path + ": " + line;
+        }
+    }
+
+    if (baselineBufferSize != bufferSize) {
+        throw "Baseline " + path + " was recorded with " + std::to_string(baselineBufferSize) + " byte buffers, this run uses " + std::to_string(bufferSize);
+    }
+    if (baselineDevices.size() != deviceCount) {
+        throw "Baseline " + path + " was recorded on " + std::to_string(baselineDevices.size()) + " devices, this system has " + std::to_string(deviceCount);
+    }
+    for (int deviceId = 0; deviceId < deviceCount; deviceId++) {
+        if (baselineDevices[deviceId] != deviceName(deviceId)) {
+            throw "Baseline " + path + " was recorded with " + baselineDevices[deviceId] + " as device " + std::to_string(deviceId) + ", this system has " + deviceName(deviceId);
+        }
+    }
+
+    std::cout << "Comparing against baseline " << path << " with a " << std::fixed << std::setprecision(1) << tolerance * 100 << "% tolerance" << std::endl;
+    size_t compared = 0, regressions = 0;
+    for (const TestcaseResult &testcase : testcases) {
+        // a testcase that ran but produced nothing regresses every cell of the baseline
+        for (auto it = baseline.lower_bound({testcase.key, INT_MIN, INT_MIN, INT_MIN}); it != baseline.end() && std::get<0>(it->first) == testcase.key; it++) {
+            const BaselineCell &baselineCell = it->second;
+            int index = std::get<1>(it->first), row = std::get<2>(it->first), column = std::get<3>(it->first);
+            // matrices are matched by position, a matrix with another title at that position isn't the baseline's
+            const Matrix *matrix = index < testcase.matrices.size() && testcase.matrices[index].title == baselineCell.title &&
+                                   row < testcase.matrices[index].rows && column < testcase.matrices[index].columns ? &testcase.matrices[index] : nullptr;
+            std::string cell = testcase.key + ": " + (matrix == nullptr ? cellName(baselineCell.title, {}, {}, row, column) :
+                                                      cellName(baselineCell.title, matrix->rowLabels, matrix->columnLabels, row, column));
+            double expected = baselineCell.value;
+            compared++;
+
+            std::optional<double> value;
+            if (matrix != nullptr) {
+                value = matrix->values[row * matrix->columns + column];
+            }
+            if (!value) {
+                std::cout << "\tMISSING " << cell << ": baseline " << std::setprecision(2) << expected << std::endl;
+                regressions++;
+                continue;
+            }
+
+            double actual = value.value();
+            double change = expected != 0.0 ? (actual - expected) / expected : 0.0;
+            bool regressed = baselineCell.direction == LOWER_IS_BETTER ? change > tolerance : change < -tolerance;
+            if (regressed) {
+                std::cout << "\tREGRESSED " << cell << ": " << std::setprecision(2) << actual << ", baseline " << expected
+                          << " (" << std::showpos << change * 100 << std::noshowpos << "%)" << std::endl;
+                regressions++;
+            }
+        }
+    }
+
+    std::cout << compared << " baseline values compared, " << regressions << " regressed" << std::endl << std::endl;
+    return regressions;
+}
@@ -0,0 +1,156 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include <fstream>
+
+#include "common.h"
+#include "memcpy.h"
+#include "metrics.h"
+
+// Collects the results of every testcase. Matrices are printed to the human readable log as they are added,
+// and when a structured format is selected all matrices and per measurement statistics are emitted by print()
+// to a stream separate from the log.
+class Output {
+public:
+    enum Format {
+        NONE,
+        JSON,
+        CSV
+    };
+
+    // Which way a matrix value moves when it regresses
+    enum Direction {
+        HIGHER_IS_BETTER,   // throughputs
+        LOWER_IS_BETTER     // latencies
+    };
+
+private:
+    // Statistics of the samples behind one measured value, usually one matrix cell
+    struct Measurement {
+        std::string src;
+        std::string dst;
+        std::string srcName;
+        std::string dstName;
+        std::string link;
+        int hops;
+        // topology peak of the link in GB/s and the measured median against it, for single copy GB/s measurements
+        double peakBandwidth = 0.0;
+        double efficiency = -1.0;
+        // link type and hop count the summary groups by, host links are told apart by how the host is attached
+        std::string linkClass;
+        unsigned long long bufferSize;
+        size_t copies;
+        std::string unit;
+        size_t samples;
+        double median, mean, stddev, min, max;
+        // relative half-width of the 95% confidence interval of the mean, infinite below two samples
+        double ci95Relative;
+        // single copy time percentiles in microseconds, with --perIterationTiming
+        unsigned long long iterations = 0;
+        double iterationP50, iterationP90, iterationP99, iterationP999, iterationMax;
+        // (src, dst) of every simultaneous copy behind the value, the first one is src and dst
+        std::vector<std::pair<std::string, std::string>> pairs;
+        // median and largest delay between the first and last stream start, in microseconds, for simultaneous copies
+        bool hasStartSkew = false;
+        double startSkewMedian, startSkewMax;
+#ifdef ROCM_SMI
+        // counters of the devices taking part, with --counters
+        std::vector<DeviceCounters> counters;
+#endif
+    };
+
+    struct Matrix {
+        std::string title;
+        int rows, columns;
+        std::vector<std::optional<double>> values;
+        std::vector<std::string> rowLabels, columnLabels;
+        Direction direction;
+    };
+
+    struct TestcaseResult {
+        std::string key;
+        std::string status;
+        std::string error;
+        std::vector<Matrix> matrices;
+        std::vector<Measurement> measurements;
+    };
+
+    Format format;
+    std::ostream *structuredStream;
+    std::ofstream outputFile;
+    std::vector<TestcaseResult> testcases;
+    std::string currentKey;
+    MetricsServer *metrics;
+    bool retain = false;
+    bool linkSummary = false;
+
+    // Testcase results are only kept when something consumes them at the end of the run
+    bool keepsResults() const { return format != NONE || retain; }
+    void printJson();
+    void printCsv();
+public:
+    // outputFile "-" writes structured results to stdout and moves the human readable log to stderr
+    Output(Format format = NONE, const std::string &outputFile = "-");
+    ~Output();
+
+    // Also publishes the status and matrices of every testcase to the metrics server, for --daemon
+    void setMetricsServer(MetricsServer *metricsServer) { metrics = metricsServer; }
+    MetricsServer *getMetricsServer() const { return metrics; }
+
+    void beginTestcase(const std::string &key);
+    void waiveTestcase();
+    void errorTestcase(const std::string &error);
+    // Prints the link efficiency summary of the testcase that just ran, with summarizeLinks()
+    void endTestcase();
+
+    // Records the samples of a measurement between src and dst, each sample is multiplied by scale to get unit
+    void recordMeasurement(const MemcpyNode &src, const MemcpyNode &dst, size_t copies, unsigned long long bufferSize,
+                           const PerformanceStatistic &stat, double scale, const std::string &unit);
+    // Attaches the nodes of every simultaneous copy to the last recorded measurement
+    void recordCopyPairs(const std::vector<const MemcpyNode*> &srcNodes, const std::vector<const MemcpyNode*> &dstNodes);
+    // Attaches the per sample start skew between the simultaneous copy streams to the last recorded measurement
+    void recordStartSkew(const PerformanceStatistic &skew);
+    // Attaches the single copy times of the samples to the last recorded measurement
+    void recordIterationTimes(const TimingHistogram &times);
+#ifdef ROCM_SMI
+    // Attaches the device counters sampled over the timed sections to the last recorded measurement
+    void recordCounters(const std::vector<DeviceCounters> &counters);
+#endif
+    // Prints the matrix to the log and keeps it for the structured output and the baseline
+    void addTestcaseResults(const PeerValueMatrix<double> &matrix, const std::string &title, Direction direction = HIGHER_IS_BETTER);
+
+    // Emits the structured results of all testcases
+    void print();
+
+    // Keeps the results of every testcase without a structured format, for the baseline
+    void retainResults() { retain = true; }
+    // Groups the single copy bandwidths of every testcase by link class and prints their efficiency against the link peaks
+    void summarizeLinks() { retain = true; linkSummary = true; }
+    // Writes every matrix value of the testcases that passed, with the device names and the buffer size they were measured with
+    void saveBaseline(const std::string &path, unsigned long long bufferSize);
+    // Compares every baseline value of the testcases that ran, prints the regressed and missing ones and returns their count.
+    // Values regress when they move against the direction of their matrix by more than tolerance.
+    // Throws if the baseline can't be read or was recorded on other devices or with another buffer size.
+    size_t compareBaseline(const std::string &path, unsigned long long bufferSize, double tolerance);
+};
+
+extern Output *output;
+
+#endif
@@ -17,6 +17,8 @@
 
 
 #include <hip/hip_runtime.h>
+#include "numa.h"
+#include "output.h"
 #include "testcase.h"
 
 Testcase::Testcase(std::string key, std::string desc) : 
@@ -48,6 +50,44 @@ bool Testcase::filterHasAccessiblePeerPairs() {
     return false;
 }
 
+bool Testcase::filterKernelsAccessHostMem() {
+    if (hostMemType != HOST_MEM_PAGEABLE) {
+        return true;
+    }
+
+    for (int deviceId = 0; deviceId < deviceCount; deviceId++) {
+        int pageableMemoryAccess = 0;
+        CU_ASSERT(hipDeviceGetAttribute(&pageableMemoryAccess, hipDeviceAttributePageableMemoryAccess, deviceId));
+        if (!pageableMemoryAccess) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool filterDeviceAttribute(hipDeviceAttribute_t attribute) {
+    for (int deviceId = 0; deviceId < deviceCount; deviceId++) {
+        int value = 0;
+        CU_ASSERT(hipDeviceGetAttribute(&value, attribute, deviceId));
+        if (!value) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Testcase::filterManagedMemory() {
+    return filterDeviceAttribute(hipDeviceAttributeManagedMemory);
+}
+
+bool Testcase::filterManagedPageFaults() {
+    return filterDeviceAttribute(hipDeviceAttributeManagedMemory) && filterDeviceAttribute(hipDeviceAttributeConcurrentManagedAccess);
+}
+
+bool Testcase::filterHasNumaNodes() {
+    return !getNumaNodes().empty();
+}
+
 void Testcase::allToOneHelper(unsigned long long size, MemcpyOperation &memcpyInstance, PeerValueMatrix<double> &bandwidthValues, bool isRead) {
     std::vector<const DeviceNode*> allSrcNodes;
 
@@ -176,6 +216,97 @@ void Testcase::allHostHelper(unsigned long long size, MemcpyOperation &memcpyIns
     }
 }
 
+void Testcase::pipelinedHelper(unsigned long long size, unsigned long long loopCount, bool sourceIsHost) {
+    std::vector<unsigned int> streamCounts;
+    for (unsigned int streams = 1; streams <= maxStreams; streams *= 2) {
+        streamCounts.push_back(streams);
+    }
+
+    for (unsigned long long chunkSize : pipelineChunkSizes) {
+        if (chunkSize > size) {
+            std::cout << "\tSkipping chunk size " << chunkSize << ", larger than the buffer size" << std::endl;
+            continue;
+        }
+
+        PeerValueMatrix<double> bandwidthValues(streamCounts.size(), deviceCount, key);
+        for (size_t row = 0; row < streamCounts.size(); row++) {
+            bandwidthValues.rowLabels.push_back(std::to_string(streamCounts[row]));
+            MemcpyOperationCEPipelined memcpyInstance(loopCount, chunkSize, streamCounts[row]);
+
+            for (int deviceId = 0; deviceId < deviceCount; deviceId++) {
+                HostNode hostNode(size, deviceId);
+                DeviceNode deviceNode(size, deviceId);
+
+                if (sourceIsHost) {
+                    bandwidthValues.value(row, deviceId) = memcpyInstance.doMemcpy(hostNode, deviceNode);
+                } else {
+                    bandwidthValues.value(row, deviceId) = memcpyInstance.doMemcpy(deviceNode, hostNode);
+                }
+            }
+        }
+
+        std::stringstream title;
+        title << "memcpy CE CPU " << (sourceIsHost ? "->" : "<-") << " GPU(column) bandwidth with " << chunkSize
+              << " byte chunks over streams(row) (GB/s)";
+        output->addTestcaseResults(bandwidthValues, title.str());
+    }
+}
+
+void Testcase::streamScalingHelper(MemcpyOperation &memcpyInstance, PeerValueMatrix<double> &bandwidthValues, int column,
+                                   const std::function<std::pair<const MemcpyNode*, const MemcpyNode*>()> &newPair) {
+    std::vector<const MemcpyNode*> srcNodes;
+    std::vector<const MemcpyNode*> dstNodes;
+
+    for (unsigned int streams = 1; streams <= maxStreams; streams++) {
+        std::pair<const MemcpyNode*, const MemcpyNode*> pair = newPair();
+        srcNodes.push_back(pair.first);
+        dstNodes.push_back(pair.second);
+
+        bandwidthValues.value(streams - 1, column) = memcpyInstance.doMemcpy(srcNodes, dstNodes);
+    }
+
+    for (auto node : srcNodes) {
+        delete node;
+    }
+
+    for (auto node : dstNodes) {
+        delete node;
+    }
+}
+
+void Testcase::accessSweepHelper(unsigned long long loopCount, const MemcpyNode &srcNode, const MemcpyNode &dstNode, const std::string &link) {
+    PeerValueMatrix<double> bandwidthValues(accessSweepPatterns.size(), accessSweepSizes.size(), key);
+    PeerValueMatrix<double> accessValues(accessSweepPatterns.size(), accessSweepSizes.size(), key);
+
+    for (const AccessPattern &pattern : accessSweepPatterns) {
+        bandwidthValues.rowLabels.push_back(pattern.toString());
+    }
+    for (unsigned int accessSize : accessSweepSizes) {
+        bandwidthValues.columnLabels.push_back(std::to_string(accessSize));
+    }
+    accessValues.rowLabels = bandwidthValues.rowLabels;
+    accessValues.columnLabels = bandwidthValues.columnLabels;
+
+    for (int row = 0; row < accessSweepPatterns.size(); row++) {
+        for (int column = 0; column < accessSweepSizes.size(); column++) {
+            AccessPattern pattern = accessSweepPatterns[row];
+            pattern.accessSize = accessSweepSizes[column];
+            // a stride wider than the buffer would leave nothing to read
+            if (accessPatternKernelSize(srcNode.getBufferSize(), pattern) == 0) {
+                continue;
+            }
+
+            MemcpyOperationSMAccessPattern accessInstance(loopCount, pattern);
+            double bandwidth = accessInstance.doMemcpy(srcNode, dstNode);
+            bandwidthValues.value(row, column) = bandwidth;
+            accessValues.value(row, column) = bandwidth * 1e3 / pattern.accessSize;
+        }
+    }
+
+    output->addTestcaseResults(bandwidthValues, "zero-copy read SM " + link + ", pattern(row) x access size in bytes(column) bandwidth (GB/s)");
+    output->addTestcaseResults(accessValues, "zero-copy read SM " + link + ", pattern(row) x access size in bytes(column) accesses (M/s)");
+}
+
 void Testcase::allHostBidirHelper(unsigned long long size, MemcpyOperation &memcpyInstance, PeerValueMatrix<double> &bandwidthValues, bool sourceIsHost) {
     for (int deviceId = 0; deviceId < deviceCount; deviceId++) {
         std::vector<const MemcpyNode*> srcNodes;
@@ -222,3 +353,46 @@ void Testcase::allHostBidirHelper(unsigned long long size, MemcpyOperation &memc
         }
     }
 }
+
+void Testcase::allToAllHelper(unsigned long long size, MemcpyOperation &memcpyInstance, PeerValueMatrix<double> &linkBandwidthValues, PeerValueMatrix<double> &totalBandwidthValues) {
+    std::vector<const MemcpyNode*> srcNodes;
+    std::vector<const MemcpyNode*> dstNodes;
+
+    for (int srcDeviceId = 0; srcDeviceId < deviceCount; srcDeviceId++) {
+        for (int dstDeviceId = 0; dstDeviceId < deviceCount; dstDeviceId++) {
+            if (srcDeviceId == dstDeviceId) {
+                continue;
+            }
+
+            DeviceNode* srcNode = new DeviceNode(size, srcDeviceId);
+            DeviceNode* dstNode = new DeviceNode(size, dstDeviceId);
+
+            if (!srcNode->enablePeerAcess(*dstNode)) {
+                delete srcNode;
+                delete dstNode;
+                continue;
+            }
+
+            srcNodes.push_back(srcNode);
+            dstNodes.push_back(dstNode);
+        }
+    }
+
+    // All N * (N - 1) copies run at once, the total is based on the completion of the slowest one
+    if (!srcNodes.empty()) {
+        totalBandwidthValues.value(0, 0) = memcpyInstance.doMemcpy(srcNodes, dstNodes);
+
+        const std::vector<double> &copyBandwidths = memcpyInstance.getCopyBandwidths();
+        for (int i = 0; i < srcNodes.size(); i++) {
+            linkBandwidthValues.value(srcNodes[i]->getNodeIdx(), dstNodes[i]->getNodeIdx()) = copyBandwidths[i];
+        }
+    }
+
+    for (auto node : srcNodes) {
+        delete node;
+    }
+
+    for (auto node : dstNodes) {
+        delete node;
+    }
+}
@@ -18,8 +18,11 @@
 #ifndef BENCHMARK_H
 #define BENCHMARK_H
 
+#include <functional>
+
 #include "common.h"
 #include "memcpy.h"
+#include "multinode.h"
 
 class Testcase {
 protected:
@@ -27,12 +30,27 @@ protected:
     std::string desc;
 
     static bool filterHasAccessiblePeerPairs();
+    // Kernels can't access pageable host memory unless the devices support it
+    static bool filterKernelsAccessHostMem();
+    // Managed memory support, and on demand page migration for testcases relying on faults
+    static bool filterManagedMemory();
+    static bool filterManagedPageFaults();
+    // The system reports NUMA nodes
+    static bool filterHasNumaNodes();
 
     // helper functions
     void allToOneHelper(unsigned long long size, MemcpyOperation &memcpyInstance, PeerValueMatrix<double> &bandwidthValues, bool isRead);
     void oneToAllHelper(unsigned long long size, MemcpyOperation &memcpyInstance, PeerValueMatrix<double> &bandwidthValues, bool isRead);
     void allHostHelper(unsigned long long size, MemcpyOperation &memcpyInstance, PeerValueMatrix<double> &bandwidthValues, bool sourceIsHost);
+    // Measures 1 to maxStreams simultaneous copies between fresh node pairs from newPair into rows 0 to maxStreams - 1 of column
+    // One matrix per chunk size of rows stream counts and columns devices, copies from host when sourceIsHost
+    void pipelinedHelper(unsigned long long size, unsigned long long loopCount, bool sourceIsHost);
+    void streamScalingHelper(MemcpyOperation &memcpyInstance, PeerValueMatrix<double> &bandwidthValues, int column,
+                             const std::function<std::pair<const MemcpyNode*, const MemcpyNode*>()> &newPair);
     void allHostBidirHelper(unsigned long long size, MemcpyOperation &memcpyInstance, PeerValueMatrix<double> &bandwidthValues, bool sourceIsHost);
+    // Reads srcNode from dstNode's device with every access pattern and size, and adds the bandwidth and access rate matrices
+    void accessSweepHelper(unsigned long long loopCount, const MemcpyNode &srcNode, const MemcpyNode &dstNode, const std::string &link);
+    void allToAllHelper(unsigned long long size, MemcpyOperation &memcpyInstance, PeerValueMatrix<double> &linkBandwidthValues, PeerValueMatrix<double> &totalBandwidthValues);
 
 public:
     Testcase(std::string key, std::string desc);
@@ -43,6 +61,14 @@ public:
 
     // Returns true if the testcase can be run on the current system
     virtual bool filter() { return true; }
+    // Multinode testcases are the only ones run by default on more than one rank
+    virtual bool isMultinode() { return false; }
+
+    // Largest number of buffers the testcase holds at once on one device and in host memory, and the device memory
+    // it needs besides them. --fillFraction splits the free memory of the devices and of the host among the buffers
+    virtual unsigned int deviceBuffers() const { return 1; }
+    virtual unsigned int hostBuffers() const { return 1; }
+    virtual unsigned long long reservedDeviceMemory() const { return 0; }
 
     // Runs the testcase
     virtual void run(unsigned long long size, unsigned long long loopCount) = 0;
@@ -77,6 +103,8 @@ public:
             "\tOnly the host to device copy bandwidth is reported.") {}
     virtual ~HostToDeviceBidirCE() {}
     void run(unsigned long long size, unsigned long long loopCount);
+    unsigned int deviceBuffers() const { return 2; }
+    unsigned int hostBuffers() const { return 2; }
 };
 
 // Device to host bidirectional CE memcpy using cuMemcpyAsync
@@ -87,6 +115,8 @@ public:
             "\tOnly the device to host copy bandwidth is reported.") {}
     virtual ~DeviceToHostBidirCE() {}
     void run(unsigned long long size, unsigned long long loopCount);
+    unsigned int deviceBuffers() const { return 2; }
+    unsigned int hostBuffers() const { return 2; }
 };
 
 // Device to Device CE Read memcpy using cuMemcpyAsync
@@ -120,6 +150,7 @@ public:
             "\tRead tests launch a copy from the peer device to the target using the target's context.") {}
     virtual ~DeviceToDeviceBidirReadCE() {}
     void run(unsigned long long size, unsigned long long loopCount);
+    unsigned int deviceBuffers() const { return 2; }
     bool filter() { return Testcase::filterHasAccessiblePeerPairs(); }
 };
 
@@ -132,6 +163,7 @@ public:
             "\tWrite tests launch a copy from the target device to the peer using the target's context.") {}
     virtual ~DeviceToDeviceBidirWriteCE() {}
     void run(unsigned long long size, unsigned long long loopCount);
+    unsigned int deviceBuffers() const { return 2; }
     bool filter() { return Testcase::filterHasAccessiblePeerPairs(); }
 };
 
@@ -143,6 +175,7 @@ public:
             "\trunning copies from all other devices to the host.") {}
     virtual ~AllToHostCE() {}
     void run(unsigned long long size, unsigned long long loopCount);
+    unsigned int hostBuffers() const { return deviceCount; }
 };
 
 // All to Host bidirectional CE memcpy using cuMemcpyAsync
@@ -154,6 +187,8 @@ public:
             "\tAll other devices generate simultaneous host to device and device to host interferring traffic.") {}
     virtual ~AllToHostBidirCE() {}
     void run(unsigned long long size, unsigned long long loopCount);
+    unsigned int deviceBuffers() const { return 2; }
+    unsigned int hostBuffers() const { return 2 * deviceCount; }
 };
 
 // Host to All CE memcpy using cuMemcpyAsync
@@ -164,6 +199,7 @@ public:
             "\trunning copies from the host to all other devices.") {}
     virtual ~HostToAllCE() {}
     void run(unsigned long long size, unsigned long long loopCount);
+    unsigned int hostBuffers() const { return deviceCount; }
 };
 
 // Host to All bidirectional CE memcpy using cuMemcpyAsync
@@ -175,6 +211,8 @@ public:
             "\tAll other devices generate simultaneous host to device and device to host interferring traffic.") {}
     virtual ~HostToAllBidirCE() {}
     void run(unsigned long long size, unsigned long long loopCount);
+    unsigned int deviceBuffers() const { return 2; }
+    unsigned int hostBuffers() const { return 2 * deviceCount; }
 };
 
 
@@ -187,6 +225,7 @@ public:
             "\tWrite tests launch a copy from the target device to the peer using the target's context.") {}
     virtual ~AllToOneWriteCE() {}
     void run(unsigned long long size, unsigned long long loopCount);
+    unsigned int deviceBuffers() const { return std::max(deviceCount - 1, 1); }
     bool filter() { return Testcase::filterHasAccessiblePeerPairs(); }
 };
 
@@ -199,6 +238,7 @@ public:
             "\tRead tests launch a copy from the peer device to the target using the target's context.") {}
     virtual ~AllToOneReadCE() {}
     void run(unsigned long long size, unsigned long long loopCount);
+    unsigned int deviceBuffers() const { return std::max(deviceCount - 1, 1); }
     bool filter() { return Testcase::filterHasAccessiblePeerPairs(); }
 };
 
@@ -211,6 +251,7 @@ public:
             "\tWrite tests launch a copy from the target device to the peer using the target's context.") {}
     virtual ~OneToAllWriteCE() {}
     void run(unsigned long long size, unsigned long long loopCount);
+    unsigned int deviceBuffers() const { return std::max(deviceCount - 1, 1); }
     bool filter() { return Testcase::filterHasAccessiblePeerPairs(); }
 };
 
@@ -223,9 +264,93 @@ public:
             "\tRead tests launch a copy from the peer device to the target using the target's context.") {}
     virtual ~OneToAllReadCE() {}
     void run(unsigned long long size, unsigned long long loopCount);
+    unsigned int deviceBuffers() const { return std::max(deviceCount - 1, 1); }
+    bool filter() { return Testcase::filterHasAccessiblePeerPairs(); }
+};
+
+// All to All CE memcpy using cuMemcpyAsync
+class AllToAllCE: public Testcase {
+public:
+    AllToAllCE() : Testcase("all_to_all_ce",
+            "\tMeasures the bandwidth of simultaneous copies between every pair of accessible peers, with every device\n"
+            "\tcopying to all other devices at the same time. The total bandwidth of all copies is reported together with\n"
+            "\tthe bandwidth of each link.\n"
+            "\tWrite tests launch a copy from the target device to the peer using the target's context.") {}
+    virtual ~AllToAllCE() {}
+    void run(unsigned long long size, unsigned long long loopCount);
+    unsigned int deviceBuffers() const { return 2 * std::max(deviceCount - 1, 1); }
+    bool filter() { return Testcase::filterHasAccessiblePeerPairs(); }
+};
+
+// Host to device CE memcpy from host memory placed on each NUMA node
+class HostNumaToDeviceCE: public Testcase {
+public:
+    HostNumaToDeviceCE() : Testcase("host_numa_to_device_memcpy_ce",
+            "\tHost to device CE memcpy using hipMemcpyAsync_, with the host buffer and the copying thread bound to\n"
+            "\teach NUMA node in turn. Shows the penalty of host memory placed on a socket far from the device.") {}
+    virtual ~HostNumaToDeviceCE() {}
+    void run(unsigned long long size, unsigned long long loopCount);
+    bool filter() { return Testcase::filterHasNumaNodes(); }
+};
+
+// Host to device CE memcpy on 1 to maxStreams concurrent streams per device
+class HostToDeviceStreamScalingCE: public Testcase {
+public:
+    HostToDeviceStreamScalingCE() : Testcase("host_to_device_stream_scaling_ce",
+            "\tHost to device CE memcpy using hipMemcpyAsync_ on 1 to --maxStreams concurrent streams of one device,\n"
+            "\teach stream copying its own buffers. Reports the total bandwidth of all streams, which stops growing\n"
+            "\tonce the device runs out of copy engines for the direction.") {}
+    virtual ~HostToDeviceStreamScalingCE() {}
+    void run(unsigned long long size, unsigned long long loopCount);
+    unsigned int deviceBuffers() const { return maxStreams; }
+    unsigned int hostBuffers() const { return maxStreams; }
+};
+
+// Device to host CE memcpy on 1 to maxStreams concurrent streams per device
+class DeviceToHostStreamScalingCE: public Testcase {
+public:
+    DeviceToHostStreamScalingCE() : Testcase("device_to_host_stream_scaling_ce",
+            "\tDevice to host CE memcpy using hipMemcpyAsync_ on 1 to --maxStreams concurrent streams of one device,\n"
+            "\teach stream copying its own buffers. Reports the total bandwidth of all streams.") {}
+    virtual ~DeviceToHostStreamScalingCE() {}
+    void run(unsigned long long size, unsigned long long loopCount);
+    unsigned int deviceBuffers() const { return maxStreams; }
+    unsigned int hostBuffers() const { return maxStreams; }
+};
+
+// Device to device CE memcpy on 1 to maxStreams concurrent streams over a single peer link
+class DeviceToDeviceStreamScalingCE: public Testcase {
+public:
+    DeviceToDeviceStreamScalingCE() : Testcase("device_to_device_stream_scaling_ce",
+            "\tDevice to device CE memcpy using hipMemcpyAsync_ on 1 to --maxStreams concurrent streams, from each\n"
+            "\tdevice to the next accessible peer (device 0 for the last one) using the source context.\n"
+            "\tReports the total bandwidth of all streams over that single link.") {}
+    virtual ~DeviceToDeviceStreamScalingCE() {}
+    void run(unsigned long long size, unsigned long long loopCount);
+    unsigned int deviceBuffers() const { return maxStreams; }
     bool filter() { return Testcase::filterHasAccessiblePeerPairs(); }
 };
 
+// Host to device CE memcpy split into chunks over several streams
+class HostToDevicePipelinedCE: public Testcase {
+public:
+    HostToDevicePipelinedCE() : Testcase("host_to_device_pipelined_ce",
+            "\tHost to device CE memcpy with each copy split into --pipelineChunkSizes chunks spread round robin over\n"
+            "\t1 to --maxStreams streams (powers of two) of the device. Prints one matrix per chunk size.") {}
+    virtual ~HostToDevicePipelinedCE() {}
+    void run(unsigned long long size, unsigned long long loopCount);
+};
+
+// Device to host CE memcpy split into chunks over several streams
+class DeviceToHostPipelinedCE: public Testcase {
+public:
+    DeviceToHostPipelinedCE() : Testcase("device_to_host_pipelined_ce",
+            "\tDevice to host CE memcpy with each copy split into --pipelineChunkSizes chunks spread round robin over\n"
+            "\t1 to --maxStreams streams (powers of two) of the device. Prints one matrix per chunk size.") {}
+    virtual ~DeviceToHostPipelinedCE() {}
+    void run(unsigned long long size, unsigned long long loopCount);
+};
+
 // SM Testcase classes
 
 // Host to device SM memcpy using a copy kernel
@@ -235,6 +360,7 @@ public:
             "\tHost to device SM memcpy using a copy kernel") {}
     virtual ~HostToDeviceSM() {}
     void run(unsigned long long size, unsigned long long loopCount);
+    bool filter() { return Testcase::filterKernelsAccessHostMem(); }
 };
 
 // Device to host SM memcpy using a copy kernel
@@ -244,6 +370,7 @@ public:
             "\tDevice to host SM memcpy using a copy kernel") {}
     virtual ~DeviceToHostSM() {}
     void run(unsigned long long size, unsigned long long loopCount);
+    bool filter() { return Testcase::filterKernelsAccessHostMem(); }
 };
 
 // Device to Device SM Read memcpy using a copy kernel
@@ -277,6 +404,7 @@ public:
             "\tRead tests launch a copy from the peer device to the target using the target's context.") {}
     virtual ~DeviceToDeviceBidirReadSM() {}
     void run(unsigned long long size, unsigned long long loopCount);
+    unsigned int deviceBuffers() const { return 2; }
     bool filter() { return Testcase::filterHasAccessiblePeerPairs(); }
 };
 
@@ -289,6 +417,7 @@ public:
             "\tWrite tests launch a copy from the target device to the peer using the target's context.") {}
     virtual ~DeviceToDeviceBidirWriteSM() {}
     void run(unsigned long long size, unsigned long long loopCount);
+    unsigned int deviceBuffers() const { return 2; }
     bool filter() { return Testcase::filterHasAccessiblePeerPairs(); }
 };
 
@@ -300,6 +429,8 @@ public:
             "\trunning copies from all other devices to the host.") {}
     virtual ~AllToHostSM() {}
     void run(unsigned long long size, unsigned long long loopCount);
+    unsigned int hostBuffers() const { return deviceCount; }
+    bool filter() { return Testcase::filterKernelsAccessHostMem(); }
 };
 
 // All to Host bidirectional SM memcpy using a copy kernel
@@ -311,6 +442,9 @@ public:
             "\tAll other devices generate simultaneous host to device and device to host interferring traffic using copy kernels.") {}
     virtual ~AllToHostBidirSM() {}
     void run(unsigned long long size, unsigned long long loopCount);
+    unsigned int deviceBuffers() const { return 2; }
+    unsigned int hostBuffers() const { return 2 * deviceCount; }
+    bool filter() { return Testcase::filterKernelsAccessHostMem(); }
 };
 
 // Host to All SM memcpy using a copy kernel
@@ -321,6 +455,8 @@ public:
             "\trunning copies from the host to all other devices.") {}
     virtual ~HostToAllSM() {}
     void run(unsigned long long size, unsigned long long loopCount);
+    unsigned int hostBuffers() const { return deviceCount; }
+    bool filter() { return Testcase::filterKernelsAccessHostMem(); }
 };
 
 // Host to All bidirectional SM memcpy using a copy kernel
@@ -332,6 +468,9 @@ public:
             "\tAll other devices generate simultaneous host to device and device to host interferring traffic using copy kernels.") {}
     virtual ~HostToAllBidirSM() {}
     void run(unsigned long long size, unsigned long long loopCount);
+    unsigned int deviceBuffers() const { return 2; }
+    unsigned int hostBuffers() const { return 2 * deviceCount; }
+    bool filter() { return Testcase::filterKernelsAccessHostMem(); }
 };
 
 // All to One SM Write memcpy using a copy kernel
@@ -343,6 +482,7 @@ public:
             "\tWrite tests launch a copy from the target device to the peer using the target's context.") {}
     virtual ~AllToOneWriteSM() {}
     void run(unsigned long long size, unsigned long long loopCount);
+    unsigned int deviceBuffers() const { return std::max(deviceCount - 1, 1); }
     bool filter() { return Testcase::filterHasAccessiblePeerPairs(); }
 };
 
@@ -355,6 +495,7 @@ public:
             "\tRead tests launch a copy from the peer device to the target using the target's context.") {}
     virtual ~AllToOneReadSM() {}
     void run(unsigned long long size, unsigned long long loopCount);
+    unsigned int deviceBuffers() const { return std::max(deviceCount - 1, 1); }
     bool filter() { return Testcase::filterHasAccessiblePeerPairs(); }
 };
 
@@ -367,6 +508,7 @@ public:
             "\tWrite tests launch a copy from the target device to the peer using the target's context.") {}
     virtual ~OneToAllWriteSM() {}
     void run(unsigned long long size, unsigned long long loopCount);
+    unsigned int deviceBuffers() const { return std::max(deviceCount - 1, 1); }
     bool filter() { return Testcase::filterHasAccessiblePeerPairs(); }
 };
 
@@ -379,7 +521,243 @@ public:
             "\tRead tests launch a copy from the peer device to the target using the target's context.") {}
     virtual ~OneToAllReadSM() {}
     void run(unsigned long long size, unsigned long long loopCount);
+    unsigned int deviceBuffers() const { return std::max(deviceCount - 1, 1); }
     bool filter() { return Testcase::filterHasAccessiblePeerPairs(); }
 };
 
+// All to All SM memcpy using a copy kernel
+class AllToAllSM: public Testcase {
+public:
+    AllToAllSM() : Testcase("all_to_all_sm",
+            "\tMeasures the bandwidth of simultaneous copy kernels between every pair of accessible peers, with every device\n"
+            "\tcopying to all other devices at the same time. The total bandwidth of all copies is reported together with\n"
+            "\tthe bandwidth of each link.\n"
+            "\tWrite tests launch a copy from the target device to the peer using the target's context.") {}
+    virtual ~AllToAllSM() {}
+    void run(unsigned long long size, unsigned long long loopCount);
+    unsigned int deviceBuffers() const { return 2 * std::max(deviceCount - 1, 1); }
+    bool filter() { return Testcase::filterHasAccessiblePeerPairs(); }
+};
+
+// Local device memory bandwidth with the read, write and copy kernels
+class DeviceLocalMemorySM: public Testcase {
+public:
+    DeviceLocalMemorySM() : Testcase("device_local_memory_sm",
+            "\tMeasures the bandwidth of each device's own memory with a read only kernel, a write only kernel\n"
+            "\tand the copy kernel, one row each. Copies count the bytes copied, moving twice as much through memory.") {}
+    virtual ~DeviceLocalMemorySM() {}
+    void run(unsigned long long size, unsigned long long loopCount);
+    unsigned int deviceBuffers() const { return 2; }
+};
+
+// Host memory read and write bandwidth of separate read only and write only kernels
+class HostDeviceReadWriteSM: public Testcase {
+public:
+    HostDeviceReadWriteSM() : Testcase("host_device_read_write_sm",
+            "\tMeasures each device reading host memory with a read only kernel and writing it with a write only kernel,\n"
+            "\tseparating the two directions that a copy kernel always mixes.") {}
+    virtual ~HostDeviceReadWriteSM() {}
+    void run(unsigned long long size, unsigned long long loopCount);
+    bool filter() { return Testcase::filterKernelsAccessHostMem(); }
+};
+
+// Peer memory read and write bandwidth of separate read only and write only kernels
+class DeviceToDeviceReadWriteSM: public Testcase {
+public:
+    DeviceToDeviceReadWriteSM() : Testcase("device_to_device_read_write_sm",
+            "\tMeasures each device reading the memory of each accessible peer with a read only kernel and writing\n"
+            "\tit with a write only kernel. The kernels run on the row device onto the column device's memory.") {}
+    virtual ~DeviceToDeviceReadWriteSM() {}
+    void run(unsigned long long size, unsigned long long loopCount);
+    bool filter() { return Testcase::filterHasAccessiblePeerPairs(); }
+};
+
+// Zero-copy reads of host memory in scattered chunks
+class HostDeviceAccessSweepSM: public Testcase {
+public:
+    HostDeviceAccessSweepSM() : Testcase("host_device_access_sweep_sm",
+            "\tMeasures each device reading host memory directly from a kernel in 64 B to 4 KiB chunks, in order,\n"
+            "\twith larger strides and at random. Reports the bandwidth and the accesses per second of each device,\n"
+            "\twith one row per access pattern and one column per access size.") {}
+    virtual ~HostDeviceAccessSweepSM() {}
+    void run(unsigned long long size, unsigned long long loopCount);
+    bool filter() { return Testcase::filterKernelsAccessHostMem(); }
+};
+
+// Zero-copy reads of peer memory in scattered chunks
+class DeviceToDeviceAccessSweepSM: public Testcase {
+public:
+    DeviceToDeviceAccessSweepSM() : Testcase("device_to_device_access_sweep_sm",
+            "\tMeasures each device reading the memory of its next accessible peer directly from a kernel in 64 B to 4 KiB\n"
+            "\tchunks, in order, with larger strides and at random. Reports the bandwidth and the accesses per second\n"
+            "\tof each device, with one row per access pattern and one column per access size.") {}
+    virtual ~DeviceToDeviceAccessSweepSM() {}
+    void run(unsigned long long size, unsigned long long loopCount);
+    bool filter() { return Testcase::filterHasAccessiblePeerPairs(); }
+};
+
+// Latency Testcase classes
+
+// Host to device latency using a pointer chasing kernel
+class HostDeviceLatencySM: public Testcase {
+public:
+    HostDeviceLatencySM() : Testcase("host_device_latency_sm",
+            "\tMeasures the latency of dependent loads from each device to pinned host memory using a pointer chasing kernel.\n"
+            "\tLatency is reported in ns per access.") {}
+    virtual ~HostDeviceLatencySM() {}
+    void run(unsigned long long size, unsigned long long loopCount);
+    bool filter() { return Testcase::filterKernelsAccessHostMem(); }
+};
+
+// Device to device latency using a pointer chasing kernel
+class DeviceToDeviceLatencySM: public Testcase {
+public:
+    DeviceToDeviceLatencySM() : Testcase("device_to_device_latency_sm",
+            "\tMeasures the latency of dependent loads between each pair of accessible peers using a pointer chasing kernel.\n"
+            "\tThe kernel runs on the row device and chases a chain in the column device's memory.\n"
+            "\tLatency is reported in ns per access.") {}
+    virtual ~DeviceToDeviceLatencySM() {}
+    void run(unsigned long long size, unsigned long long loopCount);
+    bool filter() { return Testcase::filterHasAccessiblePeerPairs(); }
+};
+
+// Host to device round trip latency of small CE copies
+class HostDeviceLatencyCE: public Testcase {
+public:
+    HostDeviceLatencyCE() : Testcase("host_device_latency_ce",
+            "\tMeasures the round trip latency of small hipMemcpyAsync_ copies from the host to each device and back.\n"
+            "\tLatency is reported in ns per round trip.") {}
+    virtual ~HostDeviceLatencyCE() {}
+    void run(unsigned long long size, unsigned long long loopCount);
+    // dependent pageable copies block the host, so they can't be queued behind the spin kernel
+    bool filter() { return hostMemType != HOST_MEM_PAGEABLE; }
+};
+
+// Atomic Testcase classes
+
+// System scope atomics from each device onto fine grained host memory
+class HostDeviceAtomicSM: public Testcase {
+public:
+    HostDeviceAtomicSM() : Testcase("host_device_atomic_sm",
+            "\tMeasures system scope atomic add and CAS from each device onto fine grained host memory.\n"
+            "\tThroughput is reported in Mops/s for a full grid, one matrix per --atomicContention level of threads sharing each word.\n"
+            "\tLatency is reported in ns per atomic issued by a single thread, each one waiting for the previous result.\n"
+            "\tDevices without native host atomics are skipped.") {}
+    virtual ~HostDeviceAtomicSM() {}
+    void run(unsigned long long size, unsigned long long loopCount);
+};
+
+// System scope atomics from each device onto fine grained peer memory
+class DeviceToDeviceAtomicSM: public Testcase {
+public:
+    DeviceToDeviceAtomicSM() : Testcase("device_to_device_atomic_sm",
+            "\tMeasures system scope atomic add and CAS between each pair of accessible peers.\n"
+            "\tThe kernel runs on the row device onto a fine grained buffer in the column device's memory.\n"
+            "\tThroughput is reported in Mops/s for a full grid, one matrix per --atomicContention level of threads sharing each word.\n"
+            "\tLatency is reported in ns per atomic issued by a single thread, each one waiting for the previous result.\n"
+            "\tPairs without native peer atomics are skipped.") {}
+    virtual ~DeviceToDeviceAtomicSM() {}
+    void run(unsigned long long size, unsigned long long loopCount);
+    bool filter() { return Testcase::filterHasAccessiblePeerPairs(); }
+};
+
+// Interference Testcase classes
+
+// Host to device CE copies next to a background kernel on the destination device
+class HostToDeviceUnderLoadCE: public Testcase {
+public:
+    HostToDeviceUnderLoadCE() : Testcase("host_to_device_memcpy_ce_under_load",
+            "\tMeasures host to device CE copies while a background kernel of each --backgroundLoad type runs on the device.\n"
+            "\tThe kernel is launched before the copies of every sample are released and stopped once they completed.\n"
+            "\tReports the bandwidth on the idle and the loaded device, the bandwidth relative to idle and the\n"
+            "\tbackground kernel's throughput relative to running alone for as long.") {}
+    virtual ~HostToDeviceUnderLoadCE() {}
+    void run(unsigned long long size, unsigned long long loopCount);
+    unsigned long long reservedDeviceMemory() const { return BACKGROUND_LOAD_BUFFER_SIZE; }
+};
+
+// Host to device SM copies next to a background kernel on the destination device
+class HostToDeviceUnderLoadSM: public Testcase {
+public:
+    HostToDeviceUnderLoadSM() : Testcase("host_to_device_memcpy_sm_under_load",
+            "\tMeasures host to device SM copies while a background kernel of each --backgroundLoad type runs on the device.\n"
+            "\tThe kernel is launched before the copies of every sample are released and stopped once they completed.\n"
+            "\tReports the bandwidth on the idle and the loaded device, the bandwidth relative to idle and the\n"
+            "\tbackground kernel's throughput relative to running alone for as long.") {}
+    virtual ~HostToDeviceUnderLoadSM() {}
+    void run(unsigned long long size, unsigned long long loopCount);
+    unsigned long long reservedDeviceMemory() const { return BACKGROUND_LOAD_BUFFER_SIZE; }
+    bool filter() { return Testcase::filterKernelsAccessHostMem(); }
+};
+
+// Managed memory Testcase classes
+
+// Host to device managed memory prefetch
+class HostToDevicePrefetchManaged: public Testcase {
+public:
+    HostToDevicePrefetchManaged() : Testcase("host_to_device_prefetch_managed",
+            "\tMeasures the bandwidth of hipMemPrefetchAsync_ migrating a managed buffer from host memory to each device.\n"
+            "\tThe buffer is prefetched in 4 KiB, 64 KiB and 2 MiB requests, with one matrix per request size.\n"
+            "\tPages are moved back to the host before every sample.") {}
+    virtual ~HostToDevicePrefetchManaged() {}
+    void run(unsigned long long size, unsigned long long loopCount);
+    unsigned int deviceBuffers() const { return 2; }
+    bool filter() { return Testcase::filterManagedMemory(); }
+};
+
+// Device to device managed memory prefetch
+class DeviceToDevicePrefetchManaged: public Testcase {
+public:
+    DeviceToDevicePrefetchManaged() : Testcase("device_to_device_prefetch_managed",
+            "\tMeasures the bandwidth of hipMemPrefetchAsync_ migrating a managed buffer resident on the row device to the column device.\n"
+            "\tThe buffer is prefetched in 4 KiB, 64 KiB and 2 MiB requests, with one matrix per request size.") {}
+    virtual ~DeviceToDevicePrefetchManaged() {}
+    void run(unsigned long long size, unsigned long long loopCount);
+    unsigned int deviceBuffers() const { return 2; }
+    bool filter() { return deviceCount > 1 && Testcase::filterManagedMemory(); }
+};
+
+// Host to device on demand managed memory migration
+class HostToDeviceFaultManagedSM: public Testcase {
+public:
+    HostToDeviceFaultManagedSM() : Testcase("host_to_device_fault_managed_sm",
+            "\tMeasures the throughput of page fault driven migration of a managed buffer from host memory to each device.\n"
+            "\tA kernel reads one word every 4 KiB, 64 KiB or 2 MiB, with one matrix per stride, and the whole buffer counts as migrated.\n"
+            "\tRequires devices that support on demand migration (XNACK).") {}
+    virtual ~HostToDeviceFaultManagedSM() {}
+    void run(unsigned long long size, unsigned long long loopCount);
+    unsigned int deviceBuffers() const { return 2; }
+    bool filter() { return Testcase::filterManagedPageFaults(); }
+};
+
+#ifdef MULTINODE
+// Multinode Testcase classes
+
+// Rank to rank device memcpy over MPI
+class MultinodeDeviceToDevice: public Testcase {
+public:
+    MultinodeDeviceToDevice() : Testcase("multinode_device_to_device_memcpy_mpi",
+            "\tMeasures the bandwidth of MPI copies from the device buffer of each rank to the device buffer of every other rank.\n"
+            "\tDevice buffers are passed to MPI directly when it is ROCm aware, otherwise copies are staged through pinned host memory.\n"
+            "\tBandwidth is measured on the receiving rank.") {}
+    virtual ~MultinodeDeviceToDevice() {}
+    void run(unsigned long long size, unsigned long long loopCount);
+    bool filter() { return worldSize > 1; }
+    bool isMultinode() { return true; }
+};
+
+// Bidirectional rank to rank device memcpy over MPI
+class MultinodeDeviceToDeviceBidir: public Testcase {
+public:
+    MultinodeDeviceToDeviceBidir() : Testcase("multinode_device_to_device_bidirectional_memcpy_mpi",
+            "\tA rank to rank MPI copy is measured while a copy in the opposite direction is run simultaneously.\n"
+            "\tOnly the row to column copy bandwidth is reported.") {}
+    virtual ~MultinodeDeviceToDeviceBidir() {}
+    void run(unsigned long long size, unsigned long long loopCount);
+    unsigned int deviceBuffers() const { return 2; }
+    bool filter() { return worldSize > 1; }
+    bool isMultinode() { return true; }
+};
+#endif
+
 #endif
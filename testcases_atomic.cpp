@@ -0,0 +1,103 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <hip/hip_runtime.h>
+#include "testcase.h"
+#include "memcpy.h"
+#include "output.h"
+
+static const std::vector<AtomicOp> atomicOps = {ATOMIC_ADD, ATOMIC_CAS};
+
+static bool hostNativeAtomics(int deviceId) {
+    int supported = 0;
+    CU_ASSERT(hipDeviceGetAttribute(&supported, hipDeviceAttributeHostNativeAtomicSupported, deviceId));
+    return supported;
+}
+
+static bool peerNativeAtomics(int srcDeviceId, int peerDeviceId) {
+    int supported = 0;
+    CU_ASSERT(hipDeviceGetP2PAttribute(&supported, hipDevP2PAttrNativeAtomicSupported, srcDeviceId, peerDeviceId));
+    return supported;
+}
+
+// Host buffers are always fine grained, coarse grained memory isn't coherent while the kernel runs
+void HostDeviceAtomicSM::run(unsigned long long size, unsigned long long loopCount) {
+    for (AtomicOp op : atomicOps) {
+        MemAtomicOperation atomicOp(loopCount, op);
+
+        // buffers are pooled, so every matrix leases the same host buffer again
+        for (int level = 0; level <= atomicContention.size(); level++) {
+            bool isLatency = level == atomicContention.size();
+            PeerValueMatrix<double> values(1, deviceCount, key);
+
+            for (int deviceId = 0; deviceId < deviceCount; deviceId++) {
+                if (!hostNativeAtomics(deviceId)) {
+                    continue;
+                }
+
+                HostNode hostNode(size, deviceId, HOST_MEM_COHERENT);
+
+                values.value(0, deviceId) = isLatency ? atomicOp.doAtomicLatency(deviceId, hostNode) :
+                                                        atomicOp.doAtomicThroughput(deviceId, hostNode, atomicContention[level]);
+            }
+
+            if (isLatency) {
+                output->addTestcaseResults(values, "atomic " + atomicOpNames[op] + " latency SM GPU(column) -> CPU(row) (ns)", Output::LOWER_IS_BETTER);
+            } else {
+                output->addTestcaseResults(values, "atomic " + atomicOpNames[op] + " SM GPU(column) -> CPU(row), " +
+                                           std::to_string(atomicContention[level]) + " threads per word (Mops/s)");
+            }
+        }
+    }
+}
+
+// The fine grained buffer lives in the peer's memory and the atomics run from the row device's context
+void DeviceToDeviceAtomicSM::run(unsigned long long size, unsigned long long loopCount) {
+    for (AtomicOp op : atomicOps) {
+        MemAtomicOperation atomicOp(loopCount, op);
+
+        for (int level = 0; level <= atomicContention.size(); level++) {
+            bool isLatency = level == atomicContention.size();
+            PeerValueMatrix<double> values(deviceCount, deviceCount, key);
+
+            for (int srcDeviceId = 0; srcDeviceId < deviceCount; srcDeviceId++) {
+                for (int peerDeviceId = 0; peerDeviceId < deviceCount; peerDeviceId++) {
+                    if (peerDeviceId == srcDeviceId || !peerNativeAtomics(srcDeviceId, peerDeviceId)) {
+                        continue;
+                    }
+
+                    DeviceNode srcNode(size, srcDeviceId);
+                    DeviceNode peerNode(size, peerDeviceId, true);
+
+                    if (!srcNode.enablePeerAcess(peerNode)) {
+                        continue;
+                    }
+
+                    values.value(srcDeviceId, peerDeviceId) = isLatency ? atomicOp.doAtomicLatency(srcDeviceId, peerNode) :
+                                                                          atomicOp.doAtomicThroughput(srcDeviceId, peerNode, atomicContention[level]);
+                }
+            }
+
+            if (isLatency) {
+                output->addTestcaseResults(values, "atomic " + atomicOpNames[op] + " latency SM GPU(row) -> GPU(column) (ns)", Output::LOWER_IS_BETTER);
+            } else {
+                output->addTestcaseResults(values, "atomic " + atomicOpNames[op] + " SM GPU(row) -> GPU(column), " +
+                                           std::to_string(atomicContention[level]) + " threads per word (Mops/s)");
+            }
+        }
+    }
+}
@@ -19,40 +19,40 @@
 
 #include "testcase.h"
 #include "memcpy.h"
+#include "numa.h"
+#include "output.h"
 
 void HostToDeviceCE::run(unsigned long long size, unsigned long long loopCount) {
     PeerValueMatrix<double> bandwidthValues(1, deviceCount, key);
-    MemcpyOperationCE memcpyInstance(loopCount);
+    std::unique_ptr<MemcpyOperation> memcpyInstance = createMemcpyOperationCE(loopCount);
 
     for (int deviceId = 0; deviceId < deviceCount; deviceId++) {
         HostNode hostNode(size, deviceId);
         DeviceNode deviceNode(size, deviceId);
 
-        bandwidthValues.value(0, deviceId) = memcpyInstance.doMemcpy(hostNode, deviceNode);
+        bandwidthValues.value(0, deviceId) = memcpyInstance->doMemcpy(hostNode, deviceNode);
     }
 
-    std::cout << "memcpy CE CPU(row) -> GPU(column) bandwidth (GB/s)" << std::endl;
-    std::cout << std::fixed << std::setprecision(2) << bandwidthValues << std::endl;
+    output->addTestcaseResults(bandwidthValues, "memcpy CE CPU(row) -> GPU(column) bandwidth (GB/s)");
 }
 
 void DeviceToHostCE::run(unsigned long long size, unsigned long long loopCount) {
     PeerValueMatrix<double> bandwidthValues(1, deviceCount, key);
-    MemcpyOperationCE memcpyInstance(loopCount);
+    std::unique_ptr<MemcpyOperation> memcpyInstance = createMemcpyOperationCE(loopCount);
 
     for (int deviceId = 0; deviceId < deviceCount; deviceId++) {
         HostNode hostNode(size, deviceId);
         DeviceNode deviceNode(size, deviceId);
 
-        bandwidthValues.value(0, deviceId) = memcpyInstance.doMemcpy(deviceNode, hostNode);
+        bandwidthValues.value(0, deviceId) = memcpyInstance->doMemcpy(deviceNode, hostNode);
     }
 
-    std::cout << "memcpy CE CPU(row) <- GPU(column) bandwidth (GB/s)" << std::endl;
-    std::cout << std::fixed << std::setprecision(2) << bandwidthValues << std::endl;
+    output->addTestcaseResults(bandwidthValues, "memcpy CE CPU(row) <- GPU(column) bandwidth (GB/s)");
 }
 
 void HostToDeviceBidirCE::run(unsigned long long size, unsigned long long loopCount) {
     PeerValueMatrix<double> bandwidthValues(1, deviceCount, key);
-    MemcpyOperationCE memcpyInstance(loopCount);
+    std::unique_ptr<MemcpyOperation> memcpyInstance = createMemcpyOperationCE(loopCount);
 
     for (int deviceId = 0; deviceId < deviceCount; deviceId++) {
         // Double the size of the interference copy to ensure it interferes correctly
@@ -62,16 +62,15 @@ void HostToDeviceBidirCE::run(unsigned long long size, unsigned long long loopCo
         std::vector<const MemcpyNode*> srcNodes = {&host1, &dev2};
         std::vector<const MemcpyNode*> dstNodes = {&dev1, &host2};
 
-        bandwidthValues.value(0, deviceId) = memcpyInstance.doMemcpy(srcNodes, dstNodes);
+        bandwidthValues.value(0, deviceId) = memcpyInstance->doMemcpy(srcNodes, dstNodes);
     }
 
-    std::cout << "memcpy CE CPU(row) <-> GPU(column) bandwidth (GB/s)" << std::endl;
-    std::cout << std::fixed << std::setprecision(2) << bandwidthValues << std::endl;
+    output->addTestcaseResults(bandwidthValues, "memcpy CE CPU(row) <-> GPU(column) bandwidth (GB/s)");
 }
 
 void DeviceToHostBidirCE::run(unsigned long long size, unsigned long long loopCount) {
     PeerValueMatrix<double> bandwidthValues(1, deviceCount, key);
-    MemcpyOperationCE memcpyInstance(loopCount);
+    std::unique_ptr<MemcpyOperation> memcpyInstance = createMemcpyOperationCE(loopCount);
 
     for (int deviceId = 0; deviceId < deviceCount; deviceId++) {
         // Double the size of the interference copy to ensure it interferes correctly
@@ -81,17 +80,16 @@ void DeviceToHostBidirCE::run(unsigned long long size, unsigned long long loopCo
         std::vector<const MemcpyNode*> srcNodes = {&dev1, &host2};
         std::vector<const MemcpyNode*> dstNodes = {&host1, &dev2};
 
-        bandwidthValues.value(0, deviceId) = memcpyInstance.doMemcpy(srcNodes, dstNodes);
+        bandwidthValues.value(0, deviceId) = memcpyInstance->doMemcpy(srcNodes, dstNodes);
     }
 
-    std::cout << "memcpy CE CPU(row) <-> GPU(column) bandwidth (GB/s)" << std::endl;
-    std::cout << std::fixed << std::setprecision(2) << bandwidthValues << std::endl;
+    output->addTestcaseResults(bandwidthValues, "memcpy CE CPU(row) <-> GPU(column) bandwidth (GB/s)");
 }
 
 // DtoD Read test - copy from dst to src (backwards) using src contxt
 void DeviceToDeviceReadCE::run(unsigned long long size, unsigned long long loopCount) {
     PeerValueMatrix<double> bandwidthValues(deviceCount, deviceCount, key);
-    MemcpyOperationCE memcpyInstance(loopCount, MemcpyOperation::PREFER_DST_CONTEXT);
+    std::unique_ptr<MemcpyOperation> memcpyInstance = createMemcpyOperationCE(loopCount, MemcpyOperation::PREFER_DST_CONTEXT);
 
     for (int srcDeviceId = 0; srcDeviceId < deviceCount; srcDeviceId++) {
         for (int peerDeviceId = 0; peerDeviceId < deviceCount; peerDeviceId++) {
@@ -107,18 +105,17 @@ void DeviceToDeviceReadCE::run(unsigned long long size, unsigned long long loopC
             }
 
             // swap src and peer nodes, but use srcNodes (the copy's destination) context
-            bandwidthValues.value(srcDeviceId, peerDeviceId) = memcpyInstance.doMemcpy(peerNode, srcNode);
+            bandwidthValues.value(srcDeviceId, peerDeviceId) = memcpyInstance->doMemcpy(peerNode, srcNode);
         }
     }
 
-    std::cout << "memcpy CE GPU(row) -> GPU(column) bandwidth (GB/s)" << std::endl;
-    std::cout << std::fixed << std::setprecision(2) << bandwidthValues << std::endl;
+    output->addTestcaseResults(bandwidthValues, "memcpy CE GPU(row) -> GPU(column) bandwidth (GB/s)");
 }
 
 // DtoD Write test - copy from src to dst using src context
 void DeviceToDeviceWriteCE::run(unsigned long long size, unsigned long long loopCount) {
     PeerValueMatrix<double> bandwidthValues(deviceCount, deviceCount, key);
-    MemcpyOperationCE memcpyInstance(loopCount);
+    std::unique_ptr<MemcpyOperation> memcpyInstance = createMemcpyOperationCE(loopCount);
 
     for (int srcDeviceId = 0; srcDeviceId < deviceCount; srcDeviceId++) {
         for (int peerDeviceId = 0; peerDeviceId < deviceCount; peerDeviceId++) {
@@ -133,18 +130,17 @@ void DeviceToDeviceWriteCE::run(unsigned long long size, unsigned long long loop
                 continue;
             }
 
-            bandwidthValues.value(srcDeviceId, peerDeviceId) = memcpyInstance.doMemcpy(srcNode, peerNode);
+            bandwidthValues.value(srcDeviceId, peerDeviceId) = memcpyInstance->doMemcpy(srcNode, peerNode);
         }
     }
 
-    std::cout << "memcpy CE GPU(row) <- GPU(column) bandwidth (GB/s)" << std::endl;
-    std::cout << std::fixed << std::setprecision(2) << bandwidthValues << std::endl;
+    output->addTestcaseResults(bandwidthValues, "memcpy CE GPU(row) <- GPU(column) bandwidth (GB/s)");
 }
 
 // DtoD Bidir Read test - copy from dst to src (backwards) using src contxt
 void DeviceToDeviceBidirReadCE::run(unsigned long long size, unsigned long long loopCount) {
     PeerValueMatrix<double> bandwidthValues(deviceCount, deviceCount, key);
-    MemcpyOperationCE memcpyInstance(loopCount, MemcpyOperation::PREFER_DST_CONTEXT);
+    std::unique_ptr<MemcpyOperation> memcpyInstance = createMemcpyOperationCE(loopCount, MemcpyOperation::PREFER_DST_CONTEXT);
 
     for (int srcDeviceId = 0; srcDeviceId < deviceCount; srcDeviceId++) {
         for (int peerDeviceId = 0; peerDeviceId < deviceCount; peerDeviceId++) {
@@ -164,18 +160,17 @@ void DeviceToDeviceBidirReadCE::run(unsigned long long size, unsigned long long
             std::vector<const MemcpyNode*> srcNodes = {&peer1, &src2};
             std::vector<const MemcpyNode*> peerNodes = {&src1, &peer2};
 
-            bandwidthValues.value(srcDeviceId, peerDeviceId) = memcpyInstance.doMemcpy(srcNodes, peerNodes);
+            bandwidthValues.value(srcDeviceId, peerDeviceId) = memcpyInstance->doMemcpy(srcNodes, peerNodes);
         }
     }
 
-    std::cout << "memcpy CE GPU(row) <-> GPU(column) bandwidth (GB/s)" << std::endl;
-    std::cout << std::fixed << std::setprecision(2) << bandwidthValues << std::endl;
+    output->addTestcaseResults(bandwidthValues, "memcpy CE GPU(row) <-> GPU(column) bandwidth (GB/s)");
 }
 
 // DtoD Bidir Write test - copy from src to dst using src context
 void DeviceToDeviceBidirWriteCE::run(unsigned long long size, unsigned long long loopCount) {
     PeerValueMatrix<double> bandwidthValues(deviceCount, deviceCount, key);
-    MemcpyOperationCE memcpyInstance(loopCount);
+    std::unique_ptr<MemcpyOperation> memcpyInstance = createMemcpyOperationCE(loopCount);
 
     for (int srcDeviceId = 0; srcDeviceId < deviceCount; srcDeviceId++) {
         for (int peerDeviceId = 0; peerDeviceId < deviceCount; peerDeviceId++) {
@@ -194,90 +189,185 @@ void DeviceToDeviceBidirWriteCE::run(unsigned long long size, unsigned long long
             std::vector<const MemcpyNode*> srcNodes = {&src1, &peer2};
             std::vector<const MemcpyNode*> peerNodes = {&peer1, &src2};
 
-            bandwidthValues.value(srcDeviceId, peerDeviceId) = memcpyInstance.doMemcpy(srcNodes, peerNodes);
+            bandwidthValues.value(srcDeviceId, peerDeviceId) = memcpyInstance->doMemcpy(srcNodes, peerNodes);
         }
     }
 
-    std::cout << "memcpy CE GPU(row) <-> GPU(column) bandwidth (GB/s)" << std::endl;
-    std::cout << std::fixed << std::setprecision(2) << bandwidthValues << std::endl;
+    output->addTestcaseResults(bandwidthValues, "memcpy CE GPU(row) <-> GPU(column) bandwidth (GB/s)");
 }
 
 void AllToHostCE::run(unsigned long long size, unsigned long long loopCount) {
     PeerValueMatrix<double> bandwidthValues(1, deviceCount, key);
-    MemcpyOperationCE memcpyInstance(loopCount);
+    std::unique_ptr<MemcpyOperation> memcpyInstance = createMemcpyOperationCE(loopCount);
 
-    allHostHelper(size, memcpyInstance, bandwidthValues, false);
+    allHostHelper(size, *memcpyInstance, bandwidthValues, false);
 
-    std::cout << "memcpy CE CPU(row) <- GPU(column) bandwidth (GB/s)" << std::endl;
-    std::cout << std::fixed << std::setprecision(2) << bandwidthValues << std::endl;
+    output->addTestcaseResults(bandwidthValues, "memcpy CE CPU(row) <- GPU(column) bandwidth (GB/s)");
 }
 
 void AllToHostBidirCE::run(unsigned long long size, unsigned long long loopCount) {
     PeerValueMatrix<double> bandwidthValues(1, deviceCount, key);
-    MemcpyOperationCE memcpyInstance(loopCount);
+    std::unique_ptr<MemcpyOperation> memcpyInstance = createMemcpyOperationCE(loopCount);
 
-    allHostBidirHelper(size, memcpyInstance, bandwidthValues, false);
+    allHostBidirHelper(size, *memcpyInstance, bandwidthValues, false);
 
-    std::cout << "memcpy CE CPU(row) <- GPU(column) bandwidth (GB/s)" << std::endl;
-    std::cout << std::fixed << std::setprecision(2) << bandwidthValues << std::endl;
+    output->addTestcaseResults(bandwidthValues, "memcpy CE CPU(row) <- GPU(column) bandwidth (GB/s)");
 }
 
 void HostToAllCE::run(unsigned long long size, unsigned long long loopCount) {
     PeerValueMatrix<double> bandwidthValues(1, deviceCount, key);
-    MemcpyOperationCE memcpyInstance(loopCount);
+    std::unique_ptr<MemcpyOperation> memcpyInstance = createMemcpyOperationCE(loopCount);
 
-    allHostHelper(size, memcpyInstance, bandwidthValues, true);
+    allHostHelper(size, *memcpyInstance, bandwidthValues, true);
 
-    std::cout << "memcpy CE CPU(row) -> GPU(column) bandwidth (GB/s)" << std::endl;
-    std::cout << std::fixed << std::setprecision(2) << bandwidthValues << std::endl;
+    output->addTestcaseResults(bandwidthValues, "memcpy CE CPU(row) -> GPU(column) bandwidth (GB/s)");
 }
 
 void HostToAllBidirCE::run(unsigned long long size, unsigned long long loopCount) {
     PeerValueMatrix<double> bandwidthValues(1, deviceCount, key);
-    MemcpyOperationCE memcpyInstance(loopCount);
+    std::unique_ptr<MemcpyOperation> memcpyInstance = createMemcpyOperationCE(loopCount);
 
-    allHostBidirHelper(size, memcpyInstance, bandwidthValues, true);
+    allHostBidirHelper(size, *memcpyInstance, bandwidthValues, true);
 
-    std::cout << "memcpy CE CPU(row) <- GPU(column) bandwidth (GB/s)" << std::endl;
-    std::cout << std::fixed << std::setprecision(2) << bandwidthValues << std::endl;
+    output->addTestcaseResults(bandwidthValues, "memcpy CE CPU(row) <- GPU(column) bandwidth (GB/s)");
 }
 
 // Write test - copy from src to dst using src context
 void AllToOneWriteCE::run(unsigned long long size, unsigned long long loopCount) {
     PeerValueMatrix<double> bandwidthValues(1, deviceCount, key);
-    MemcpyOperationCE memcpyInstance(loopCount, MemcpyOperation::PREFER_SRC_CONTEXT, MemcpyOperation::TOTAL_BW);
-    allToOneHelper(size, memcpyInstance, bandwidthValues, false);
+    std::unique_ptr<MemcpyOperation> memcpyInstance = createMemcpyOperationCE(loopCount, MemcpyOperation::PREFER_SRC_CONTEXT, MemcpyOperation::TOTAL_BW);
+    allToOneHelper(size, *memcpyInstance, bandwidthValues, false);
 
-    std::cout << "memcpy CE All Gpus -> GPU(column) total bandwidth (GB/s)" << std::endl;
-    std::cout << std::fixed << std::setprecision(2) << bandwidthValues << std::endl;
+    output->addTestcaseResults(bandwidthValues, "memcpy CE All Gpus -> GPU(column) total bandwidth (GB/s)");
 }
 
 // Read test - copy from dst to src (backwards) using src contxt
 void AllToOneReadCE::run(unsigned long long size, unsigned long long loopCount) {
     PeerValueMatrix<double> bandwidthValues(1, deviceCount, key);
-    MemcpyOperationCE memcpyInstance(loopCount, MemcpyOperation::PREFER_DST_CONTEXT, MemcpyOperation::TOTAL_BW);
-    allToOneHelper(size, memcpyInstance, bandwidthValues, true);
+    std::unique_ptr<MemcpyOperation> memcpyInstance = createMemcpyOperationCE(loopCount, MemcpyOperation::PREFER_DST_CONTEXT, MemcpyOperation::TOTAL_BW);
+    allToOneHelper(size, *memcpyInstance, bandwidthValues, true);
 
-    std::cout << "memcpy CE All Gpus <- GPU(column) total bandwidth (GB/s)" << std::endl;
-    std::cout << std::fixed << std::setprecision(2) << bandwidthValues << std::endl;
+    output->addTestcaseResults(bandwidthValues, "memcpy CE All Gpus <- GPU(column) total bandwidth (GB/s)");
 }
 
 // Write test - copy from src to dst using src context
 void OneToAllWriteCE::run(unsigned long long size, unsigned long long loopCount) {
     PeerValueMatrix<double> bandwidthValues(1, deviceCount, key);
-    MemcpyOperationCE memcpyInstance(loopCount, MemcpyOperation::PREFER_SRC_CONTEXT, MemcpyOperation::TOTAL_BW);
-    oneToAllHelper(size, memcpyInstance, bandwidthValues, false);
+    std::unique_ptr<MemcpyOperation> memcpyInstance = createMemcpyOperationCE(loopCount, MemcpyOperation::PREFER_SRC_CONTEXT, MemcpyOperation::TOTAL_BW);
+    oneToAllHelper(size, *memcpyInstance, bandwidthValues, false);
 
-    std::cout << "memcpy CE GPU(column) -> All GPUs total bandwidth (GB/s)" << std::endl;
-    std::cout << std::fixed << std::setprecision(2) << bandwidthValues << std::endl;
+    output->addTestcaseResults(bandwidthValues, "memcpy CE GPU(column) -> All GPUs total bandwidth (GB/s)");
 }
 
 // Read test - copy from dst to src (backwards) using src contxt
 void OneToAllReadCE::run(unsigned long long size, unsigned long long loopCount) {
     PeerValueMatrix<double> bandwidthValues(1, deviceCount, key);
-    MemcpyOperationCE memcpyInstance(loopCount, MemcpyOperation::PREFER_DST_CONTEXT, MemcpyOperation::TOTAL_BW);
-    oneToAllHelper(size, memcpyInstance, bandwidthValues, true);
+    std::unique_ptr<MemcpyOperation> memcpyInstance = createMemcpyOperationCE(loopCount, MemcpyOperation::PREFER_DST_CONTEXT, MemcpyOperation::TOTAL_BW);
+    oneToAllHelper(size, *memcpyInstance, bandwidthValues, true);
 
-    std::cout << "memcpy CE GPU(column) <- All GPUs total bandwidth (GB/s)" << std::endl;
-    std::cout << std::fixed << std::setprecision(2) << bandwidthValues << std::endl;
+    output->addTestcaseResults(bandwidthValues, "memcpy CE GPU(column) <- All GPUs total bandwidth (GB/s)");
+}
+
+// Write test - copy from src to dst using src context
+void AllToAllCE::run(unsigned long long size, unsigned long long loopCount) {
+    PeerValueMatrix<double> linkBandwidthValues(deviceCount, deviceCount, key);
+    PeerValueMatrix<double> totalBandwidthValues(1, 1, key);
+    std::unique_ptr<MemcpyOperation> memcpyInstance = createMemcpyOperationCE(loopCount, MemcpyOperation::PREFER_SRC_CONTEXT, MemcpyOperation::TOTAL_BW);
+    allToAllHelper(size, *memcpyInstance, linkBandwidthValues, totalBandwidthValues);
+
+    output->addTestcaseResults(linkBandwidthValues, "memcpy CE GPU(row) -> GPU(column) per link bandwidth during all to all (GB/s)");
+    output->addTestcaseResults(totalBandwidthValues, "memcpy CE All GPUs -> All GPUs total bandwidth (GB/s)");
+}
+
+void HostNumaToDeviceCE::run(unsigned long long size, unsigned long long loopCount) {
+    const std::vector<int> &numaNodes = getNumaNodes();
+    // node ids can have gaps, rows are labeled with them
+    PeerValueMatrix<double> bandwidthValues(numaNodes.size(), deviceCount, key);
+    std::unique_ptr<MemcpyOperation> memcpyInstance = createMemcpyOperationCE(loopCount);
+    // the host nodes bind this thread to the CPUs of their NUMA node
+    NumaBindingReset bindingReset;
+
+    for (int row = 0; row < numaNodes.size(); row++) {
+        bandwidthValues.rowLabels.push_back(std::to_string(numaNodes[row]));
+        for (int deviceId = 0; deviceId < deviceCount; deviceId++) {
+            HostNode hostNode(size, deviceId, hostMemType, numaNodes[row]);
+            DeviceNode deviceNode(size, deviceId);
+
+            bandwidthValues.value(row, deviceId) = memcpyInstance->doMemcpy(hostNode, deviceNode);
+        }
+    }
+
+    output->addTestcaseResults(bandwidthValues, "memcpy CE CPU NUMA node(row) -> GPU(column) bandwidth (GB/s)");
+}
+
+// Rows are labeled with their number of streams
+static void labelStreamRows(PeerValueMatrix<double> &bandwidthValues) {
+    for (unsigned int streams = 1; streams <= maxStreams; streams++) {
+        bandwidthValues.rowLabels.push_back(std::to_string(streams));
+    }
+}
+
+void HostToDeviceStreamScalingCE::run(unsigned long long size, unsigned long long loopCount) {
+    PeerValueMatrix<double> bandwidthValues(maxStreams, deviceCount, key);
+    std::unique_ptr<MemcpyOperation> memcpyInstance = createMemcpyOperationCE(loopCount, MemcpyOperation::PREFER_SRC_CONTEXT, MemcpyOperation::TOTAL_BW);
+    labelStreamRows(bandwidthValues);
+
+    for (int deviceId = 0; deviceId < deviceCount; deviceId++) {
+        streamScalingHelper(*memcpyInstance, bandwidthValues, deviceId, [&]() {
+            return std::make_pair<const MemcpyNode*, const MemcpyNode*>(new HostNode(size, deviceId), new DeviceNode(size, deviceId));
+        });
+    }
+
+    output->addTestcaseResults(bandwidthValues, "memcpy CE CPU -> GPU(column) total bandwidth with streams(row) concurrent copies (GB/s)");
+}
+
+void DeviceToHostStreamScalingCE::run(unsigned long long size, unsigned long long loopCount) {
+    PeerValueMatrix<double> bandwidthValues(maxStreams, deviceCount, key);
+    std::unique_ptr<MemcpyOperation> memcpyInstance = createMemcpyOperationCE(loopCount, MemcpyOperation::PREFER_SRC_CONTEXT, MemcpyOperation::TOTAL_BW);
+    labelStreamRows(bandwidthValues);
+
+    for (int deviceId = 0; deviceId < deviceCount; deviceId++) {
+        streamScalingHelper(*memcpyInstance, bandwidthValues, deviceId, [&]() {
+            return std::make_pair<const MemcpyNode*, const MemcpyNode*>(new DeviceNode(size, deviceId), new HostNode(size, deviceId));
+        });
+    }
+
+    output->addTestcaseResults(bandwidthValues, "memcpy CE CPU <- GPU(column) total bandwidth with streams(row) concurrent copies (GB/s)");
+}
+
+void DeviceToDeviceStreamScalingCE::run(unsigned long long size, unsigned long long loopCount) {
+    PeerValueMatrix<double> bandwidthValues(maxStreams, deviceCount, key);
+    std::unique_ptr<MemcpyOperation> memcpyInstance = createMemcpyOperationCE(loopCount, MemcpyOperation::PREFER_SRC_CONTEXT, MemcpyOperation::TOTAL_BW);
+    labelStreamRows(bandwidthValues);
+
+    for (int srcDeviceId = 0; srcDeviceId < deviceCount; srcDeviceId++) {
+        // the first accessible peer after the source, wrapping around
+        int peerDeviceId = -1;
+        for (int offset = 1; offset < deviceCount && peerDeviceId < 0; offset++) {
+            int candidate = (srcDeviceId + offset) % deviceCount;
+            DeviceNode srcNode(size, srcDeviceId);
+            DeviceNode peerNode(size, candidate);
+            if (srcNode.enablePeerAcess(peerNode)) {
+                peerDeviceId = candidate;
+            }
+        }
+        if (peerDeviceId < 0) {
+            continue;
+        }
+
+        std::cout << "\tGPU " << srcDeviceId << " -> GPU " << peerDeviceId << std::endl;
+        streamScalingHelper(*memcpyInstance, bandwidthValues, srcDeviceId, [&]() {
+            return std::make_pair<const MemcpyNode*, const MemcpyNode*>(new DeviceNode(size, srcDeviceId), new DeviceNode(size, peerDeviceId));
+        });
+    }
+
+    output->addTestcaseResults(bandwidthValues, "memcpy CE GPU(column) -> next peer total bandwidth with streams(row) concurrent copies (GB/s)");
+}
+
+void HostToDevicePipelinedCE::run(unsigned long long size, unsigned long long loopCount) {
+    pipelinedHelper(size, loopCount, true);
+}
+
+void DeviceToHostPipelinedCE::run(unsigned long long size, unsigned long long loopCount) {
+    pipelinedHelper(size, loopCount, false);
 }
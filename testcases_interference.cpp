@@ -0,0 +1,81 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <hip/hip_runtime.h>
+#include "testcase.h"
+#include "memcpy.h"
+#include "output.h"
+
+// Row 0 of the bandwidth matrix is the copy on the idle device, the following rows the copy next to each background load
+static void underLoadHelper(const std::string &key, unsigned long long size, MemcpyOperation &memcpyInstance, const std::string &copyName) {
+    PeerValueMatrix<double> bandwidthValues(backgroundLoads.size() + 1, deviceCount, key);
+    PeerValueMatrix<double> copySlowdownValues(backgroundLoads.size(), deviceCount, key);
+    PeerValueMatrix<double> loadSlowdownValues(backgroundLoads.size(), deviceCount, key);
+    bandwidthValues.rowLabels.push_back("idle");
+    for (BackgroundLoadType type : backgroundLoads) {
+        bandwidthValues.rowLabels.push_back(backgroundLoadNames[type]);
+    }
+    copySlowdownValues.rowLabels.assign(bandwidthValues.rowLabels.begin() + 1, bandwidthValues.rowLabels.end());
+    loadSlowdownValues.rowLabels = copySlowdownValues.rowLabels;
+
+    for (int deviceId = 0; deviceId < deviceCount; deviceId++) {
+        HostNode hostNode(size, deviceId);
+        DeviceNode deviceNode(size, deviceId);
+
+        double idleBandwidth = memcpyInstance.doMemcpy(hostNode, deviceNode);
+        bandwidthValues.value(0, deviceId) = idleBandwidth;
+
+        for (int row = 0; row < backgroundLoads.size(); row++) {
+            BackgroundLoad load(backgroundLoads[row], deviceId);
+
+            memcpyInstance.setBackgroundLoad(&load);
+            double loadedBandwidth = memcpyInstance.doMemcpy(hostNode, deviceNode);
+            memcpyInstance.setBackgroundLoad(nullptr);
+            double loadedRate = load.getRate();
+
+            // the load alone runs as long as it ran next to the copies
+            double loadedSeconds = load.getSeconds();
+            load.reset();
+            load.runAlone(loadedSeconds);
+
+            bandwidthValues.value(row + 1, deviceId) = loadedBandwidth;
+            if (idleBandwidth > 0.0) {
+                copySlowdownValues.value(row, deviceId) = loadedBandwidth / idleBandwidth * 100.0;
+            }
+            if (load.getRate() > 0.0) {
+                loadSlowdownValues.value(row, deviceId) = loadedRate / load.getRate() * 100.0;
+            }
+            VERBOSE << "\t" << backgroundLoadNames[backgroundLoads[row]] << " load on device " << deviceId << ": " << std::fixed << std::setprecision(2)
+                    << loadedRate << " units/s next to the copies, " << load.getRate() << " units/s alone\n";
+        }
+    }
+
+    output->addTestcaseResults(bandwidthValues, "memcpy " + copyName + " CPU -> GPU(column) bandwidth with background load(row) (GB/s)");
+    output->addTestcaseResults(copySlowdownValues, "memcpy " + copyName + " CPU -> GPU(column) bandwidth with background load(row), relative to idle (%)");
+    output->addTestcaseResults(loadSlowdownValues, "background load(row) throughput on GPU(column) during memcpy " + copyName + " copies, relative to alone (%)");
+}
+
+void HostToDeviceUnderLoadCE::run(unsigned long long size, unsigned long long loopCount) {
+    std::unique_ptr<MemcpyOperation> memcpyInstance = createMemcpyOperationCE(loopCount);
+    underLoadHelper(key, size, *memcpyInstance, "CE");
+}
+
+void HostToDeviceUnderLoadSM::run(unsigned long long size, unsigned long long loopCount) {
+    MemcpyOperationSM memcpyInstance(loopCount);
+    underLoadHelper(key, size, memcpyInstance, "SM");
+}
@@ -0,0 +1,74 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <hip/hip_runtime.h>
+#include "testcase.h"
+#include "memcpy.h"
+#include "output.h"
+
+void HostDeviceLatencySM::run(unsigned long long size, unsigned long long loopCount) {
+    PeerValueMatrix<double> latencyValues(1, deviceCount, key);
+    MemPtrChaseOperation ptrChaseOp(loopCount);
+
+    for (int deviceId = 0; deviceId < deviceCount; deviceId++) {
+        HostNode hostNode(size, deviceId);
+
+        latencyValues.value(0, deviceId) = ptrChaseOp.doPtrChase(deviceId, hostNode);
+    }
+
+    output->addTestcaseResults(latencyValues, "memory latency SM CPU(row) <-> GPU(column) (ns)", Output::LOWER_IS_BETTER);
+}
+
+// The chain lives in the peer's memory and is chased from the row device's context
+void DeviceToDeviceLatencySM::run(unsigned long long size, unsigned long long loopCount) {
+    PeerValueMatrix<double> latencyValues(deviceCount, deviceCount, key);
+    MemPtrChaseOperation ptrChaseOp(loopCount);
+
+    for (int srcDeviceId = 0; srcDeviceId < deviceCount; srcDeviceId++) {
+        for (int peerDeviceId = 0; peerDeviceId < deviceCount; peerDeviceId++) {
+            if (peerDeviceId == srcDeviceId) {
+                continue;
+            }
+
+            DeviceNode srcNode(size, srcDeviceId);
+            DeviceNode peerNode(size, peerDeviceId);
+
+            if (!srcNode.enablePeerAcess(peerNode)) {
+                continue;
+            }
+
+            latencyValues.value(srcDeviceId, peerDeviceId) = ptrChaseOp.doPtrChase(srcDeviceId, peerNode);
+        }
+    }
+
+    output->addTestcaseResults(latencyValues, "memory latency SM GPU(row) -> GPU(column) (ns)", Output::LOWER_IS_BETTER);
+}
+
+void HostDeviceLatencyCE::run(unsigned long long size, unsigned long long loopCount) {
+    PeerValueMatrix<double> latencyValues(1, deviceCount, key);
+    MemcpyRoundTripOperationCE roundTripOp(loopCount);
+
+    for (int deviceId = 0; deviceId < deviceCount; deviceId++) {
+        HostNode hostNode(size, deviceId);
+        DeviceNode deviceNode(size, deviceId);
+
+        latencyValues.value(0, deviceId) = roundTripOp.doRoundTrip(hostNode, deviceNode);
+    }
+
+    output->addTestcaseResults(latencyValues, "memcpy CE CPU(row) <-> GPU(column) round trip latency (ns)", Output::LOWER_IS_BETTER);
+}
@@ -0,0 +1,83 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <hip/hip_runtime.h>
+#include "testcase.h"
+#include "memcpy.h"
+#include "output.h"
+
+// Migration granularities reported by the managed memory testcases: base pages, large fragments and huge pages
+static const std::vector<size_t> managedPageSizes = {4 * 1024, 64 * 1024, 2 * _MiB};
+
+static std::string pageSizeString(size_t pageSize) {
+    return pageSize >= _MiB ? std::to_string(pageSize / _MiB) + " MiB" : std::to_string(pageSize / 1024) + " KiB";
+}
+
+void HostToDevicePrefetchManaged::run(unsigned long long size, unsigned long long loopCount) {
+    for (size_t pageSize : managedPageSizes) {
+        PeerValueMatrix<double> bandwidthValues(1, deviceCount, key);
+        MemcpyOperationPrefetch memcpyInstance(loopCount, pageSize);
+
+        for (int deviceId = 0; deviceId < deviceCount; deviceId++) {
+            ManagedNode managedNode(size, hipCpuDeviceId, deviceId);
+            DeviceNode deviceNode(size, deviceId);
+
+            bandwidthValues.value(0, deviceId) = memcpyInstance.doMemcpy(managedNode, deviceNode);
+        }
+
+        output->addTestcaseResults(bandwidthValues, "managed prefetch CPU(row) -> GPU(column) bandwidth, " + pageSizeString(pageSize) + " prefetches (GB/s)");
+    }
+}
+
+void DeviceToDevicePrefetchManaged::run(unsigned long long size, unsigned long long loopCount) {
+    for (size_t pageSize : managedPageSizes) {
+        PeerValueMatrix<double> bandwidthValues(deviceCount, deviceCount, key);
+        MemcpyOperationPrefetch memcpyInstance(loopCount, pageSize);
+
+        for (int srcDeviceId = 0; srcDeviceId < deviceCount; srcDeviceId++) {
+            for (int dstDeviceId = 0; dstDeviceId < deviceCount; dstDeviceId++) {
+                if (srcDeviceId == dstDeviceId) {
+                    continue;
+                }
+
+                ManagedNode managedNode(size, srcDeviceId, dstDeviceId);
+                DeviceNode deviceNode(size, dstDeviceId);
+
+                bandwidthValues.value(srcDeviceId, dstDeviceId) = memcpyInstance.doMemcpy(managedNode, deviceNode);
+            }
+        }
+
+        output->addTestcaseResults(bandwidthValues, "managed prefetch GPU(row) -> GPU(column) bandwidth, " + pageSizeString(pageSize) + " prefetches (GB/s)");
+    }
+}
+
+void HostToDeviceFaultManagedSM::run(unsigned long long size, unsigned long long loopCount) {
+    for (size_t pageSize : managedPageSizes) {
+        PeerValueMatrix<double> bandwidthValues(1, deviceCount, key);
+        MemcpyOperationPageFault memcpyInstance(loopCount, pageSize);
+
+        for (int deviceId = 0; deviceId < deviceCount; deviceId++) {
+            ManagedNode managedNode(size, hipCpuDeviceId, deviceId);
+            DeviceNode deviceNode(size, deviceId);
+
+            bandwidthValues.value(0, deviceId) = memcpyInstance.doMemcpy(managedNode, deviceNode);
+        }
+
+        output->addTestcaseResults(bandwidthValues, "managed page fault migration CPU(row) -> GPU(column) bandwidth, one touch per " + pageSizeString(pageSize) + " (GB/s)");
+    }
+}
@@ -0,0 +1,58 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef MULTINODE
+
+#include <hip/hip_runtime.h>
+#include "testcase.h"
+#include "memcpy.h"
+#include "multinode.h"
+#include "output.h"
+
+// Each rank copies its device buffer to every other rank's, one pair at a time
+static void multinodeHelper(unsigned long long size, MultinodeMemcpyOperation &memcpyInstance, PeerValueMatrix<double> &bandwidthValues) {
+    DeviceNode deviceNode(size, localDevice);
+
+    for (int srcRank = 0; srcRank < worldSize; srcRank++) {
+        for (int dstRank = 0; dstRank < worldSize; dstRank++) {
+            if (srcRank == dstRank) {
+                continue;
+            }
+            bandwidthValues.value(srcRank, dstRank) = memcpyInstance.doMemcpy(srcRank, dstRank, deviceNode);
+        }
+    }
+}
+
+void MultinodeDeviceToDevice::run(unsigned long long size, unsigned long long loopCount) {
+    PeerValueMatrix<double> bandwidthValues(worldSize, worldSize, key);
+    MultinodeMemcpyOperation memcpyInstance(loopCount);
+
+    multinodeHelper(size, memcpyInstance, bandwidthValues);
+
+    output->addTestcaseResults(bandwidthValues, std::string("MPI ") + (mpiDeviceAware ? "device" : "staged") + " memcpy rank(row) -> rank(column) bandwidth (GB/s)");
+}
+
+void MultinodeDeviceToDeviceBidir::run(unsigned long long size, unsigned long long loopCount) {
+    PeerValueMatrix<double> bandwidthValues(worldSize, worldSize, key);
+    MultinodeMemcpyOperation memcpyInstance(loopCount, true);
+
+    multinodeHelper(size, memcpyInstance, bandwidthValues);
+
+    output->addTestcaseResults(bandwidthValues, std::string("MPI ") + (mpiDeviceAware ? "device" : "staged") + " bidirectional memcpy rank(row) -> rank(column) bandwidth (GB/s)");
+}
+
+#endif // MULTINODE
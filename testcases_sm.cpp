@@ -20,6 +20,7 @@
 #include "testcase.h"
 #include "kernels.h"
 #include "memcpy.h"
+#include "output.h"
 
 void HostToDeviceSM::run(unsigned long long size, unsigned long long loopCount) {
     PeerValueMatrix<double> bandwidthValues(1, deviceCount, key);
@@ -32,8 +33,7 @@ void HostToDeviceSM::run(unsigned long long size, unsigned long long loopCount)
         bandwidthValues.value(0, deviceId) = memcpyInstance.doMemcpy(hostNode, deviceNode);
     }
 
-    std::cout << "memcpy SM CPU(row) -> GPU(column) bandwidth (GB/s)" << std::endl;
-    std::cout << std::fixed << std::setprecision(2) << bandwidthValues << std::endl;
+    output->addTestcaseResults(bandwidthValues, "memcpy SM CPU(row) -> GPU(column) bandwidth (GB/s)");
 }
 
 void DeviceToHostSM::run(unsigned long long size, unsigned long long loopCount) {
@@ -47,8 +47,7 @@ void DeviceToHostSM::run(unsigned long long size, unsigned long long loopCount)
         bandwidthValues.value(0, deviceId) = memcpyInstance.doMemcpy(deviceNode, hostNode);
     }
 
-    std::cout << "memcpy SM CPU(row) <- GPU(column) bandwidth (GB/s)" << std::endl;
-    std::cout << std::fixed << std::setprecision(2) << bandwidthValues << std::endl;
+    output->addTestcaseResults(bandwidthValues, "memcpy SM CPU(row) <- GPU(column) bandwidth (GB/s)");
 }
 
 // DtoD Read test - copy from dst to src (backwards) using src contxt
@@ -74,8 +73,7 @@ void DeviceToDeviceReadSM::run(unsigned long long size, unsigned long long loopC
         }
     }
 
-    std::cout << "memcpy CE GPU(row) -> GPU(column) bandwidth (GB/s)" << std::endl;
-    std::cout << std::fixed << std::setprecision(2) << bandwidthValues << std::endl;
+    output->addTestcaseResults(bandwidthValues, "memcpy CE GPU(row) -> GPU(column) bandwidth (GB/s)");
 }
 
 // DtoD Write test - copy from src to dst using src context
@@ -100,8 +98,7 @@ void DeviceToDeviceWriteSM::run(unsigned long long size, unsigned long long loop
         }
     }
 
-    std::cout << "memcpy SM GPU(row) <- GPU(column) bandwidth (GB/s)" << std::endl;
-    std::cout << std::fixed << std::setprecision(2) << bandwidthValues << std::endl;
+    output->addTestcaseResults(bandwidthValues, "memcpy SM GPU(row) <- GPU(column) bandwidth (GB/s)");
 }
 
 // DtoD Bidir Read test - copy from dst to src (backwards) using src contxt
@@ -130,8 +127,7 @@ void DeviceToDeviceBidirReadSM::run(unsigned long long size, unsigned long long
         }
     }
 
-    std::cout << "memcpy SM GPU(row) -> GPU(column) bandwidth (GB/s)" << std::endl;
-    std::cout << std::fixed << std::setprecision(2) << bandwidthValues << std::endl;
+    output->addTestcaseResults(bandwidthValues, "memcpy SM GPU(row) -> GPU(column) bandwidth (GB/s)");
 }
 
 // DtoD Bidir Write test - copy from src to dst using src context
@@ -159,8 +155,7 @@ void DeviceToDeviceBidirWriteSM::run(unsigned long long size, unsigned long long
         }
     }
 
-    std::cout << "memcpy SM GPU(row) <- GPU(column) bandwidth (GB/s)" << std::endl;
-    std::cout << std::fixed << std::setprecision(2) << bandwidthValues << std::endl;
+    output->addTestcaseResults(bandwidthValues, "memcpy SM GPU(row) <- GPU(column) bandwidth (GB/s)");
 }
 
 void AllToHostSM::run(unsigned long long size, unsigned long long loopCount) {
@@ -169,8 +164,7 @@ void AllToHostSM::run(unsigned long long size, unsigned long long loopCount) {
 
     allHostHelper(size, memcpyInstance, bandwidthValues, false);
 
-    std::cout << "memcpy SM CPU(row) <- GPU(column) bandwidth (GB/s)" << std::endl;
-    std::cout << std::fixed << std::setprecision(2) << bandwidthValues << std::endl;
+    output->addTestcaseResults(bandwidthValues, "memcpy SM CPU(row) <- GPU(column) bandwidth (GB/s)");
 }
 
 void AllToHostBidirSM::run(unsigned long long size, unsigned long long loopCount) {
@@ -179,8 +173,7 @@ void AllToHostBidirSM::run(unsigned long long size, unsigned long long loopCount
 
     allHostBidirHelper(size, memcpyInstance, bandwidthValues, false);
 
-    std::cout << "memcpy SM CPU(row) <- GPU(column) bandwidth (GB/s)" << std::endl;
-    std::cout << std::fixed << std::setprecision(2) << bandwidthValues << std::endl;
+    output->addTestcaseResults(bandwidthValues, "memcpy SM CPU(row) <- GPU(column) bandwidth (GB/s)");
 }
 
 void HostToAllSM::run(unsigned long long size, unsigned long long loopCount) {
@@ -189,8 +182,7 @@ void HostToAllSM::run(unsigned long long size, unsigned long long loopCount) {
 
     allHostHelper(size, memcpyInstance, bandwidthValues, true);
 
-    std::cout << "memcpy SM CPU(row) -> GPU(column) bandwidth (GB/s)" << std::endl;
-    std::cout << std::fixed << std::setprecision(2) << bandwidthValues << std::endl;
+    output->addTestcaseResults(bandwidthValues, "memcpy SM CPU(row) -> GPU(column) bandwidth (GB/s)");
 }
 
 void HostToAllBidirSM::run(unsigned long long size, unsigned long long loopCount) {
@@ -199,8 +191,7 @@ void HostToAllBidirSM::run(unsigned long long size, unsigned long long loopCount
 
     allHostBidirHelper(size, memcpyInstance, bandwidthValues, true);
 
-    std::cout << "memcpy SM CPU(row) -> GPU(column) bandwidth (GB/s)" << std::endl;
-    std::cout << std::fixed << std::setprecision(2) << bandwidthValues << std::endl;
+    output->addTestcaseResults(bandwidthValues, "memcpy SM CPU(row) -> GPU(column) bandwidth (GB/s)");
 }
 
 // Write test - copy from src to dst using src context
@@ -209,8 +200,7 @@ void AllToOneWriteSM::run(unsigned long long size, unsigned long long loopCount)
     MemcpyOperationSM memcpyInstance(loopCount, MemcpyOperation::PREFER_SRC_CONTEXT, MemcpyOperation::TOTAL_BW);
     allToOneHelper(size, memcpyInstance, bandwidthValues, false);
 
-    std::cout << "memcpy SM All Gpus -> GPU(column) total bandwidth (GB/s)" << std::endl;
-    std::cout << std::fixed << std::setprecision(2) << bandwidthValues << std::endl;
+    output->addTestcaseResults(bandwidthValues, "memcpy SM All Gpus -> GPU(column) total bandwidth (GB/s)");
 }
 
 // Read test - copy from dst to src (backwards) using src contxt
@@ -219,8 +209,7 @@ void AllToOneReadSM::run(unsigned long long size, unsigned long long loopCount)
     MemcpyOperationSM memcpyInstance(loopCount, MemcpyOperation::PREFER_DST_CONTEXT, MemcpyOperation::TOTAL_BW);
     allToOneHelper(size, memcpyInstance, bandwidthValues, true);
 
-    std::cout << "memcpy SM All GPUs <- GPU(column) total bandwidth (GB/s)" << std::endl;
-    std::cout << std::fixed << std::setprecision(2) << bandwidthValues << std::endl;
+    output->addTestcaseResults(bandwidthValues, "memcpy SM All GPUs <- GPU(column) total bandwidth (GB/s)");
 }
 
 // Write test - copy from src to dst using src context
@@ -229,8 +218,7 @@ void OneToAllWriteSM::run(unsigned long long size, unsigned long long loopCount)
     MemcpyOperationSM memcpyInstance(loopCount, MemcpyOperation::PREFER_SRC_CONTEXT, MemcpyOperation::TOTAL_BW);
     oneToAllHelper(size, memcpyInstance, bandwidthValues, false);
 
-    std::cout << "memcpy SM GPU(column) -> All GPUs total bandwidth (GB/s)" << std::endl;
-    std::cout << std::fixed << std::setprecision(2) << bandwidthValues << std::endl;
+    output->addTestcaseResults(bandwidthValues, "memcpy SM GPU(column) -> All GPUs total bandwidth (GB/s)");
 }
 
 // Read test - copy from dst to src (backwards) using src contxt
@@ -239,6 +227,108 @@ void OneToAllReadSM::run(unsigned long long size, unsigned long long loopCount)
     MemcpyOperationSM memcpyInstance(loopCount, MemcpyOperation::PREFER_DST_CONTEXT, MemcpyOperation::TOTAL_BW);
     oneToAllHelper(size, memcpyInstance, bandwidthValues, true);
 
-    std::cout << "memcpy SM GPU(column) <- All GPUs total bandwidth (GB/s)" << std::endl;
-    std::cout << std::fixed << std::setprecision(2) << bandwidthValues << std::endl;
+    output->addTestcaseResults(bandwidthValues, "memcpy SM GPU(column) <- All GPUs total bandwidth (GB/s)");
+}
+
+// Write test - copy from src to dst using src context
+void AllToAllSM::run(unsigned long long size, unsigned long long loopCount) {
+    PeerValueMatrix<double> linkBandwidthValues(deviceCount, deviceCount, key);
+    PeerValueMatrix<double> totalBandwidthValues(1, 1, key);
+    MemcpyOperationSM memcpyInstance(loopCount, MemcpyOperation::PREFER_SRC_CONTEXT, MemcpyOperation::TOTAL_BW);
+    allToAllHelper(size, memcpyInstance, linkBandwidthValues, totalBandwidthValues);
+
+    output->addTestcaseResults(linkBandwidthValues, "memcpy SM GPU(row) -> GPU(column) per link bandwidth during all to all (GB/s)");
+    output->addTestcaseResults(totalBandwidthValues, "memcpy SM All GPUs -> All GPUs total bandwidth (GB/s)");
+}
+
+void DeviceLocalMemorySM::run(unsigned long long size, unsigned long long loopCount) {
+    PeerValueMatrix<double> bandwidthValues(3, deviceCount, key);
+    bandwidthValues.rowLabels = {"read", "write", "copy"};
+    MemcpyOperationSMRead readInstance(loopCount);
+    MemcpyOperationSMWrite writeInstance(loopCount);
+    MemcpyOperationSM copyInstance(loopCount);
+
+    for (int deviceId = 0; deviceId < deviceCount; deviceId++) {
+        DeviceNode srcNode(size, deviceId);
+        DeviceNode dstNode(size, deviceId);
+
+        bandwidthValues.value(0, deviceId) = readInstance.doMemcpy(srcNode, dstNode);
+        bandwidthValues.value(1, deviceId) = writeInstance.doMemcpy(srcNode, dstNode);
+        bandwidthValues.value(2, deviceId) = copyInstance.doMemcpy(srcNode, dstNode);
+    }
+
+    output->addTestcaseResults(bandwidthValues, "local memory SM kernel(row) bandwidth of GPU(column) (GB/s)");
+}
+
+// Reads run on the device from the host buffer into the device's sink, writes run on the device into the host buffer
+void HostDeviceReadWriteSM::run(unsigned long long size, unsigned long long loopCount) {
+    PeerValueMatrix<double> readValues(1, deviceCount, key);
+    PeerValueMatrix<double> writeValues(1, deviceCount, key);
+    MemcpyOperationSMRead readInstance(loopCount);
+    MemcpyOperationSMWrite writeInstance(loopCount);
+
+    for (int deviceId = 0; deviceId < deviceCount; deviceId++) {
+        HostNode hostNode(size, deviceId);
+        DeviceNode deviceNode(size, deviceId);
+
+        readValues.value(0, deviceId) = readInstance.doMemcpy(hostNode, deviceNode);
+        writeValues.value(0, deviceId) = writeInstance.doMemcpy(deviceNode, hostNode);
+    }
+
+    output->addTestcaseResults(readValues, "read SM GPU(column) <- CPU(row) bandwidth (GB/s)");
+    output->addTestcaseResults(writeValues, "write SM GPU(column) -> CPU(row) bandwidth (GB/s)");
+}
+
+void DeviceToDeviceReadWriteSM::run(unsigned long long size, unsigned long long loopCount) {
+    PeerValueMatrix<double> readValues(deviceCount, deviceCount, key);
+    PeerValueMatrix<double> writeValues(deviceCount, deviceCount, key);
+    MemcpyOperationSMRead readInstance(loopCount);
+    MemcpyOperationSMWrite writeInstance(loopCount);
+
+    for (int srcDeviceId = 0; srcDeviceId < deviceCount; srcDeviceId++) {
+        for (int peerDeviceId = 0; peerDeviceId < deviceCount; peerDeviceId++) {
+            if (peerDeviceId == srcDeviceId) {
+                continue;
+            }
+
+            DeviceNode srcNode(size, srcDeviceId);
+            DeviceNode peerNode(size, peerDeviceId);
+
+            if (!srcNode.enablePeerAcess(peerNode)) {
+                continue;
+            }
+
+            // both kernels run in srcNode's context, reading the peer into srcNode or filling the peer
+            readValues.value(srcDeviceId, peerDeviceId) = readInstance.doMemcpy(peerNode, srcNode);
+            writeValues.value(srcDeviceId, peerDeviceId) = writeInstance.doMemcpy(srcNode, peerNode);
+        }
+    }
+
+    output->addTestcaseResults(readValues, "read SM GPU(row) <- GPU(column) bandwidth (GB/s)");
+    output->addTestcaseResults(writeValues, "write SM GPU(row) -> GPU(column) bandwidth (GB/s)");
+}
+
+void HostDeviceAccessSweepSM::run(unsigned long long size, unsigned long long loopCount) {
+    for (int deviceId = 0; deviceId < deviceCount; deviceId++) {
+        HostNode hostNode(size, deviceId);
+        DeviceNode deviceNode(size, deviceId);
+
+        accessSweepHelper(loopCount, hostNode, deviceNode, "GPU " + std::to_string(deviceId) + " <- CPU");
+    }
+}
+
+// Each device reads the first accessible peer after it, wrapping around, so every device's links are covered once
+void DeviceToDeviceAccessSweepSM::run(unsigned long long size, unsigned long long loopCount) {
+    for (int deviceId = 0; deviceId < deviceCount; deviceId++) {
+        for (int offset = 1; offset < deviceCount; offset++) {
+            int peerDeviceId = (deviceId + offset) % deviceCount;
+            DeviceNode deviceNode(size, deviceId);
+            DeviceNode peerNode(size, peerDeviceId);
+
+            if (deviceNode.enablePeerAcess(peerNode)) {
+                accessSweepHelper(loopCount, peerNode, deviceNode, "GPU " + std::to_string(deviceId) + " <- GPU " + std::to_string(peerDeviceId));
+                break;
+            }
+        }
+    }
 }
@@ -0,0 +1,241 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <hip/hip_runtime.h>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <map>
+#include <sstream>
+
+#include "common.h"
+#include "topology.h"
+
+static const std::string kfdNodesPath = "/sys/class/kfd/kfd/topology/nodes/";
+// GT/s per lane of each PCIe generation
+static const std::vector<double> pcieSpeeds = {2.5, 5.0, 8.0, 16.0, 32.0, 64.0};
+
+// Key value pairs of a KFD topology properties file
+static std::map<std::string, unsigned long long> readProperties(const std::string &path) {
+    std::map<std::string, unsigned long long> properties;
+    std::ifstream file(path);
+    std::string key;
+    unsigned long long value;
+    while (file >> key >> value) {
+        properties[key] = value;
+    }
+    return properties;
+}
+
+static std::string devicePciPath(int deviceId) {
+    char busId[64];
+    CU_ASSERT(hipDeviceGetPCIBusId(busId, sizeof(busId), deviceId));
+    std::string path = std::string("/sys/bus/pci/devices/") + busId + "/";
+    for (char &c : path) {
+        c = tolower(c);
+    }
+    return path;
+}
+
+void getPcieLink(int deviceId, int &generation, int &width) {
+    std::string path = devicePciPath(deviceId);
+    double speed = 0.0;
+    generation = 0;
+    width = 0;
+    std::ifstream(path + "current_link_speed") >> speed;
+    std::ifstream(path + "current_link_width") >> width;
+    for (size_t gen = 0; gen < pcieSpeeds.size(); gen++) {
+        if (speed >= pcieSpeeds[gen] - 0.1) {
+            generation = gen + 1;
+        }
+    }
+}
+
+// Bytes/s of one direction of the device's PCIe link, 8b/10b encoded up to gen 2 and 128b/130b from gen 3
+static double pciePeak(int deviceId) {
+    int generation, width;
+    getPcieLink(deviceId, generation, width);
+    if (generation == 0 || width == 0) {
+        return 0.0;
+    }
+    double encoding = generation <= 2 ? 8.0 / 10.0 : 128.0 / 130.0;
+    return pcieSpeeds[generation - 1] * 1e9 * width * encoding / 8.0;
+}
+
+// Largest KFD link bandwidth between the endpoints in MB/s, keyed by (src, dst) with TOPOLOGY_HOST for CPU nodes
+static const std::map<std::pair<int, int>, unsigned long long> &kfdBandwidths() {
+    static std::map<std::pair<int, int>, unsigned long long> bandwidths;
+    static bool probed = false;
+    if (probed) {
+        return bandwidths;
+    }
+    probed = true;
+
+    // KFD nodes are GPUs matched by PCI location, or CPUs without SIMDs
+    std::map<unsigned long long, int> devicesByLocation;
+    for (int deviceId = 0; deviceId < deviceCount; deviceId++) {
+        char busId[64];
+        unsigned int domain, bus, device, function;
+        CU_ASSERT(hipDeviceGetPCIBusId(busId, sizeof(busId), deviceId));
+        if (sscanf(busId, "%x:%x:%x.%x", &domain, &bus, &device, &function) == 4) {
+            devicesByLocation[((unsigned long long)domain << 16) | (bus << 8) | (device << 3) | function] = deviceId;
+        }
+    }
+    std::map<unsigned long long, int> endpoints;
+    for (unsigned long long node = 0; ; node++) {
+        std::map<std::string, unsigned long long> properties = readProperties(kfdNodesPath + std::to_string(node) + "/properties");
+        if (properties.empty()) {
+            break;
+        }
+        if (properties["simd_count"] == 0) {
+            endpoints[node] = TOPOLOGY_HOST;
+            continue;
+        }
+        auto device = devicesByLocation.find((properties["domain"] << 16) | properties["location_id"]);
+        if (device != devicesByLocation.end()) {
+            endpoints[node] = device->second;
+        }
+    }
+
+    for (const auto &endpoint : endpoints) {
+        // direct links, and the indirect peer links of newer kernels
+        for (const char *links : {"/io_links/", "/p2p_links/"}) {
+            for (int link = 0; ; link++) {
+                std::map<std::string, unsigned long long> properties =
+                    readProperties(kfdNodesPath + std::to_string(endpoint.first) + links + std::to_string(link) + "/properties");
+                if (properties.empty()) {
+                    break;
+                }
+                auto to = endpoints.find(properties["node_to"]);
+                if (to == endpoints.end() || to->second == endpoint.second) {
+                    continue;
+                }
+                unsigned long long &bandwidth = bandwidths[std::make_pair(endpoint.second, to->second)];
+                bandwidth = std::max(bandwidth, properties["max_bandwidth"]);
+            }
+        }
+    }
+    return bandwidths;
+}
+
+static LinkDescription probeLink(int src, int dst) {
+    LinkDescription link = {"unknown", -1, 0.0};
+    if (src == dst) {
+        link.type = "local";
+        link.hops = 0;
+        return link;
+    }
+
+    auto kfd = kfdBandwidths().find(std::make_pair(src, dst));
+    if (kfd != kfdBandwidths().end()) {
+        link.peakBandwidth = kfd->second * 1e6;
+    }
+
+    if (src == TOPOLOGY_HOST || dst == TOPOLOGY_HOST) {
+        int deviceId = src == TOPOLOGY_HOST ? dst : src;
+        int generation, width;
+        getPcieLink(deviceId, generation, width);
+        // hosts attached over XGMI report the link to their KFD CPU node only
+        link.type = link.peakBandwidth > 0.0 && generation == 0 ? "XGMI" : "PCIe";
+        link.hops = 1;
+        if (link.peakBandwidth == 0.0) {
+            link.peakBandwidth = pciePeak(deviceId);
+        }
+        return link;
+    }
+
+    uint32_t linkType = 0, hopCount = 0;
+    if (hipExtGetLinkTypeAndHopCount(src, dst, &linkType, &hopCount) == hipSuccess) {
+        link.type = linkTypeName(linkType);
+        link.hops = (int)hopCount;
+    }
+    // PCIe peers are limited by the slower of the two device links
+    if (link.peakBandwidth == 0.0 && link.type == "PCIe") {
+        link.peakBandwidth = std::min(pciePeak(src), pciePeak(dst));
+    }
+    return link;
+}
+
+const LinkDescription &getLink(int src, int dst) {
+    static std::map<std::pair<int, int>, LinkDescription> links;
+    auto key = std::make_pair(src, dst);
+    auto it = links.find(key);
+    if (it == links.end()) {
+        it = links.emplace(key, probeLink(src, dst)).first;
+    }
+    return it->second;
+}
+
+// Labelled table of the host and devices, for values the result matrices can't hold
+static void printTable(const std::string &title, const std::vector<std::string> &labels, const std::function<std::string(int, int)> &cell) {
+    std::cout << title << ", src(row) -> dst(column):" << std::endl;
+    std::cout << "   ";
+    for (const std::string &label : labels) {
+        std::cout << std::setw(10) << label;
+    }
+    std::cout << std::endl;
+    for (int row = 0; row < labels.size(); row++) {
+        std::cout << std::setw(3) << std::left << labels[row] << std::right;
+        for (int column = 0; column < labels.size(); column++) {
+            // the host has no link to itself
+            std::cout << std::setw(10) << (row == 0 && column == 0 ? "N/A" : cell(row - 1, column - 1));
+        }
+        std::cout << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+void printTopology() {
+    // host first, then the devices
+    std::vector<std::string> labels = {"CPU"};
+    for (int deviceId = 0; deviceId < deviceCount; deviceId++) {
+        labels.push_back(std::to_string(deviceId));
+    }
+
+    printTable("Link types", labels, [](int src, int dst) { return getLink(src, dst).type; });
+    printTable("Hop counts", labels, [](int src, int dst) {
+        int hops = getLink(src, dst).hops;
+        return hops < 0 ? std::string("N/A") : std::to_string(hops);
+    });
+
+    bool pcieReported = false;
+    for (int deviceId = 0; deviceId < deviceCount; deviceId++) {
+        int generation, width;
+        getPcieLink(deviceId, generation, width);
+        if (generation > 0) {
+            std::cout << "Device " << deviceId << ": PCIe Gen" << generation << " x" << width << std::endl;
+            pcieReported = true;
+        }
+    }
+    if (pcieReported) {
+        std::cout << std::endl;
+    }
+
+    PeerValueMatrix<double> peakValues(deviceCount + 1, deviceCount + 1, "link_peak_bandwidth");
+    peakValues.rowLabels = labels;
+    peakValues.columnLabels = labels;
+    for (int row = 0; row <= deviceCount; row++) {
+        for (int column = 0; column <= deviceCount; column++) {
+            double peakBandwidth = getLink(row - 1, column - 1).peakBandwidth;
+            if (peakBandwidth > 0.0 && !(row == 0 && column == 0)) {
+                peakValues.value(row, column) = peakBandwidth * 1e-9;
+            }
+        }
+    }
+    std::cout << "Peak link bandwidth, src(row) -> dst(column) (GB/s):" << std::endl << std::fixed << std::setprecision(2) << peakValues << std::endl;
+}
@@ -0,0 +1,44 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+
+#include <string>
+
+// Endpoint index of host memory in the topology queries, devices use their HIP index
+const int TOPOLOGY_HOST = -1;
+
+// Discovered link between two endpoints of a copy
+struct LinkDescription {
+    std::string type;       // PCIe, XGMI, ... as reported by hipExtGetLinkTypeAndHopCount, "local" within a device
+    int hops;               // -1 if unknown
+    // Theoretical bandwidth of one direction in bytes/s, 0 if unknown. KFD topology link bandwidths are preferred,
+    // PCIe links fall back to the negotiated speed and width of the devices' PCIe links
+    double peakBandwidth;
+};
+
+// Link from src to dst, either can be TOPOLOGY_HOST. Probed from HIP, the KFD topology and PCIe sysfs on first use
+const LinkDescription &getLink(int src, int dst);
+// PCIe generation and width of the device's link, 0 if sysfs doesn't report them
+void getPcieLink(int deviceId, int &generation, int &width);
+
+// Prints the link type, hop count and peak bandwidth matrices of the host and all devices
+void printTopology();
+
+#endif